@@ -39,9 +39,20 @@
 #include "gpk-dialog.h"
 #include "gpk-enum.h"
 #include "gpk-error.h"
+#include "gpk-file-list.h"
 #include "gpk-task.h"
 #include "gpk-debug.h"
 
+/* number of searches we keep the results of */
+#define GPK_APPLICATION_SEARCH_CACHE_MAX	16
+
+/* number of results added to the package list in one go */
+#define GPK_APPLICATION_PAGE_SIZE		200
+
+/* the most used groups are fetched in the background, one at a time */
+#define GPK_APPLICATION_PREFETCH_GROUPS		3
+#define GPK_APPLICATION_PREFETCH_DELAY		10 /* seconds */
+
 typedef enum {
 	GPK_SEARCH_NAME,
 	GPK_SEARCH_DETAILS,
@@ -57,22 +68,31 @@ typedef enum {
 	GPK_MODE_UNKNOWN
 } GpkSearchMode;
 
-typedef enum {
-	GPK_ACTION_NONE,
-	GPK_ACTION_INSTALL,
-	GPK_ACTION_REMOVE,
-	GPK_ACTION_UNKNOWN
-} GpkActionMode;
-
 typedef struct {
 	gboolean		 has_package;
+	gboolean		 has_properties;
+	gboolean		 is_interactive;
 	gboolean		 search_in_progress;
 	GCancellable		*cancellable;
 	gchar			*homepage_url;
 	gchar			*search_group;
 	gchar			*search_text;
 	GHashTable		*repos;
-	GpkActionMode		 action;
+	GHashTable		*depends_cache;	/* role|filters|package_id -> GPtrArray of PkPackage */
+	GHashTable		*search_cache;	/* mode|type|filters|terms -> GPtrArray of PkPackage */
+	GQueue			*search_cache_keys; /* least recently used first */
+	gchar			*search_key;	/* for the search in progress */
+	GPtrArray		*page_array;	/* results still being added */
+	guint			 page_offset;
+	gboolean		 page_descending; /* add from the end of page_array */
+	guint			 page_id;
+	GHashTable		*group_usage;	/* group id -> times shown */
+	PkClient		*prefetch_client;
+	GCancellable		*prefetch_cancellable; /* only set when prefetching */
+	gchar			*prefetch_key;
+	gchar			*prefetch_tid;
+	gchar			**prefetch_tids; /* running when the search was sent */
+	guint			 prefetch_id;
 	GpkSearchMode		 search_mode;
 	GpkSearchType		 search_type;
 	GtkApplication		*application;
@@ -80,35 +100,28 @@ typedef struct {
 	GtkBuilder		*builder;
 	GtkListStore		*packages_store;
 	GtkTreeStore		*groups_store;
+	gboolean		 apply_busy;
+	gchar			**apply_install_ids;	/* sent once the removal is done */
 	guint			 details_event_id;
+	guint			 simulate_pending;
+	gboolean		 simulate_failed;
 	guint			 status_id;
 	PkBitfield		 filters_current;
 	PkBitfield		 groups;
 	PkBitfield		 roles;
 	PkControl		*control;
-	PkPackageSack		*package_sack;
+	PkPackageSack		*package_sack;	/* installs are AVAILABLE, removals INSTALLED */
+	GHashTable		*package_queue;	/* package_id -> PkPackage in package_sack */
+	GHashTable		*queue_rows;	/* package_id -> GArray of GtkTreeIter in packages_store */
+	PkPackageSack		*simulate_sack;
+	PkPackageSack		*simulate_install;	/* what the install half pulled in */
+	PkResults		*categories;	/* waiting for the properties */
+	guint			 categories_trace;
 	PkStatusEnum		 status_last;
 	PkTask			*task;
+	PkTask			*apply_task;	/* never simulates, the queue is confirmed first */
 } GpkApplicationPrivate;
 
-enum {
-	GPK_STATE_INSTALLED,
-	GPK_STATE_IN_LIST,
-	GPK_STATE_COLLECTION,
-	GPK_STATE_UNKNOWN
-};
-
-enum {
-	PACKAGES_COLUMN_IMAGE,
-	PACKAGES_COLUMN_STATE,  /* state of the item */
-	PACKAGES_COLUMN_CHECKBOX,  /* what we show in the checkbox */
-	PACKAGES_COLUMN_CHECKBOX_VISIBLE, /* visible */
-	PACKAGES_COLUMN_TEXT,
-	PACKAGES_COLUMN_ID,
-	PACKAGES_COLUMN_SUMMARY,
-	PACKAGES_COLUMN_LAST
-};
-
 enum {
 	GROUPS_COLUMN_ICON,
 	GROUPS_COLUMN_NAME,
@@ -118,10 +131,28 @@ enum {
 	GROUPS_COLUMN_LAST
 };
 
+enum {
+	DEPENDS_COLUMN_ICON,
+	DEPENDS_COLUMN_TEXT,
+	DEPENDS_COLUMN_ID,	/* NULL for the placeholder */
+	DEPENDS_COLUMN_LOADED,
+	DEPENDS_COLUMN_LAST
+};
+
+typedef struct {
+	GpkApplicationPrivate	*priv;
+	PkRoleEnum		 role;
+	gchar			*key;
+	gchar			*package_id;
+	GtkTreeStore		*store;		/* NULL for the top level */
+	GtkTreeRowReference	*row;
+	GpkTraceRequest		*trace;
+} GpkApplicationDepends;
+
 static void gpk_application_perform_search (GpkApplicationPrivate *priv);
+static void gpk_application_prefetch_schedule (GpkApplicationPrivate *priv);
+static void gpk_application_install_simulate (GpkApplicationPrivate *priv);
 
-static void gpk_application_get_requires_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv);
-static void gpk_application_get_depends_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv);
 
 static gboolean
 _g_strzero (const gchar *text)
@@ -133,52 +164,6 @@ _g_strzero (const gchar *text)
 	return FALSE;
 }
 
-static const gchar *
-gpk_application_state_get_icon (PkBitfield state)
-{
-	if (state == 0)
-		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_AVAILABLE);
-
-	if (state == pk_bitfield_value (GPK_STATE_INSTALLED))
-		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_INSTALLED);
-
-	if (state == pk_bitfield_value (GPK_STATE_IN_LIST))
-		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_INSTALLING);
-
-	if (state == pk_bitfield_from_enums (GPK_STATE_INSTALLED, GPK_STATE_IN_LIST, -1))
-		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_REMOVING);
-
-	if (state == pk_bitfield_value (GPK_STATE_COLLECTION))
-		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_COLLECTION_AVAILABLE);
-
-	if (state == pk_bitfield_from_enums (GPK_STATE_INSTALLED, GPK_STATE_COLLECTION, -1))
-		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_COLLECTION_INSTALLED);
-
-	if (state == pk_bitfield_from_enums (GPK_STATE_IN_LIST, GPK_STATE_INSTALLED, GPK_STATE_COLLECTION, -1))
-		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_REMOVING); // need new icon
-
-	if (state == pk_bitfield_from_enums (GPK_STATE_IN_LIST, GPK_STATE_COLLECTION, -1))
-		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_INSTALLING); // need new icon
-
-	return NULL;
-}
-
-static gboolean
-gpk_application_state_get_checkbox (PkBitfield state)
-{
-	PkBitfield state_local;
-
-	/* remove any we don't care about */
-	state_local = state;
-	pk_bitfield_remove (state_local, GPK_STATE_COLLECTION);
-
-	/* installed or in array */
-	if (state_local == pk_bitfield_value (GPK_STATE_INSTALLED) ||
-	    state_local == pk_bitfield_value (GPK_STATE_IN_LIST))
-		return TRUE;
-	return FALSE;
-}
-
 static void
 gpk_application_set_text_buffer (GtkWidget *widget, const gchar *text)
 {
@@ -211,55 +196,49 @@ gpk_application_allow_remove (GpkApplicationPrivate *priv, gboolean allow)
 }
 
 static void
-gpk_application_packages_checkbox_invert (GpkApplicationPrivate *priv)
+gpk_application_packages_checkbox_set (GpkApplicationPrivate *priv, GtkTreeIter *iter, gboolean in_list)
 {
-	GtkTreeView *treeview;
-	GtkTreeModel *model;
-	GtkTreeIter iter;
-	GtkTreeSelection *selection;
 	PkBitfield state;
-	gboolean ret;
-	g_autofree gchar *package_id = NULL;
-
-	/* get the selection and add */
-	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_packages"));
-	selection = gtk_tree_view_get_selection (treeview);
-	ret = gtk_tree_selection_get_selected (selection, &model, &iter);
-	if (!ret) {
-		g_warning ("no selection");
-		return;
-	}
 
-	gtk_tree_model_get (model, &iter,
-			    PACKAGES_COLUMN_STATE, &state,
-			    PACKAGES_COLUMN_ID, &package_id,
+	gtk_tree_model_get (GTK_TREE_MODEL (priv->packages_store), iter,
+			    GPK_PACKAGES_COLUMN_STATE, &state,
 			    -1);
 
 	/* do something with the value */
-	pk_bitfield_invert (state, GPK_STATE_IN_LIST);
+	if (in_list)
+		pk_bitfield_add (state, GPK_PACKAGE_STATE_IN_LIST);
+	else
+		pk_bitfield_remove (state, GPK_PACKAGE_STATE_IN_LIST);
 
 	/* set new value */
-	gtk_list_store_set (GTK_LIST_STORE (model), &iter,
-			    PACKAGES_COLUMN_STATE, state,
-			    PACKAGES_COLUMN_CHECKBOX, gpk_application_state_get_checkbox (state),
-			    PACKAGES_COLUMN_IMAGE, gpk_application_state_get_icon (state),
+	gtk_list_store_set (priv->packages_store, iter,
+			    GPK_PACKAGES_COLUMN_STATE, state,
+			    GPK_PACKAGES_COLUMN_CHECKBOX, gpk_package_state_get_checkbox (state),
+			    GPK_PACKAGES_COLUMN_IMAGE, gpk_package_state_get_icon (state),
 			    -1);
 }
 
 static gboolean
-gpk_application_get_checkbox_enable (GpkApplicationPrivate *priv, PkBitfield state)
+gpk_application_state_can_install (PkBitfield state)
 {
-	gboolean enable_installed = TRUE;
-	gboolean enable_available = TRUE;
+	/* available, or installed and queued to be removed */
+	return pk_bitfield_contain (state, GPK_PACKAGE_STATE_INSTALLED) ==
+	       pk_bitfield_contain (state, GPK_PACKAGE_STATE_IN_LIST);
+}
 
-	if (priv->action == GPK_ACTION_INSTALL)
-		enable_installed = FALSE;
-	else if (priv->action == GPK_ACTION_REMOVE)
-		enable_available = FALSE;
+/* only succeeds when exactly one row is selected */
+static gboolean
+gpk_application_get_selected_iter (GtkTreeSelection *selection, GtkTreeModel **model, GtkTreeIter *iter)
+{
+	GList *rows;
+	gboolean ret;
 
-	if (pk_bitfield_contain (state, GPK_STATE_INSTALLED))
-		return enable_installed;
-	return enable_available;
+	if (gtk_tree_selection_count_selected_rows (selection) != 1)
+		return FALSE;
+	rows = gtk_tree_selection_get_selected_rows (selection, model);
+	ret = gtk_tree_model_get_iter (*model, iter, rows->data);
+	g_list_free_full (rows, (GDestroyNotify) gtk_tree_path_free);
+	return ret;
 }
 
 static gboolean
@@ -274,7 +253,7 @@ gpk_application_get_selected_package (GpkApplicationPrivate *priv, gchar **packa
 	/* get the selection and add */
 	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_packages"));
 	selection = gtk_tree_view_get_selection (treeview);
-	ret = gtk_tree_selection_get_selected (selection, &model, &iter);
+	ret = gpk_application_get_selected_iter (selection, &model, &iter);
 	if (!ret) {
 		g_warning ("no selection");
 		return FALSE;
@@ -283,17 +262,51 @@ gpk_application_get_selected_package (GpkApplicationPrivate *priv, gchar **packa
 	/* get data */
 	if (summary == NULL) {
 		gtk_tree_model_get (model, &iter,
-				    PACKAGES_COLUMN_ID, package_id,
+				    GPK_PACKAGES_COLUMN_ID, package_id,
 				    -1);
 	} else {
 		gtk_tree_model_get (model, &iter,
-				    PACKAGES_COLUMN_ID, package_id,
-				    PACKAGES_COLUMN_SUMMARY, summary,
+				    GPK_PACKAGES_COLUMN_ID, package_id,
+				    GPK_PACKAGES_COLUMN_SUMMARY, summary,
 				    -1);
 	}
 	return TRUE;
 }
 
+static void
+gpk_application_update_buttons_cb (GtkTreeModel *model, GtkTreePath *path,
+				   GtkTreeIter *iter, gpointer user_data)
+{
+	gboolean *show = user_data;
+	PkBitfield state;
+	g_autofree gchar *package_id = NULL;
+
+	gtk_tree_model_get (model, iter,
+			    GPK_PACKAGES_COLUMN_STATE, &state,
+			    GPK_PACKAGES_COLUMN_ID, &package_id,
+			    -1);
+	if (package_id == NULL)
+		return;
+	if (gpk_application_state_can_install (state))
+		show[0] = TRUE;
+	else
+		show[1] = TRUE;
+}
+
+static void
+gpk_application_update_buttons (GpkApplicationPrivate *priv)
+{
+	GtkTreeView *treeview;
+	gboolean show[2] = { FALSE, FALSE };	/* install, remove */
+
+	/* show a button if it applies to any of the selected packages */
+	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_packages"));
+	gtk_tree_selection_selected_foreach (gtk_tree_view_get_selection (treeview),
+					     gpk_application_update_buttons_cb, show);
+	gpk_application_allow_install (priv, show[0]);
+	gpk_application_allow_remove (priv, show[1]);
+}
+
 static void
 gpk_application_group_add_selected (GpkApplicationPrivate *priv)
 {
@@ -338,119 +351,183 @@ gpk_application_group_remove_selected (GpkApplicationPrivate *priv)
 	gtk_tree_store_remove (priv->groups_store, &iter);
 }
 
+static PkPackage *
+gpk_application_queue_lookup (GpkApplicationPrivate *priv, const gchar *package_id)
+{
+	return g_hash_table_lookup (priv->package_queue, package_id);
+}
+
+/* the store iters stay valid until the row is removed, even when sorted */
+static void
+gpk_application_queue_rows_add (GpkApplicationPrivate *priv, const gchar *package_id, GtkTreeIter *iter)
+{
+	GArray *rows;
+
+	rows = g_hash_table_lookup (priv->queue_rows, package_id);
+	if (rows == NULL) {
+		rows = g_array_new (FALSE, FALSE, sizeof (GtkTreeIter));
+		g_hash_table_insert (priv->queue_rows, g_strdup (package_id), rows);
+	}
+	g_array_append_val (rows, *iter);
+}
+
+static void
+gpk_application_queue_rows_reset (GpkApplicationPrivate *priv, const gchar *package_id)
+{
+	GArray *rows;
+	guint i;
+
+	rows = g_hash_table_lookup (priv->queue_rows, package_id);
+	if (rows == NULL)
+		return;
+	for (i = 0; i < rows->len; i++)
+		gpk_application_packages_checkbox_set (priv, &g_array_index (rows, GtkTreeIter, i), FALSE);
+	g_hash_table_remove (priv->queue_rows, package_id);
+}
+
+static void
+gpk_application_queue_add (GpkApplicationPrivate *priv, PkPackage *package, GtkTreeIter *iter)
+{
+	pk_package_sack_add_package (priv->package_sack, package);
+	g_hash_table_insert (priv->package_queue,
+			     g_strdup (pk_package_get_id (package)),
+			     g_object_ref (package));
+	gpk_application_packages_checkbox_set (priv, iter, TRUE);
+	gpk_application_queue_rows_add (priv, pk_package_get_id (package), iter);
+}
+
+static void
+gpk_application_queue_remove (GpkApplicationPrivate *priv, const gchar *package_id)
+{
+	pk_package_sack_remove_package_by_id (priv->package_sack, package_id);
+	gpk_application_queue_rows_reset (priv, package_id);
+	g_hash_table_remove (priv->package_queue, package_id);
+}
+
+static gboolean
+gpk_application_queue_filter_info_cb (PkPackage *package, gpointer user_data)
+{
+	return pk_package_get_info (package) != GPOINTER_TO_UINT (user_data);
+}
+
+static void
+gpk_application_queue_remove_info (GpkApplicationPrivate *priv, PkInfoEnum info)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	pk_package_sack_remove_by_filter (priv->package_sack,
+					  gpk_application_queue_filter_info_cb,
+					  GUINT_TO_POINTER (info));
+	g_hash_table_iter_init (&iter, priv->package_queue);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		if (pk_package_get_info (PK_PACKAGE (value)) != info)
+			continue;
+		gpk_application_queue_rows_reset (priv, key);
+		g_hash_table_iter_remove (&iter);
+	}
+}
+
+static void
+gpk_application_queue_clear (GpkApplicationPrivate *priv)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	/* only the rows that are queued need changing */
+	g_hash_table_iter_init (&iter, priv->queue_rows);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		GArray *rows = value;
+		guint i;
+		for (i = 0; i < rows->len; i++)
+			gpk_application_packages_checkbox_set (priv, &g_array_index (rows, GtkTreeIter, i), FALSE);
+	}
+	g_hash_table_remove_all (priv->queue_rows);
+	pk_package_sack_clear (priv->package_sack);
+	g_hash_table_remove_all (priv->package_queue);
+}
+
 static void
 gpk_application_change_queue_status (GpkApplicationPrivate *priv)
 {
 	GtkWidget *widget;
-	GtkTreeView *treeview;
-	gboolean valid;
-	GtkTreeIter iter;
-	GtkTreeModel *model;
-	PkBitfield state;
-	gboolean enabled;
 
 	/* show and hide the action widgets */
-	if (pk_package_sack_get_size (priv->package_sack) > 0) {
+	if (g_hash_table_size (priv->package_queue) > 0) {
 		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_apply"));
 		gtk_widget_show (widget);
 		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_clear"));
 		gtk_widget_show (widget);
 		gpk_application_group_add_selected (priv);
 	} else {
-		priv->action = GPK_ACTION_NONE;
 		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_apply"));
 		gtk_widget_hide (widget);
 		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_clear"));
 		gtk_widget_hide (widget);
 		gpk_application_group_remove_selected (priv);
 	}
+}
 
-	/* correct the enabled state */
-	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_packages"));
-	model = gtk_tree_view_get_model (treeview);
-	valid = gtk_tree_model_get_iter_first (model, &iter);
+static void
+gpk_application_queue_selected (GpkApplicationPrivate *priv, gboolean install)
+{
+	GtkTreeView *treeview;
+	GtkTreeModel *model;
+	GList *rows;
+	GList *l;
+	guint changed = 0;
 
-	/* for all current items, reset the state if in the array */
-	while (valid) {
+	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_packages"));
+	rows = gtk_tree_selection_get_selected_rows (gtk_tree_view_get_selection (treeview), &model);
+	for (l = rows; l != NULL; l = l->next) {
+		GtkTreeIter iter;
+		PkBitfield state;
 		g_autofree gchar *package_id = NULL;
+		g_autofree gchar *summary = NULL;
+
+		if (!gtk_tree_model_get_iter (model, &iter, l->data))
+			continue;
 		gtk_tree_model_get (model, &iter,
-				    PACKAGES_COLUMN_STATE, &state,
-				    PACKAGES_COLUMN_ID, &package_id,
+				    GPK_PACKAGES_COLUMN_STATE, &state,
+				    GPK_PACKAGES_COLUMN_ID, &package_id,
+				    GPK_PACKAGES_COLUMN_SUMMARY, &summary,
 				    -1);
 
-		/* we never show the checkbox for the search helper */
-		if (package_id == NULL) {
-			enabled = FALSE;
+		/* the search helper, or already added */
+		if (package_id == NULL)
+			continue;
+		if (gpk_application_state_can_install (state) != install)
+			continue;
+
+		/* changed mind, or add to the queue */
+		if (pk_bitfield_contain (state, GPK_PACKAGE_STATE_IN_LIST)) {
+			gpk_application_queue_remove (priv, package_id);
+			g_debug ("removed %s from package array", package_id);
 		} else {
-			enabled = gpk_application_get_checkbox_enable (priv, state);
+			g_autoptr(PkPackage) package = pk_package_new ();
+			pk_package_set_id (package, package_id, NULL);
+			g_object_set (package,
+				      "info", install ? PK_INFO_ENUM_AVAILABLE : PK_INFO_ENUM_INSTALLED,
+				      "summary", summary,
+				      NULL);
+			gpk_application_queue_add (priv, package, &iter);
 		}
-
-		/* set visible */
-		gtk_list_store_set (GTK_LIST_STORE (model), &iter, PACKAGES_COLUMN_CHECKBOX_VISIBLE, enabled, -1);
-		valid = gtk_tree_model_iter_next (model, &iter);
+		changed++;
 	}
+	g_list_free_full (rows, (GDestroyNotify) gtk_tree_path_free);
+	g_debug ("changed %u packages", changed);
+
+	/* correct buttons, and add the selected group if there are any
+	 * packages in the queue, once for the whole selection */
+	gpk_application_update_buttons (priv);
+	gpk_application_change_queue_status (priv);
 }
 
-static gboolean
+static void
 gpk_application_install (GpkApplicationPrivate *priv)
 {
-	gboolean ret;
-	g_autofree gchar *package_id_selected = NULL;
-	g_autofree gchar *summary_selected = NULL;
-	g_autoptr(PkPackage) package = NULL;
-
-	/* get selection */
-	ret = gpk_application_get_selected_package (priv, &package_id_selected, &summary_selected);
-	if (!ret) {
-		g_warning ("no package selected");
-		goto out;
-	}
-
-	/* changed mind, or wrong mode */
-	if (priv->action == GPK_ACTION_REMOVE) {
-		ret = pk_package_sack_remove_package_by_id (priv->package_sack, package_id_selected);
-		if (ret) {
-			g_debug ("removed %s from package array", package_id_selected);
-
-			/* correct buttons */
-			gpk_application_allow_install (priv, FALSE);
-			gpk_application_allow_remove (priv, TRUE);
-			gpk_application_packages_checkbox_invert (priv);
-			ret = TRUE;
-			goto out;
-		}
-		g_warning ("wrong mode and not in array");
-		ret = FALSE;
-		goto out;
-	}
-
-	/* already added */
-	package = pk_package_sack_find_by_id (priv->package_sack, package_id_selected);
-	if (package != NULL) {
-		g_warning ("already added");
-		goto out;
-	}
-
-	/* set mode */
-	priv->action = GPK_ACTION_INSTALL;
-
-	/* add to array */
-	package = pk_package_new ();
-	pk_package_set_id (package, package_id_selected, NULL);
-	g_object_set (package,
-		      "info", PK_INFO_ENUM_AVAILABLE,
-		      "summary", summary_selected,
-		      NULL);
-	pk_package_sack_add_package (priv->package_sack, package);
-
-	/* correct buttons */
-	gpk_application_allow_install (priv, FALSE);
-	gpk_application_allow_remove (priv, TRUE);
-	gpk_application_packages_checkbox_invert (priv);
-out:
-	/* add the selected group if there are any packages in the queue */
-	gpk_application_change_queue_status (priv);
-	return ret;
+	gpk_application_queue_selected (priv, TRUE);
 }
 
 static void
@@ -459,15 +536,11 @@ gpk_application_menu_homepage_cb (GtkAction *action, GpkApplicationPrivate *priv
 	gtk_show_uri_on_window (NULL, priv->homepage_url, GDK_CURRENT_TIME, NULL);
 }
 
-static gint
-gpk_application_strcmp_indirect (gchar **a, gchar **b)
-{
-	return strcmp (*a, *b);
-}
-
 static void
-gpk_application_get_files_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv)
+gpk_application_get_files_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
 {
+	g_autoptr(GpkTraceRequest) request = user_data;
+	GpkApplicationPrivate *priv = request->user_data;
 	gboolean ret;
 	g_auto(GStrv) files = NULL;
 	g_autofree gchar *package_id_selected = NULL;
@@ -488,6 +561,7 @@ gpk_application_get_files_cb (PkClient *client, GAsyncResult *res, GpkApplicatio
 		g_warning ("failed to get files: %s", error->message);
 		return;
 	}
+	gpk_trace_mark (request->token, GPK_TRACE_MARK_FINISHED);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -525,7 +599,7 @@ gpk_application_get_files_cb (PkClient *client, GAsyncResult *res, GpkApplicatio
 
 	/* convert to pointer array */
 	array_sort = pk_strv_to_ptr_array (files);
-	g_ptr_array_sort (array_sort, (GCompareFunc) gpk_application_strcmp_indirect);
+	gpk_file_list_sort (array_sort);
 
 	/* title */
 	split = pk_package_id_split (package_id_selected);
@@ -540,6 +614,8 @@ gpk_application_get_files_cb (PkClient *client, GAsyncResult *res, GpkApplicatio
 	gpk_dialog_embed_file_list_widget (GTK_DIALOG (dialog), array_sort);
 	gtk_window_set_resizable (GTK_WINDOW (dialog), TRUE);
 	gtk_window_set_default_size (GTK_WINDOW (dialog), 600, 250);
+	gtk_widget_show (dialog);
+	gpk_trace_end (request->token, dialog);
 
 	gtk_dialog_run (GTK_DIALOG (dialog));
 	gtk_widget_destroy (GTK_WIDGET (dialog));
@@ -570,13 +646,15 @@ gpk_application_status_changed_timeout_cb (GpkApplicationPrivate *priv)
 }
 
 static void
-gpk_application_progress_cb (PkProgress *progress, PkProgressType type, GpkApplicationPrivate *priv)
+gpk_application_progress_cb (PkProgress *progress, PkProgressType type, GpkTraceRequest *request)
 {
+	GpkApplicationPrivate *priv = request->user_data;
 	PkStatusEnum status;
 	gint percentage;
 	gboolean allow_cancel;
 	GtkWidget *widget;
 
+	gpk_trace_progress (request->token, type);
 	g_object_get (progress,
 		      "status", &status,
 		      "percentage", &percentage,
@@ -645,6 +723,7 @@ static void
 gpk_application_menu_files_cb (GtkAction *action, GpkApplicationPrivate *priv)
 {
 	gboolean ret;
+	GpkTraceRequest *request;
 	g_auto(GStrv) package_ids = NULL;
 	g_autofree gchar *package_id_selected = NULL;
 
@@ -660,68 +739,16 @@ gpk_application_menu_files_cb (GtkAction *action, GpkApplicationPrivate *priv)
 
 	/* set correct view */
 	package_ids = pk_package_ids_from_id (package_id_selected);
+	request = gpk_trace_request_new (PK_ROLE_ENUM_GET_FILES, priv);
 	pk_client_get_files_async (PK_CLIENT (priv->task), package_ids, priv->cancellable,
-				   (PkProgressCallback) gpk_application_progress_cb, priv,
-				   (GAsyncReadyCallback) gpk_application_get_files_cb, priv);
+				   (PkProgressCallback) gpk_application_progress_cb, request,
+				   (GAsyncReadyCallback) gpk_application_get_files_cb, request);
 }
 
-static gboolean
+static void
 gpk_application_remove (GpkApplicationPrivate *priv)
 {
-	gboolean ret;
-	g_autofree gchar *package_id_selected = NULL;
-	g_autofree gchar *summary_selected = NULL;
-	g_autoptr(PkPackage) package = NULL;
-
-	/* get selection */
-	ret = gpk_application_get_selected_package (priv, &package_id_selected, &summary_selected);
-	if (!ret) {
-		g_warning ("no package selected");
-		goto out;
-	}
-
-	/* changed mind, or wrong mode */
-	if (priv->action == GPK_ACTION_INSTALL) {
-		ret = pk_package_sack_remove_package_by_id (priv->package_sack, package_id_selected);
-		if (ret) {
-			g_debug ("removed %s from package array", package_id_selected);
-
-			/* correct buttons */
-			gpk_application_allow_install (priv, TRUE);
-			gpk_application_allow_remove (priv, FALSE);
-			gpk_application_packages_checkbox_invert (priv);
-			ret = TRUE;
-			goto out;
-		}
-		g_warning ("wrong mode and not in array");
-		ret = FALSE;
-		goto out;
-	}
-
-	/* already added */
-	ret = (pk_package_sack_find_by_id (priv->package_sack, package_id_selected) == NULL);
-	if (!ret) {
-		g_warning ("already added");
-		goto out;
-	}
-
-	priv->action = GPK_ACTION_REMOVE;
-	package = pk_package_new ();
-	pk_package_set_id (package, package_id_selected, NULL);
-	g_object_set (package,
-		      "info", PK_INFO_ENUM_INSTALLED,
-		      "summary", summary_selected,
-		      NULL);
-	pk_package_sack_add_package (priv->package_sack, package);
-
-	/* correct buttons */
-	gpk_application_allow_install (priv, TRUE);
-	gpk_application_allow_remove (priv, FALSE);
-	gpk_application_packages_checkbox_invert (priv);
-out:
-	/* add the selected group if there are any packages in the queue */
-	gpk_application_change_queue_status (priv);
-	return TRUE;
+	gpk_application_queue_selected (priv, FALSE);
 }
 
 static void
@@ -737,139 +764,209 @@ gpk_application_menu_remove_cb (GtkAction *action, GpkApplicationPrivate *priv)
 }
 
 static void
-gpk_application_get_requires_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv)
+gpk_application_depends_free (GpkApplicationDepends *depends)
 {
-	g_autoptr(PkResults) results = NULL;
-	g_autoptr(GError) error = NULL;
-	g_autoptr(PkError) error_code = NULL;
-	g_autoptr(GPtrArray) array = NULL;
+	g_free (depends->key);
+	g_free (depends->package_id);
+	if (depends->row != NULL)
+		gtk_tree_row_reference_free (depends->row);
+	if (depends->store != NULL)
+		g_object_unref (depends->store);
+	gpk_trace_request_free (depends->trace);
+	g_free (depends);
+}
+
+static void
+gpk_application_depends_add_packages (GpkApplicationPrivate *priv,
+				      GtkTreeStore *store,
+				      GtkTreeIter *parent,
+				      GPtrArray *array)
+{
+	GtkTreeIter iter;
+	GtkTreeIter placeholder;
+	GtkWidget *widget;
+	guint i;
+
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "window_manager"));
+	for (i = 0; i < array->len; i++) {
+		PkPackage *item = g_ptr_array_index (array, i);
+		g_autofree gchar *text = NULL;
+
+		text = gpk_package_id_format_twoline (gtk_widget_get_style_context (widget),
+						      pk_package_get_id (item),
+						      pk_package_get_summary (item));
+		gtk_tree_store_append (store, &iter, parent);
+		gtk_tree_store_set (store, &iter,
+				    DEPENDS_COLUMN_ICON, gpk_info_enum_to_icon_name (pk_package_get_info (item)),
+				    DEPENDS_COLUMN_TEXT, text,
+				    DEPENDS_COLUMN_ID, pk_package_get_id (item),
+				    DEPENDS_COLUMN_LOADED, FALSE,
+				    -1);
+
+		/* so the row can be expanded before we know what is below */
+		gtk_tree_store_append (store, &placeholder, &iter);
+		gtk_tree_store_set (store, &placeholder,
+				    /* TRANSLATORS: shown until the packages below this one are known */
+				    DEPENDS_COLUMN_TEXT, _("Loading…"),
+				    -1);
+	}
+}
+
+static gboolean
+gpk_application_depends_test_expand_row_cb (GtkTreeView *treeview,
+					    GtkTreeIter *iter,
+					    GtkTreePath *path,
+					    GpkApplicationPrivate *priv);
+
+static void
+gpk_application_depends_show (GpkApplicationDepends *depends, GPtrArray *array)
+{
+	GpkApplicationPrivate *priv = depends->priv;
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
 	GtkWindow *window;
+	GtkWidget *dialog;
+	GtkWidget *scroll;
+	GtkWidget *widget;
 	g_autofree gchar *name = NULL;
 	g_autofree gchar *title = NULL;
 	g_autofree gchar *message = NULL;
 	g_auto(GStrv) package_ids = NULL;
-	GtkWidget *dialog;
-	g_autofree gchar *package_id_selected = NULL;
-	gboolean ret;
+	g_autoptr(GtkTreeStore) store = NULL;
 
-	/* get the results */
-	results = pk_client_generic_finish (client, res, &error);
-	if (results == NULL) {
-		g_warning ("failed to get requires: %s", error->message);
+	/* empty array */
+	window = GTK_WINDOW (gtk_builder_get_object (priv->builder, "window_manager"));
+	if (array->len == 0) {
+		gpk_error_dialog_modal (window,
+					/* TRANSLATORS: no packages returned */
+					_("No packages"),
+					depends->role == PK_ROLE_ENUM_DEPENDS_ON ?
+					/* TRANSLATORS: this package does not depend on any others */
+					_("This package does not depend on any others") :
+					/* TRANSLATORS: this package is not required by any others */
+					_("No other packages require this package"), NULL);
 		return;
 	}
 
-	/* check error code */
-	error_code = pk_results_get_error_code (results);
-	if (error_code != NULL) {
-		g_warning ("failed to get requires: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+	package_ids = pk_package_ids_from_id (depends->package_id);
+	name = gpk_dialog_package_id_name_join_locale (package_ids);
+	if (depends->role == PK_ROLE_ENUM_DEPENDS_ON) {
+		/* TRANSLATORS: title: show the number of other packages we depend on */
+		title = g_strdup_printf (ngettext ("%u additional package is required for %s",
+						   "%u additional packages are required for %s",
+						   array->len), array->len, name);
+
+		/* TRANSLATORS: message: show the array of dependent packages for this package */
+		message = g_strdup_printf (ngettext ("Packages listed below are required for %s to function correctly.",
+						     "Packages listed below are required for %s to function correctly.",
+						     array->len), name);
+	} else {
+		/* TRANSLATORS: title: how many packages require this package */
+		title = g_strdup_printf (ngettext ("%u package requires %s",
+						   "%u packages require %s",
+						   array->len), array->len, name);
 
-		/* if obvious message, don't tell the user */
-		if (pk_error_get_code (error_code) != PK_ERROR_ENUM_TRANSACTION_CANCELLED) {
-			window = GTK_WINDOW (gtk_builder_get_object (priv->builder, "window_manager"));
-			gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
-						gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
-		}
-		return;
+		/* TRANSLATORS: show a array of packages for the package */
+		message = g_strdup_printf (ngettext ("Packages listed below require %s to function correctly.",
+						     "Packages listed below require %s to function correctly.",
+						     array->len), name);
 	}
 
-	/* get selection */
-	ret = gpk_application_get_selected_package (priv, &package_id_selected, NULL);
-	if (!ret) {
-		g_warning ("no package selected");
-		return;
-	}
-
-	/* get data */
-	array = pk_results_get_package_array (results);
-
-	/* empty array */
-	window = GTK_WINDOW (gtk_builder_get_object (priv->builder, "window_manager"));
-	if (array->len == 0) {
-		gpk_error_dialog_modal (window,
-					/* TRANSLATORS: no packages returned */
-					_("No packages"),
-					/* TRANSLATORS: this package is not required by any others */
-					_("No other packages require this package"), NULL);
-		return;
-	}
-
-	package_ids = pk_package_ids_from_id (package_id_selected);
-	name = gpk_dialog_package_id_name_join_locale (package_ids);
-	/* TRANSLATORS: title: how many packages require this package */
-	title = g_strdup_printf (ngettext ("%u package requires %s",
-					   "%u packages require %s",
-					   array->len), array->len, name);
-
-	/* TRANSLATORS: show a array of packages for the package */
-	message = g_strdup_printf (ngettext ("Packages listed below require %s to function correctly.",
-					     "Packages listed below require %s to function correctly.",
-					     array->len), name);
-
 	dialog = gtk_message_dialog_new (window, GTK_DIALOG_DESTROY_WITH_PARENT,
 					 GTK_MESSAGE_INFO, GTK_BUTTONS_OK, "%s", title);
 	gtk_window_set_resizable (GTK_WINDOW (dialog), TRUE);
 	gtk_message_dialog_format_secondary_markup (GTK_MESSAGE_DIALOG (dialog), "%s", message);
-	gpk_dialog_embed_package_list_widget (GTK_DIALOG (dialog), array);
+
+	/* each row is expanded with the same role when clicked */
+	store = gtk_tree_store_new (DEPENDS_COLUMN_LAST, G_TYPE_STRING, G_TYPE_STRING,
+				    G_TYPE_STRING, G_TYPE_BOOLEAN);
+	gpk_application_depends_add_packages (priv, store, NULL, array);
+	widget = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+	g_object_set_data (G_OBJECT (widget), "role", GUINT_TO_POINTER (depends->role));
+	gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (widget), FALSE);
+	column = gtk_tree_view_column_new ();
+	renderer = gtk_cell_renderer_pixbuf_new ();
+	g_object_set (renderer, "stock-size", GTK_ICON_SIZE_BUTTON, NULL);
+	gtk_tree_view_column_pack_start (column, renderer, FALSE);
+	gtk_tree_view_column_add_attribute (column, renderer, "icon-name", DEPENDS_COLUMN_ICON);
+	renderer = gtk_cell_renderer_text_new ();
+	gtk_tree_view_column_pack_start (column, renderer, TRUE);
+	gtk_tree_view_column_add_attribute (column, renderer, "markup", DEPENDS_COLUMN_TEXT);
+	gtk_tree_view_append_column (GTK_TREE_VIEW (widget), column);
+	g_signal_connect (widget, "test-expand-row",
+			  G_CALLBACK (gpk_application_depends_test_expand_row_cb), priv);
+	gtk_widget_show (widget);
+
+	/* scroll the treeview */
+	scroll = gtk_scrolled_window_new (NULL, NULL);
+	gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scroll), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+	gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scroll), GTK_SHADOW_IN);
+	gtk_container_add (GTK_CONTAINER (scroll), widget);
+	gtk_container_set_border_width (GTK_CONTAINER (scroll), 6);
+	gtk_widget_set_size_request (scroll, -1, 300);
+	gtk_widget_show (scroll);
+	widget = gtk_dialog_get_content_area (GTK_DIALOG (dialog));
+	gtk_box_pack_start (GTK_BOX (widget), scroll, TRUE, TRUE, 0);
+
+	gtk_widget_show (dialog);
+	gpk_trace_end (depends->trace->token, dialog);
 
 	gtk_dialog_run (GTK_DIALOG (dialog));
 	gtk_widget_destroy (GTK_WIDGET (dialog));
 }
 
 static void
-gpk_application_menu_requires_cb (GtkAction *action, GpkApplicationPrivate *priv)
+gpk_application_depends_done (GpkApplicationDepends *depends, GPtrArray *array)
 {
-	gboolean ret;
-	g_auto(GStrv) package_ids = NULL;
-	g_autofree gchar *package_id_selected = NULL;
+	GtkTreeIter iter;
+	GtkTreeIter placeholder;
+	g_autoptr(GtkTreePath) path = NULL;
 
-	/* get selection */
-	ret = gpk_application_get_selected_package (priv, &package_id_selected, NULL);
-	if (!ret) {
-		g_warning ("no package selected");
-		return;
+	/* the first level gets a new dialog */
+	if (depends->row == NULL) {
+		gpk_application_depends_show (depends, array);
+		goto out;
 	}
 
-	/* ensure new action succeeds */
-	g_cancellable_reset (priv->cancellable);
-
-	/* get the requires */
-	package_ids = pk_package_ids_from_id (package_id_selected);
+	/* the dialog has been closed, or the row has gone */
+	path = gtk_tree_row_reference_get_path (depends->row);
+	if (path == NULL)
+		goto out;
+	if (!gtk_tree_model_get_iter (GTK_TREE_MODEL (depends->store), &iter, path))
+		goto out;
 
-	pk_client_depends_on_async (PK_CLIENT (priv->task),
-				    pk_bitfield_value (PK_FILTER_ENUM_NONE),
-				    package_ids, TRUE, priv->cancellable,
-				    (PkProgressCallback) gpk_application_progress_cb, priv,
-				    (GAsyncReadyCallback) gpk_application_get_depends_cb, priv);
+	/* replace the placeholder */
+	if (gtk_tree_model_iter_children (GTK_TREE_MODEL (depends->store), &placeholder, &iter))
+		gtk_tree_store_remove (depends->store, &placeholder);
+	gpk_application_depends_add_packages (depends->priv, depends->store, &iter, array);
+	gpk_trace_end (depends->trace->token, NULL);
+out:
+	gpk_application_depends_free (depends);
 }
 
 static void
-gpk_application_get_depends_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv)
+gpk_application_depends_cb (PkClient *client, GAsyncResult *res, GpkApplicationDepends *depends)
 {
+	GpkApplicationPrivate *priv = depends->priv;
 	g_autoptr(PkResults) results = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(PkError) error_code = NULL;
 	g_autoptr(GPtrArray) array = NULL;
 	GtkWindow *window;
-	g_autofree gchar *name = NULL;
-	g_autofree gchar *title = NULL;
-	g_autofree gchar *message = NULL;
-	g_auto(GStrv) package_ids = NULL;
-	GtkWidget *dialog;
-	g_autofree gchar *package_id_selected = NULL;
-	gboolean ret;
 
 	/* get the results */
 	results = pk_client_generic_finish (client, res, &error);
 	if (results == NULL) {
-		g_warning ("failed to get depends: %s", error->message);
-		return;
+		g_warning ("failed to get %s: %s", pk_role_enum_to_string (depends->role), error->message);
+		goto out;
 	}
+	gpk_trace_mark (depends->trace->token, GPK_TRACE_MARK_FINISHED);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
 	if (error_code != NULL) {
-		g_warning ("failed to get depends: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+		g_warning ("failed to get %s: %s, %s", pk_role_enum_to_string (depends->role),
+			   pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
 
 		/* if obvious message, don't tell the user */
 		if (pk_error_get_code (error_code) != PK_ERROR_ENUM_TRANSACTION_CANCELLED) {
@@ -877,57 +974,106 @@ gpk_application_get_depends_cb (PkClient *client, GAsyncResult *res, GpkApplicat
 			gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
 						gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
 		}
-		return;
+		goto out;
 	}
 
-	/* get data */
+	/* remember for the next time this package is expanded */
 	array = pk_results_get_package_array (results);
-
-	/* get selection */
-	ret = gpk_application_get_selected_package (priv, &package_id_selected, NULL);
-	if (!ret) {
-		g_warning ("no package selected");
+	g_hash_table_insert (priv->depends_cache,
+			     g_strdup (depends->key),
+			     g_ptr_array_ref (array));
+	gpk_application_depends_done (depends, array);
+	return;
+out:
+	/* show nothing below the row rather than loading forever */
+	if (depends->row != NULL) {
+		array = g_ptr_array_new ();
+		gpk_application_depends_done (depends, array);
 		return;
 	}
+	gpk_application_depends_free (depends);
+}
 
-	/* empty array */
-	window = GTK_WINDOW (gtk_builder_get_object (priv->builder, "window_manager"));
-	if (array->len == 0) {
-		gpk_error_dialog_modal (window,
-					/* TRANSLATORS: no packages returned */
-					_("No packages"),
-					/* TRANSLATORS: this package does not depend on any others */
-					_("This package does not depend on any others"), NULL);
+static void
+gpk_application_depends_fetch (GpkApplicationPrivate *priv,
+			       PkRoleEnum role,
+			       const gchar *package_id,
+			       GtkTreeStore *store,
+			       GtkTreeIter *iter)
+{
+	GpkApplicationDepends *depends;
+	GPtrArray *array;
+	PkBitfield filters = pk_bitfield_value (PK_FILTER_ENUM_NONE);
+	g_auto(GStrv) package_ids = NULL;
+	g_autoptr(GtkTreePath) path = NULL;
+
+	depends = g_new0 (GpkApplicationDepends, 1);
+	depends->priv = priv;
+	depends->role = role;
+	depends->package_id = g_strdup (package_id);
+	depends->key = g_strdup_printf ("%s|%" G_GUINT64_FORMAT "|%s",
+					pk_role_enum_to_string (role), filters, package_id);
+	if (store != NULL) {
+		depends->store = g_object_ref (store);
+		path = gtk_tree_model_get_path (GTK_TREE_MODEL (store), iter);
+		depends->row = gtk_tree_row_reference_new (GTK_TREE_MODEL (store), path);
+	}
+	depends->trace = gpk_trace_request_new (role, priv);
+
+	/* already seen this package */
+	array = g_hash_table_lookup (priv->depends_cache, depends->key);
+	if (array != NULL) {
+		gpk_application_depends_done (depends, array);
 		return;
 	}
 
-	package_ids = pk_package_ids_from_id (package_id_selected);
-	name = gpk_dialog_package_id_name_join_locale (package_ids);
-	/* TRANSLATORS: title: show the number of other packages we depend on */
-	title = g_strdup_printf (ngettext ("%u additional package is required for %s",
-					   "%u additional packages are required for %s",
-					   array->len), array->len, name);
+	/* ensure new action succeeds */
+	g_cancellable_reset (priv->cancellable);
 
-	/* TRANSLATORS: message: show the array of dependent packages for this package */
-	message = g_strdup_printf (ngettext ("Packages listed below are required for %s to function correctly.",
-					     "Packages listed below are required for %s to function correctly.",
-					     array->len), name);
+	/* only the direct edges, the next level is fetched when expanded */
+	package_ids = pk_package_ids_from_id (package_id);
+	if (role == PK_ROLE_ENUM_DEPENDS_ON) {
+		pk_client_depends_on_async (PK_CLIENT (priv->task), filters,
+					    package_ids, FALSE, priv->cancellable,
+					    (PkProgressCallback) gpk_application_progress_cb, depends->trace,
+					    (GAsyncReadyCallback) gpk_application_depends_cb, depends);
+	} else {
+		pk_client_required_by_async (PK_CLIENT (priv->task), filters,
+					     package_ids, FALSE, priv->cancellable,
+					     (PkProgressCallback) gpk_application_progress_cb, depends->trace,
+					     (GAsyncReadyCallback) gpk_application_depends_cb, depends);
+	}
+}
 
-	dialog = gtk_message_dialog_new (window, GTK_DIALOG_DESTROY_WITH_PARENT,
-					 GTK_MESSAGE_INFO, GTK_BUTTONS_OK, "%s", title);
-	gtk_window_set_resizable (GTK_WINDOW (dialog), TRUE);
-	gtk_message_dialog_format_secondary_markup (GTK_MESSAGE_DIALOG (dialog), "%s", message);
-	gpk_dialog_embed_package_list_widget (GTK_DIALOG (dialog), array);
+static gboolean
+gpk_application_depends_test_expand_row_cb (GtkTreeView *treeview,
+					    GtkTreeIter *iter,
+					    GtkTreePath *path,
+					    GpkApplicationPrivate *priv)
+{
+	GtkTreeModel *model = gtk_tree_view_get_model (treeview);
+	gboolean loaded;
+	g_autofree gchar *package_id = NULL;
 
-	gtk_dialog_run (GTK_DIALOG (dialog));
-	gtk_widget_destroy (GTK_WIDGET (dialog));
+	gtk_tree_model_get (model, iter,
+			    DEPENDS_COLUMN_ID, &package_id,
+			    DEPENDS_COLUMN_LOADED, &loaded,
+			    -1);
+	if (loaded || package_id == NULL)
+		return FALSE;
+
+	/* only ever fetch each row once */
+	gtk_tree_store_set (GTK_TREE_STORE (model), iter, DEPENDS_COLUMN_LOADED, TRUE, -1);
+	gpk_application_depends_fetch (priv,
+				       GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (treeview), "role")),
+				       package_id, GTK_TREE_STORE (model), iter);
+	return FALSE;
 }
 
 static void
-gpk_application_menu_depends_cb (GtkAction *_action, GpkApplicationPrivate *priv)
+gpk_application_menu_requires_cb (GtkAction *action, GpkApplicationPrivate *priv)
 {
 	gboolean ret;
-	g_auto(GStrv) package_ids = NULL;
 	g_autofree gchar *package_id_selected = NULL;
 
 	/* get selection */
@@ -937,17 +1083,27 @@ gpk_application_menu_depends_cb (GtkAction *_action, GpkApplicationPrivate *priv
 		return;
 	}
 
-	/* ensure new action succeeds */
-	g_cancellable_reset (priv->cancellable);
+	/* get the requires */
+	gpk_application_depends_fetch (priv, PK_ROLE_ENUM_DEPENDS_ON,
+				       package_id_selected, NULL, NULL);
+}
 
-	/* get the depends */
-	package_ids = pk_package_ids_from_id (package_id_selected);
+static void
+gpk_application_menu_depends_cb (GtkAction *_action, GpkApplicationPrivate *priv)
+{
+	gboolean ret;
+	g_autofree gchar *package_id_selected = NULL;
+
+	/* get selection */
+	ret = gpk_application_get_selected_package (priv, &package_id_selected, NULL);
+	if (!ret) {
+		g_warning ("no package selected");
+		return;
+	}
 
-	pk_client_required_by_async (PK_CLIENT (priv->task),
-				     pk_bitfield_value (PK_FILTER_ENUM_NONE),
-				     package_ids, TRUE, priv->cancellable,
-				     (PkProgressCallback) gpk_application_progress_cb, priv,
-				     (GAsyncReadyCallback) gpk_application_get_requires_cb, priv);
+	/* get the depends */
+	gpk_application_depends_fetch (priv, PK_ROLE_ENUM_REQUIRED_BY,
+				       package_id_selected, NULL, NULL);
 }
 
 static const gchar *
@@ -1004,8 +1160,16 @@ gpk_application_clear_details (GpkApplicationPrivate *priv)
 static void
 gpk_application_clear_packages (GpkApplicationPrivate *priv)
 {
+	/* stop adding the results of the last search */
+	if (priv->page_id > 0) {
+		g_source_remove (priv->page_id);
+		priv->page_id = 0;
+	}
+	g_clear_pointer (&priv->page_array, g_ptr_array_unref);
+
 	/* clear existing array */
 	priv->has_package = FALSE;
+	g_hash_table_remove_all (priv->queue_rows);
 	gtk_list_store_clear (priv->packages_store);
 }
 
@@ -1013,16 +1177,12 @@ static void
 gpk_application_add_item_to_results (GpkApplicationPrivate *priv, PkPackage *item)
 {
 	GtkTreeIter iter;
-	g_autofree gchar *text = NULL;
 	gboolean in_queue;
 	gboolean installed;
-	gboolean enabled;
 	PkBitfield state = 0;
-	static guint package_cnt = 0;
 	PkInfoEnum info;
 	g_autofree gchar *package_id = NULL;
 	g_autofree gchar *summary = NULL;
-	GtkWidget *widget;
 
 	/* get data */
 	g_object_get (item,
@@ -1035,43 +1195,22 @@ gpk_application_add_item_to_results (GpkApplicationPrivate *priv, PkPackage *ite
 	priv->has_package = TRUE;
 
 	/* are we in the package array? */
-	in_queue = (pk_package_sack_find_by_id (priv->package_sack, package_id) != NULL);
+	in_queue = (gpk_application_queue_lookup (priv, package_id) != NULL);
 	installed = (info == PK_INFO_ENUM_INSTALLED) || (info == PK_INFO_ENUM_COLLECTION_INSTALLED);
 
 	if (installed)
-		pk_bitfield_add (state, GPK_STATE_INSTALLED);
+		pk_bitfield_add (state, GPK_PACKAGE_STATE_INSTALLED);
 	if (in_queue)
-		pk_bitfield_add (state, GPK_STATE_IN_LIST);
+		pk_bitfield_add (state, GPK_PACKAGE_STATE_IN_LIST);
 
 	/* special icon */
 	if (info == PK_INFO_ENUM_COLLECTION_INSTALLED || info == PK_INFO_ENUM_COLLECTION_AVAILABLE)
-		pk_bitfield_add (state, GPK_STATE_COLLECTION);
+		pk_bitfield_add (state, GPK_PACKAGE_STATE_COLLECTION);
 
-	/* use two lines */
-	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "window_manager"));
-	text = gpk_package_id_format_twoline (gtk_widget_get_style_context (widget),
-					      package_id,
-					      summary);
-
-	/* can we modify this? */
-	enabled = gpk_application_get_checkbox_enable (priv, state);
-
-	gtk_list_store_append (priv->packages_store, &iter);
-	gtk_list_store_set (priv->packages_store, &iter,
-			    PACKAGES_COLUMN_STATE, state,
-			    PACKAGES_COLUMN_CHECKBOX, gpk_application_state_get_checkbox (state),
-			    PACKAGES_COLUMN_CHECKBOX_VISIBLE, enabled,
-			    PACKAGES_COLUMN_TEXT, text,
-			    PACKAGES_COLUMN_SUMMARY, summary,
-			    PACKAGES_COLUMN_ID, package_id,
-			    PACKAGES_COLUMN_IMAGE, gpk_application_state_get_icon (state),
-			    -1);
-
-	/* only process every n events else we re-order too many times */
-	if (package_cnt++ % 200 == 0) {
-		while (gtk_events_pending ())
-			gtk_main_iteration ();
-	}
+	/* the text is formatted when the row is drawn */
+	gpk_packages_store_add (priv->packages_store, &iter, package_id, summary, state);
+	if (in_queue)
+		gpk_application_queue_rows_add (priv, package_id, &iter);
 }
 
 static void
@@ -1104,12 +1243,12 @@ gpk_application_suggest_better_search (GpkApplicationPrivate *priv)
 	text = g_strdup_printf ("%s\n%s", title, message);
 	gtk_list_store_append (priv->packages_store, &iter);
 	gtk_list_store_set (priv->packages_store, &iter,
-			    PACKAGES_COLUMN_STATE, state,
-			    PACKAGES_COLUMN_CHECKBOX, FALSE,
-			    PACKAGES_COLUMN_CHECKBOX_VISIBLE, FALSE,
-			    PACKAGES_COLUMN_TEXT, text,
-			    PACKAGES_COLUMN_IMAGE, "system-search",
-			    PACKAGES_COLUMN_ID, NULL,
+			    GPK_PACKAGES_COLUMN_STATE, state,
+			    GPK_PACKAGES_COLUMN_CHECKBOX, FALSE,
+			    GPK_PACKAGES_COLUMN_CHECKBOX_VISIBLE, FALSE,
+			    GPK_PACKAGES_COLUMN_TEXT, text,
+			    GPK_PACKAGES_COLUMN_IMAGE, "system-search",
+			    GPK_PACKAGES_COLUMN_ID, NULL,
 			    -1);
 }
 
@@ -1144,7 +1283,7 @@ gpk_application_select_exact_match (GpkApplicationPrivate *priv, const gchar *te
 	/* for all items in treeview */
 	while (valid) {
 		g_autofree gchar *package_id = NULL;
-		gtk_tree_model_get (model, &iter, PACKAGES_COLUMN_ID, &package_id, -1);
+		gtk_tree_model_get (model, &iter, GPK_PACKAGES_COLUMN_ID, &package_id, -1);
 		if (package_id != NULL) {
 			g_auto(GStrv) split = NULL;
 			/* exact match, so select and scroll */
@@ -1184,15 +1323,180 @@ gpk_application_set_button_find_sensitivity (GpkApplicationPrivate *priv)
 	gtk_widget_set_sensitive (widget, !priv->search_in_progress);
 }
 
+static gchar *
+gpk_application_search_cache_key_new (GpkSearchMode search_mode,
+				      GpkSearchType search_type,
+				      PkBitfield filters,
+				      const gchar *terms)
+{
+	g_autofree gchar *filters_str = NULL;
+
+	filters_str = pk_filter_bitfield_to_string (filters);
+	return g_strdup_printf ("%u|%u|%s|%s",
+				search_mode, search_type, filters_str,
+				terms != NULL ? terms : "");
+}
+
+static gchar *
+gpk_application_search_cache_key (GpkApplicationPrivate *priv)
+{
+	const gchar *terms = NULL;
+	GpkSearchType search_type = 0;
+
+	if (priv->search_mode == GPK_MODE_NAME_DETAILS_FILE) {
+		search_type = priv->search_type;
+		terms = priv->search_text;
+	} else if (priv->search_mode == GPK_MODE_GROUP) {
+		terms = priv->search_group;
+	}
+	return gpk_application_search_cache_key_new (priv->search_mode, search_type,
+						     priv->filters_current, terms);
+}
+
+static void
+gpk_application_search_cache_add (GpkApplicationPrivate *priv, const gchar *key, GPtrArray *array)
+{
+	gchar *key_new;
+
+	if (g_hash_table_contains (priv->search_cache, key))
+		return;
+
+	/* drop the least recently used, which also frees the key */
+	while (g_queue_get_length (priv->search_cache_keys) >= GPK_APPLICATION_SEARCH_CACHE_MAX)
+		g_hash_table_remove (priv->search_cache,
+				     g_queue_pop_head (priv->search_cache_keys));
+
+	key_new = g_strdup (key);
+	g_hash_table_insert (priv->search_cache, key_new, g_ptr_array_ref (array));
+	g_queue_push_tail (priv->search_cache_keys, key_new);
+}
+
+static GPtrArray *
+gpk_application_search_cache_lookup (GpkApplicationPrivate *priv, const gchar *key)
+{
+	gpointer key_orig;
+	gpointer array;
+	GList *link;
+
+	if (!g_hash_table_lookup_extended (priv->search_cache, key, &key_orig, &array))
+		return NULL;
+
+	/* move to the most recently used end */
+	link = g_queue_find (priv->search_cache_keys, key_orig);
+	g_queue_unlink (priv->search_cache_keys, link);
+	g_queue_push_tail_link (priv->search_cache_keys, link);
+	return array;
+}
+
+static void
+gpk_application_search_cache_clear (GpkApplicationPrivate *priv)
+{
+	/* results from a search already running may be stale too */
+	g_clear_pointer (&priv->search_key, g_free);
+	g_clear_pointer (&priv->prefetch_key, g_free);
+	g_queue_clear (priv->search_cache_keys);
+	g_hash_table_remove_all (priv->search_cache);
+}
+
+static gint
+gpk_application_package_id_sort_cb (gconstpointer a, gconstpointer b)
+{
+	PkPackage *package_a = *((PkPackage **) a);
+	PkPackage *package_b = *((PkPackage **) b);
+	return g_strcmp0 (pk_package_get_id (package_a), pk_package_get_id (package_b));
+}
+
+static gboolean
+gpk_application_search_page_cb (GpkApplicationPrivate *priv)
+{
+	guint i;
+	guint end;
+	guint len = priv->page_array->len;
+
+	end = MIN (priv->page_offset + GPK_APPLICATION_PAGE_SIZE, len);
+	for (i = priv->page_offset; i < end; i++) {
+		guint idx = priv->page_descending ? len - 1 - i : i;
+		gpk_application_add_item_to_results (priv, g_ptr_array_index (priv->page_array, idx));
+	}
+	priv->page_offset = end;
+	if (end < priv->page_array->len)
+		return TRUE;
+
+	/* all added */
+	priv->page_id = 0;
+	g_clear_pointer (&priv->page_array, g_ptr_array_unref);
+
+	/* were there no entries found? */
+	if (!priv->has_package)
+		gpk_application_suggest_better_search (priv);
+
+	/* if there is an exact match, select it */
+	gpk_application_select_exact_match (priv, priv->search_text);
+	return FALSE;
+}
+
 static void
-gpk_application_search_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv)
+gpk_application_search_show (GpkApplicationPrivate *priv, GPtrArray *array)
 {
+	GtkWidget *widget;
+	GtkSortType order;
+	gint sort_column;
+
+	/* the array is sorted by package-id, and is walked in the order of
+	 * the store so each row is appended where it belongs rather than
+	 * moved past all the others, and the first page can be drawn
+	 * before the rest arrive */
+	gtk_tree_sortable_get_sort_column_id (GTK_TREE_SORTABLE (priv->packages_store),
+					      &sort_column, &order);
+	priv->page_array = g_ptr_array_ref (array);
+	priv->page_offset = 0;
+	priv->page_descending = (order == GTK_SORT_DESCENDING);
+	if (gpk_application_search_page_cb (priv)) {
+		priv->page_id = g_idle_add ((GSourceFunc) gpk_application_search_page_cb, priv);
+		g_source_set_name_by_id (priv->page_id, "[GpkApplication] page");
+	}
+
+	/* focus back to the text extry */
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "entry_text"));
+	gtk_widget_grab_focus (widget);
+
+	/* reset UI */
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_groups"));
+	gtk_widget_set_sensitive (widget, TRUE);
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "textview_description"));
+	gtk_widget_set_sensitive (widget, TRUE);
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "entry_text"));
+	gtk_widget_set_sensitive (widget, TRUE);
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_apply"));
+	gtk_widget_set_sensitive (widget, TRUE);
+}
+
+static gboolean
+gpk_application_search_cached (GpkApplicationPrivate *priv)
+{
+	GPtrArray *array;
+
+	g_free (priv->search_key);
+	priv->search_key = gpk_application_search_cache_key (priv);
+	array = gpk_application_search_cache_lookup (priv, priv->search_key);
+	if (array == NULL)
+		return FALSE;
+
+	/* nothing has changed since we last asked */
+	g_debug ("using cached results for %s", priv->search_key);
+	gpk_application_search_show (priv, array);
+	return TRUE;
+}
+
+static void
+gpk_application_search_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GpkTraceRequest) request = user_data;
+	GpkApplicationPrivate *priv = request->user_data;
 	g_autoptr(PkResults) results = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(PkError) error_code = NULL;
 	g_autoptr(GPtrArray) array = NULL;
-	PkPackage *item;
-	guint i;
 	GtkWidget *widget;
 	GtkWindow *window;
 
@@ -1202,6 +1506,7 @@ gpk_application_search_cb (PkClient *client, GAsyncResult *res, GpkApplicationPr
 		g_warning ("failed to search: %s", error->message);
 		goto out;
 	}
+	gpk_trace_mark (request->token, GPK_TRACE_MARK_FINISHED);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -1217,33 +1522,14 @@ gpk_application_search_cb (PkClient *client, GAsyncResult *res, GpkApplicationPr
 		goto out;
 	}
 
-	/* get data */
+	/* get data, and keep it unless the cache was invalidated meanwhile */
 	array = pk_results_get_package_array (results);
-	for (i = 0; i < array->len; i++) {
-		item = g_ptr_array_index (array, i);
-		gpk_application_add_item_to_results (priv, item);
-	}
-
-	/* were there no entries found? */
-	if (!priv->has_package)
-		gpk_application_suggest_better_search (priv);
-
-	/* if there is an exact match, select it */
-	gpk_application_select_exact_match (priv, priv->search_text);
-
-	/* focus back to the text extry */
-	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "entry_text"));
-	gtk_widget_grab_focus (widget);
-
-	/* reset UI */
-	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_groups"));
-	gtk_widget_set_sensitive (widget, TRUE);
-	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "textview_description"));
-	gtk_widget_set_sensitive (widget, TRUE);
-	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "entry_text"));
-	gtk_widget_set_sensitive (widget, TRUE);
-	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_apply"));
-	gtk_widget_set_sensitive (widget, TRUE);
+	g_ptr_array_sort (array, gpk_application_package_id_sort_cb);
+	if (priv->search_key != NULL)
+		gpk_application_search_cache_add (priv, priv->search_key, array);
+	gpk_application_search_show (priv, array);
+	gpk_trace_end (request->token,
+		       GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_packages")));
 out:
 	/* mark find button sensitive */
 	priv->search_in_progress = FALSE;
@@ -1257,6 +1543,7 @@ gpk_application_perform_search_name_details_file (GpkApplicationPrivate *priv)
 {
 	GtkEntry *entry;
 	GtkWindow *window;
+	GpkTraceRequest *request;
 	g_autoptr(GError) error = NULL;
 	gboolean ret;
 	g_auto(GStrv) searches = NULL;
@@ -1285,6 +1572,10 @@ gpk_application_perform_search_name_details_file (GpkApplicationPrivate *priv)
 	}
 	g_debug ("find %s", priv->search_text);
 
+	/* already got the results */
+	if (gpk_application_search_cached (priv))
+		return;
+
 	/* mark find button insensitive */
 	priv->search_in_progress = TRUE;
 	gpk_application_set_button_find_sensitivity (priv);
@@ -1295,23 +1586,26 @@ gpk_application_perform_search_name_details_file (GpkApplicationPrivate *priv)
 	/* do the search */
 	searches = g_strsplit (priv->search_text, " ", -1);
 	if (priv->search_type == GPK_SEARCH_NAME) {
+		request = gpk_trace_request_new (PK_ROLE_ENUM_SEARCH_NAME, priv);
 		pk_task_search_names_async (priv->task,
 					     priv->filters_current,
 					     searches, priv->cancellable,
-					     (PkProgressCallback) gpk_application_progress_cb, priv,
-					     (GAsyncReadyCallback) gpk_application_search_cb, priv);
+					     (PkProgressCallback) gpk_application_progress_cb, request,
+					     (GAsyncReadyCallback) gpk_application_search_cb, request);
 	} else if (priv->search_type == GPK_SEARCH_DETAILS) {
+		request = gpk_trace_request_new (PK_ROLE_ENUM_SEARCH_DETAILS, priv);
 		pk_task_search_details_async (priv->task,
 					     priv->filters_current,
 					     searches, priv->cancellable,
-					     (PkProgressCallback) gpk_application_progress_cb, priv,
-					     (GAsyncReadyCallback) gpk_application_search_cb, priv);
+					     (PkProgressCallback) gpk_application_progress_cb, request,
+					     (GAsyncReadyCallback) gpk_application_search_cb, request);
 	} else if (priv->search_type == GPK_SEARCH_FILE) {
+		request = gpk_trace_request_new (PK_ROLE_ENUM_SEARCH_FILE, priv);
 		pk_task_search_files_async (priv->task,
 					     priv->filters_current,
 					     searches, priv->cancellable,
-					     (PkProgressCallback) gpk_application_progress_cb, priv,
-					     (GAsyncReadyCallback) gpk_application_search_cb, priv);
+					     (PkProgressCallback) gpk_application_progress_cb, request,
+					     (GAsyncReadyCallback) gpk_application_search_cb, request);
 	} else {
 		g_warning ("invalid search type");
 		return;
@@ -1331,6 +1625,12 @@ gpk_application_perform_search_name_details_file (GpkApplicationPrivate *priv)
 static void
 gpk_application_perform_search_others (GpkApplicationPrivate *priv)
 {
+	GpkTraceRequest *request;
+
+	/* already got the results */
+	if (gpk_application_search_cached (priv))
+		return;
+
 	/* ensure new action succeeds */
 	g_cancellable_reset (priv->cancellable);
 
@@ -1339,15 +1639,256 @@ gpk_application_perform_search_others (GpkApplicationPrivate *priv)
 	if (priv->search_mode == GPK_MODE_GROUP) {
 		g_auto(GStrv) search_groups = NULL;
 		search_groups = g_strsplit (priv->search_group, " ", -1);
+		request = gpk_trace_request_new (PK_ROLE_ENUM_SEARCH_GROUP, priv);
 		pk_client_search_groups_async (PK_CLIENT(priv->task),
 					       priv->filters_current, search_groups, priv->cancellable,
-					       (PkProgressCallback) gpk_application_progress_cb, priv,
-					       (GAsyncReadyCallback) gpk_application_search_cb, priv);
+					       (PkProgressCallback) gpk_application_progress_cb, request,
+					       (GAsyncReadyCallback) gpk_application_search_cb, request);
 	} else {
+		request = gpk_trace_request_new (PK_ROLE_ENUM_GET_PACKAGES, priv);
 		pk_client_get_packages_async (PK_CLIENT(priv->task),
 					      priv->filters_current, priv->cancellable,
-					      (PkProgressCallback) gpk_application_progress_cb, priv,
-					      (GAsyncReadyCallback) gpk_application_search_cb, priv);
+					      (PkProgressCallback) gpk_application_progress_cb, request,
+					      (GAsyncReadyCallback) gpk_application_search_cb, request);
+	}
+}
+
+static gint
+gpk_application_group_usage_sort_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	GpkApplicationPrivate *priv = (GpkApplicationPrivate *) user_data;
+	guint count_a = GPOINTER_TO_UINT (g_hash_table_lookup (priv->group_usage, a));
+	guint count_b = GPOINTER_TO_UINT (g_hash_table_lookup (priv->group_usage, b));
+
+	if (count_a != count_b)
+		return count_a > count_b ? -1 : 1;
+	return g_strcmp0 (a, b);
+}
+
+static void
+gpk_application_group_usage_load (GpkApplicationPrivate *priv)
+{
+	g_autoptr(GVariant) usage = NULL;
+	GVariantIter iter;
+	const gchar *group;
+	guint count;
+
+	usage = g_settings_get_value (priv->settings, GPK_SETTINGS_GROUP_USAGE);
+	g_variant_iter_init (&iter, usage);
+	while (g_variant_iter_next (&iter, "{&su}", &group, &count))
+		g_hash_table_insert (priv->group_usage, g_strdup (group), GUINT_TO_POINTER (count));
+}
+
+static void
+gpk_application_group_usage_add (GpkApplicationPrivate *priv, const gchar *group)
+{
+	GHashTableIter iter;
+	GVariantBuilder builder;
+	gpointer key;
+	gpointer value;
+	guint count;
+
+	count = GPOINTER_TO_UINT (g_hash_table_lookup (priv->group_usage, group));
+	g_hash_table_insert (priv->group_usage, g_strdup (group), GUINT_TO_POINTER (count + 1));
+
+	/* save for the next time we start */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{su}"));
+	g_hash_table_iter_init (&iter, priv->group_usage);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_variant_builder_add (&builder, "{su}", key, GPOINTER_TO_UINT (value));
+	g_settings_set_value (priv->settings, GPK_SETTINGS_GROUP_USAGE,
+			      g_variant_builder_end (&builder));
+}
+
+static const gchar *
+gpk_application_prefetch_next_group (GpkApplicationPrivate *priv)
+{
+	GList *l;
+	guint i;
+	g_autoptr(GList) groups = NULL;
+
+	groups = g_hash_table_get_keys (priv->group_usage);
+	groups = g_list_sort_with_data (groups, gpk_application_group_usage_sort_cb, priv);
+	for (l = groups, i = 0; l != NULL && i < GPK_APPLICATION_PREFETCH_GROUPS; l = l->next, i++) {
+		g_autofree gchar *key = NULL;
+		key = gpk_application_search_cache_key_new (GPK_MODE_GROUP, 0,
+							    priv->filters_current,
+							    l->data);
+		if (!g_hash_table_contains (priv->search_cache, key))
+			return l->data;
+	}
+	return NULL;
+}
+
+static void
+gpk_application_prefetch_done (GpkApplicationPrivate *priv, gboolean retry)
+{
+	g_clear_object (&priv->prefetch_cancellable);
+	g_clear_pointer (&priv->prefetch_key, g_free);
+	g_clear_pointer (&priv->prefetch_tid, g_free);
+	g_clear_pointer (&priv->prefetch_tids, g_strfreev);
+	if (retry)
+		gpk_application_prefetch_schedule (priv);
+}
+
+static void
+gpk_application_prefetch_cancel (GpkApplicationPrivate *priv)
+{
+	if (priv->prefetch_cancellable == NULL)
+		return;
+	g_debug ("yielding to a foreground transaction");
+	g_cancellable_cancel (priv->prefetch_cancellable);
+}
+
+static void
+gpk_application_prefetch_progress_cb (PkProgress *progress, PkProgressType type, GpkApplicationPrivate *priv)
+{
+	/* so we can tell our transaction from the ones the user started */
+	if (type != PK_PROGRESS_TYPE_TRANSACTION_ID)
+		return;
+	g_free (priv->prefetch_tid);
+	g_object_get (progress, "transaction-id", &priv->prefetch_tid, NULL);
+}
+
+static void
+gpk_application_prefetch_search_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv)
+{
+	g_autoptr(PkResults) results = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(PkError) error_code = NULL;
+	g_autoptr(GPtrArray) array = NULL;
+
+	/* get the results */
+	results = pk_client_generic_finish (client, res, &error);
+	if (results == NULL) {
+		g_debug ("failed to prefetch: %s", error->message);
+		gpk_application_prefetch_done (priv, g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED));
+		return;
+	}
+
+	/* check error code, and don't keep asking for a group that fails */
+	error_code = pk_results_get_error_code (results);
+	if (error_code != NULL) {
+		g_debug ("failed to prefetch: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+		gpk_application_prefetch_done (priv, pk_error_get_code (error_code) == PK_ERROR_ENUM_TRANSACTION_CANCELLED);
+		return;
+	}
+
+	/* keep it unless the cache was invalidated meanwhile */
+	array = pk_results_get_package_array (results);
+	g_ptr_array_sort (array, gpk_application_package_id_sort_cb);
+	if (priv->prefetch_key != NULL) {
+		g_debug ("prefetched %s", priv->prefetch_key);
+		gpk_application_search_cache_add (priv, priv->prefetch_key, array);
+	}
+	gpk_application_prefetch_done (priv, TRUE);
+}
+
+static void
+gpk_application_prefetch_transaction_list_cb (PkControl *control, GAsyncResult *res, GpkApplicationPrivate *priv)
+{
+	const gchar *group;
+	g_auto(GStrv) search_groups = NULL;
+	g_auto(GStrv) transaction_ids = NULL;
+	g_autoptr(GError) error = NULL;
+
+	transaction_ids = pk_control_get_transaction_list_finish (control, res, &error);
+	if (transaction_ids == NULL) {
+		g_debug ("failed to get transaction list: %s", error->message);
+		gpk_application_prefetch_done (priv, g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED));
+		return;
+	}
+
+	/* only when the daemon has nothing else to do */
+	if (g_strv_length (transaction_ids) > 0) {
+		g_debug ("daemon busy, prefetching later");
+		gpk_application_prefetch_done (priv, TRUE);
+		return;
+	}
+
+	/* everything may have been shown since we were scheduled */
+	group = gpk_application_prefetch_next_group (priv);
+	if (group == NULL) {
+		gpk_application_prefetch_done (priv, FALSE);
+		return;
+	}
+
+	g_debug ("prefetching group %s", group);
+	priv->prefetch_key = gpk_application_search_cache_key_new (GPK_MODE_GROUP, 0,
+								   priv->filters_current,
+								   group);
+	search_groups = g_strsplit (group, " ", -1);
+	priv->prefetch_tids = g_steal_pointer (&transaction_ids);
+	pk_client_search_groups_async (priv->prefetch_client,
+				       priv->filters_current, search_groups,
+				       priv->prefetch_cancellable,
+				       (PkProgressCallback) gpk_application_prefetch_progress_cb, priv,
+				       (GAsyncReadyCallback) gpk_application_prefetch_search_cb, priv);
+}
+
+static gboolean
+gpk_application_prefetch_cb (GpkApplicationPrivate *priv)
+{
+	priv->prefetch_id = 0;
+
+	/* nothing to do */
+	if (gpk_application_prefetch_next_group (priv) == NULL)
+		return FALSE;
+
+	/* the user is waiting for something */
+	if (priv->search_in_progress ||
+	    priv->page_id > 0 ||
+	    priv->apply_busy) {
+		gpk_application_prefetch_schedule (priv);
+		return FALSE;
+	}
+
+	/* check nobody else is using the daemon first */
+	priv->prefetch_cancellable = g_cancellable_new ();
+	pk_control_get_transaction_list_async (priv->control,
+					       priv->prefetch_cancellable,
+					       (GAsyncReadyCallback) gpk_application_prefetch_transaction_list_cb,
+					       priv);
+	return FALSE;
+}
+
+static void
+gpk_application_prefetch_schedule (GpkApplicationPrivate *priv)
+{
+	/* already waiting or running */
+	if (priv->prefetch_id > 0 || priv->prefetch_cancellable != NULL)
+		return;
+	if (!pk_bitfield_contain (priv->roles, PK_ROLE_ENUM_SEARCH_GROUP))
+		return;
+	priv->prefetch_id = g_timeout_add_seconds (GPK_APPLICATION_PREFETCH_DELAY,
+						   (GSourceFunc) gpk_application_prefetch_cb,
+						   priv);
+	g_source_set_name_by_id (priv->prefetch_id, "[GpkApplication] prefetch");
+}
+
+static void
+gpk_application_transaction_list_changed_cb (PkControl *control, gchar **transaction_ids, GpkApplicationPrivate *priv)
+{
+	gboolean unclaimed;
+	guint i;
+
+	if (priv->prefetch_cancellable == NULL)
+		return;
+
+	/* once the search is sent the progress with our own id may not
+	 * have arrived yet, so one transaction that is new since then can
+	 * be ours; before that, anything running belongs to somebody else */
+	unclaimed = priv->prefetch_tids != NULL && priv->prefetch_tid == NULL;
+	for (i = 0; transaction_ids[i] != NULL; i++) {
+		if (g_strcmp0 (transaction_ids[i], priv->prefetch_tid) == 0)
+			continue;
+		if (unclaimed && !g_strv_contains ((const gchar * const *) priv->prefetch_tids,
+						   transaction_ids[i])) {
+			unclaimed = FALSE;
+			continue;
+		}
+		gpk_application_prefetch_cancel (priv);
+		return;
 	}
 }
 
@@ -1386,6 +1927,9 @@ gpk_application_perform_search (GpkApplicationPrivate *priv)
 	if (priv->search_mode == GPK_MODE_UNKNOWN)
 		return;
 
+	/* the user comes first */
+	gpk_application_prefetch_cancel (priv);
+
 	g_debug ("CLEAR search");
 	gpk_application_clear_details (priv);
 	gpk_application_clear_packages (priv);
@@ -1485,92 +2029,260 @@ gpk_application_packages_installed_clicked_cb (GtkCellRendererToggle *cell, gcha
 	/* get toggled iter */
 	gtk_tree_model_get_iter (model, &iter, path);
 	gtk_tree_model_get (model, &iter,
-			    PACKAGES_COLUMN_STATE, &state,
+			    GPK_PACKAGES_COLUMN_STATE, &state,
 			    -1);
 
-	/* enforce the selection in case we just fire at the checkbox without selecting */
-	selection = gtk_tree_view_get_selection (treeview);
-	gtk_tree_selection_select_iter (selection, &iter);
+	/* enforce the selection in case we just fire at the checkbox without
+	 * selecting, but keep it if this is one of several selected rows */
+	selection = gtk_tree_view_get_selection (treeview);
+	if (!gtk_tree_selection_iter_is_selected (selection, &iter)) {
+		gtk_tree_selection_unselect_all (selection);
+		gtk_tree_selection_select_iter (selection, &iter);
+	}
+
+	if (gpk_package_state_get_checkbox (state)) {
+		gpk_application_remove (priv);
+	} else {
+		gpk_application_install (priv);
+	}
+	gtk_tree_path_free (path);
+}
+
+static void gpk_application_packages_treeview_clicked_cb (GtkTreeSelection *selection, GpkApplicationPrivate *priv);
+
+static void
+gpk_application_button_clear_cb (GtkWidget *widget_button, GpkApplicationPrivate *priv)
+{
+	GtkTreeView *treeview;
+	GtkTreeSelection *selection;
+
+	/* clear queue, and reset the state of the rows that were in it */
+	gpk_application_queue_clear (priv);
+
+	/* force a button refresh */
+	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_packages"));
+	selection = gtk_tree_view_get_selection (treeview);
+	gpk_application_packages_treeview_clicked_cb (selection, priv);
+
+	gpk_application_change_queue_status (priv);
+}
+
+static void
+gpk_application_set_apply_busy (GpkApplicationPrivate *priv, gboolean busy)
+{
+	GtkWidget *widget;
+
+	priv->apply_busy = busy;
+
+	/* make package array insensitive */
+	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_packages"));
+	gtk_widget_set_sensitive (widget, !busy);
+
+	/* make apply button insensitive */
+	if (busy) {
+		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_apply"));
+		gtk_widget_set_visible (widget, FALSE);
+		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_clear"));
+		gtk_widget_set_visible (widget, FALSE);
+	} else {
+		gpk_application_change_queue_status (priv);
+	}
+}
+
+static gchar **
+gpk_application_get_queued_ids (GpkApplicationPrivate *priv, PkInfoEnum info)
+{
+	g_autoptr(PkPackageSack) sack = NULL;
+	sack = pk_package_sack_filter_by_info (priv->package_sack, info);
+	return pk_package_sack_get_ids (sack);
+}
+
+static void
+gpk_application_apply_finished (GpkApplicationPrivate *priv)
+{
+	guint idle_id;
+
+	g_clear_pointer (&priv->apply_install_ids, g_strfreev);
+	g_clear_object (&priv->simulate_install);
+
+	/* what is installed has changed */
+	g_hash_table_remove_all (priv->depends_cache);
+	gpk_application_search_cache_clear (priv);
+	gpk_application_prefetch_schedule (priv);
+
+	/* idle add in the background */
+	idle_id = g_idle_add ((GSourceFunc) gpk_application_perform_search_idle_cb, priv);
+	g_source_set_name_by_id (idle_id, "[GpkApplication] search");
+
+	gpk_application_set_apply_busy (priv, FALSE);
+}
+
+static void
+gpk_application_install_packages_cb (PkTask *task, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GpkTraceRequest) request = user_data;
+	GpkApplicationPrivate *priv = request->user_data;
+	g_autoptr(PkResults) results = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(PkError) error_code = NULL;
+	GtkWindow *window;
+
+	/* get the results */
+	results = pk_task_generic_finish (task, res, &error);
+	if (results == NULL) {
+		g_warning ("failed to install packages: %s", error->message);
+		goto out;
+	}
+	gpk_trace_end (request->token, NULL);
+
+	/* check error code */
+	error_code = pk_results_get_error_code (results);
+	if (error_code != NULL) {
+		g_warning ("failed to install packages: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+
+		/* if obvious message, don't tell the user */
+		if (pk_error_get_code (error_code) != PK_ERROR_ENUM_TRANSACTION_CANCELLED) {
+			window = GTK_WINDOW (gtk_builder_get_object (priv->builder, "window_manager"));
+			gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
+						gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+		}
+		goto out;
+	}
+
+	/* clear the installs if success */
+	gpk_application_queue_remove_info (priv, PK_INFO_ENUM_AVAILABLE);
+out:
+	gpk_application_apply_finished (priv);
+}
+
+static void
+gpk_application_remove_packages_cb (PkTask *task, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GpkTraceRequest) request = user_data;
+	GpkApplicationPrivate *priv = request->user_data;
+	g_autoptr(PkResults) results = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(PkError) error_code = NULL;
+	GtkWindow *window;
+
+	/* get the results */
+	results = pk_task_generic_finish (task, res, &error);
+	if (results == NULL) {
+		g_warning ("failed to remove packages: %s", error->message);
+		goto out;
+	}
+	gpk_trace_end (request->token, NULL);
+
+	/* check error code */
+	error_code = pk_results_get_error_code (results);
+	if (error_code != NULL) {
+		g_warning ("failed to remove packages: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+
+		/* if obvious message, don't tell the user */
+		if (pk_error_get_code (error_code) != PK_ERROR_ENUM_TRANSACTION_CANCELLED) {
+			window = GTK_WINDOW (gtk_builder_get_object (priv->builder, "window_manager"));
+			gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
+						gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+		}
+		goto out;
+	}
+
+	/* clear the removals if success */
+	gpk_application_queue_remove_info (priv, PK_INFO_ENUM_INSTALLED);
 
-	if (gpk_application_state_get_checkbox (state)) {
-		gpk_application_remove (priv);
-	} else {
-		gpk_application_install (priv);
+	/* the install was held back until now */
+	if (priv->apply_install_ids != NULL) {
+		gpk_application_install_simulate (priv);
+		return;
 	}
-	gtk_tree_path_free (path);
+out:
+	gpk_application_apply_finished (priv);
 }
 
-static void gpk_application_packages_treeview_clicked_cb (GtkTreeSelection *selection, GpkApplicationPrivate *priv);
-
 static void
-gpk_application_button_clear_cb (GtkWidget *widget_button, GpkApplicationPrivate *priv)
+gpk_application_apply (GpkApplicationPrivate *priv, gchar **install_ids, gchar **remove_ids)
 {
-	GtkTreeView *treeview;
-	gboolean valid;
-	gboolean checkbox;
-	GtkTreeIter iter;
-	GtkTreeModel *model;
-	GtkTreeSelection *selection;
-	const gchar *icon;
-	PkBitfield state;
-	gboolean ret;
-
-	/* get the first iter in the array */
-	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_packages"));
-	model = gtk_tree_view_get_model (treeview);
-	valid = gtk_tree_model_get_iter_first (model, &iter);
+	gboolean autoremove;
+	GpkTraceRequest *request;
 
-	/* for all current items, reset the state if in the array */
-	while (valid) {
-		gtk_tree_model_get (model, &iter, PACKAGES_COLUMN_STATE, &state, -1);
-		ret = pk_bitfield_contain (state, GPK_STATE_IN_LIST);
-		if (ret) {
-			pk_bitfield_remove (state, GPK_STATE_IN_LIST);
-			/* get the new icon */
-			icon = gpk_application_state_get_icon (state);
-			checkbox = gpk_application_state_get_checkbox (state);
-
-			/* set new value */
-			gtk_list_store_set (GTK_LIST_STORE (model), &iter,
-					    PACKAGES_COLUMN_STATE, state,
-					    PACKAGES_COLUMN_CHECKBOX, checkbox,
-					    PACKAGES_COLUMN_IMAGE, icon,
-					    -1);
-		}
-		valid = gtk_tree_model_iter_next (model, &iter);
+	/* only one kind of change, so PkTask can simulate it as normal */
+	if (g_strv_length (remove_ids) > 0) {
+		autoremove = g_settings_get_boolean (priv->settings, GPK_SETTINGS_ENABLE_AUTOREMOVE);
+		request = gpk_trace_request_new (PK_ROLE_ENUM_REMOVE_PACKAGES, priv);
+		pk_task_remove_packages_async (priv->task, remove_ids, TRUE, autoremove, priv->cancellable,
+					       (PkProgressCallback) gpk_application_progress_cb, request,
+					       (GAsyncReadyCallback) gpk_application_remove_packages_cb, request);
+		return;
 	}
+	request = gpk_trace_request_new (PK_ROLE_ENUM_INSTALL_PACKAGES, priv);
+	pk_task_install_packages_async (priv->task, install_ids, priv->cancellable,
+					(PkProgressCallback) gpk_application_progress_cb, request,
+					(GAsyncReadyCallback) gpk_application_install_packages_cb, request);
+}
 
-	/* clear queue */
-	pk_package_sack_clear (priv->package_sack);
+static gboolean
+gpk_application_sack_equal (PkPackageSack *sack1, PkPackageSack *sack2)
+{
+	g_autoptr(GPtrArray) array = NULL;
+	guint i;
 
-	/* force a button refresh */
-	selection = gtk_tree_view_get_selection (treeview);
-	gpk_application_packages_treeview_clicked_cb (selection, priv);
+	if (pk_package_sack_get_size (sack1) != pk_package_sack_get_size (sack2))
+		return FALSE;
+	array = pk_package_sack_get_array (sack1);
+	for (i = 0; i < array->len; i++) {
+		PkPackage *package = g_ptr_array_index (array, i);
+		g_autoptr(PkPackage) found = NULL;
+		found = pk_package_sack_find_by_id (sack2, pk_package_get_id (package));
+		if (found == NULL)
+			return FALSE;
+	}
+	return TRUE;
+}
 
-	priv->action = GPK_ACTION_NONE;
-	gpk_application_change_queue_status (priv);
+static void
+gpk_application_sack_add_changes (GpkApplicationPrivate *priv, PkPackageSack *sack, PkResults *results)
+{
+	g_autoptr(GPtrArray) array = NULL;
+	guint i;
+
+	/* everything except what the user already asked for */
+	array = pk_results_get_package_array (results);
+	for (i = 0; i < array->len; i++) {
+		PkPackage *package = g_ptr_array_index (array, i);
+		PkInfoEnum info = pk_package_get_info (package);
+		if (info == PK_INFO_ENUM_CLEANUP || info == PK_INFO_ENUM_FINISHED)
+			continue;
+		if (gpk_application_queue_lookup (priv, pk_package_get_id (package)) != NULL)
+			continue;
+		pk_package_sack_add_package (sack, package);
+	}
 }
 
 static void
-gpk_application_install_packages_cb (PkTask *task, GAsyncResult *res, GpkApplicationPrivate *priv)
+gpk_application_install_simulate_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
 {
+	g_autoptr(GpkTraceRequest) request = user_data;
+	GpkApplicationPrivate *priv = request->user_data;
+	gboolean ret;
 	g_autoptr(PkResults) results = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(PkError) error_code = NULL;
+	g_autoptr(PkPackageSack) sack = NULL;
+	GpkTraceRequest *install;
 	GtkWindow *window;
-	guint idle_id;
 
 	/* get the results */
-	results = pk_task_generic_finish (task, res, &error);
+	results = pk_client_generic_finish (client, res, &error);
 	if (results == NULL) {
-		g_warning ("failed to install packages: %s", error->message);
-		return;
+		g_warning ("failed to simulate: %s", error->message);
+		goto out;
 	}
+	gpk_trace_end (request->token, NULL);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
 	if (error_code != NULL) {
-		g_warning ("failed to install packages: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+		g_warning ("failed to simulate: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
 
 		/* if obvious message, don't tell the user */
 		if (pk_error_get_code (error_code) != PK_ERROR_ENUM_TRANSACTION_CANCELLED) {
@@ -1578,39 +2290,103 @@ gpk_application_install_packages_cb (PkTask *task, GAsyncResult *res, GpkApplica
 			gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
 						gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
 		}
-		return;
+		goto out;
 	}
 
-	/* idle add in the background */
-	idle_id = g_idle_add ((GSourceFunc) gpk_application_perform_search_idle_cb, priv);
-	g_source_set_name_by_id (idle_id, "[GpkApplication] search");
+	/* the removal changed what the install needs, so ask again */
+	sack = pk_package_sack_new ();
+	gpk_application_sack_add_changes (priv, sack, results);
+	if (!gpk_application_sack_equal (sack, priv->simulate_install)) {
+		ret = gpk_task_confirm_simulate (GPK_TASK (priv->apply_task),
+						 PK_ROLE_ENUM_INSTALL_PACKAGES,
+						 g_strv_length (priv->apply_install_ids),
+						 sack);
+		if (!ret)
+			goto out;
+	}
 
-	/* clear if success */
-	pk_package_sack_clear (priv->package_sack);
-	priv->action = GPK_ACTION_NONE;
-	gpk_application_change_queue_status (priv);
+	install = gpk_trace_request_new (PK_ROLE_ENUM_INSTALL_PACKAGES, priv);
+	pk_task_install_packages_async (priv->apply_task, priv->apply_install_ids, priv->cancellable,
+					(PkProgressCallback) gpk_application_progress_cb, install,
+					(GAsyncReadyCallback) gpk_application_install_packages_cb, install);
+	return;
+out:
+	gpk_application_apply_finished (priv);
+}
+
+static void
+gpk_application_install_simulate (GpkApplicationPrivate *priv)
+{
+	PkBitfield transaction_flags;
+	GpkTraceRequest *request;
+
+	/* the first simulation could not know what the removal would do */
+	transaction_flags = pk_bitfield_value (PK_TRANSACTION_FLAG_ENUM_SIMULATE);
+	request = gpk_trace_request_new (PK_ROLE_ENUM_INSTALL_PACKAGES, priv);
+	pk_client_install_packages_async (PK_CLIENT (priv->apply_task), transaction_flags,
+					  priv->apply_install_ids, priv->cancellable,
+					  (PkProgressCallback) gpk_application_progress_cb, request,
+					  (GAsyncReadyCallback) gpk_application_install_simulate_cb, request);
 }
 
 static void
-gpk_application_remove_packages_cb (PkTask *task, GAsyncResult *res, GpkApplicationPrivate *priv)
+gpk_application_simulate_finished (GpkApplicationPrivate *priv)
 {
+	gboolean autoremove;
+	gboolean ret = FALSE;
+	GpkTraceRequest *request;
+	g_auto(GStrv) remove_ids = NULL;
+
+	/* show one dependency dialog for the whole queue; each half was
+	 * simulated on its own against the current system */
+	if (!priv->simulate_failed) {
+		ret = gpk_task_confirm_simulate (GPK_TASK (priv->task),
+						 PK_ROLE_ENUM_UNKNOWN,
+						 g_hash_table_size (priv->package_queue),
+						 priv->simulate_sack);
+	}
+	g_clear_object (&priv->simulate_sack);
+	if (!ret) {
+		g_clear_object (&priv->simulate_install);
+		gpk_application_set_apply_busy (priv, FALSE);
+		return;
+	}
+
+	/* remove first, and only install once that has succeeded, so the
+	 * install is resolved against what the removal left behind */
+	priv->apply_install_ids = gpk_application_get_queued_ids (priv, PK_INFO_ENUM_AVAILABLE);
+	remove_ids = gpk_application_get_queued_ids (priv, PK_INFO_ENUM_INSTALLED);
+	autoremove = g_settings_get_boolean (priv->settings, GPK_SETTINGS_ENABLE_AUTOREMOVE);
+	request = gpk_trace_request_new (PK_ROLE_ENUM_REMOVE_PACKAGES, priv);
+	pk_task_remove_packages_async (priv->apply_task, remove_ids, TRUE, autoremove, priv->cancellable,
+				       (PkProgressCallback) gpk_application_progress_cb, request,
+				       (GAsyncReadyCallback) gpk_application_remove_packages_cb, request);
+}
+
+static void
+gpk_application_simulate_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GpkTraceRequest) request = user_data;
+	GpkApplicationPrivate *priv = request->user_data;
 	g_autoptr(PkResults) results = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(PkError) error_code = NULL;
 	GtkWindow *window;
-	guint idle_id;
 
 	/* get the results */
-	results = pk_task_generic_finish (task, res, &error);
+	results = pk_client_generic_finish (client, res, &error);
 	if (results == NULL) {
-		g_warning ("failed to remove packages: %s", error->message);
-		return;
+		g_warning ("failed to simulate: %s", error->message);
+		priv->simulate_failed = TRUE;
+		goto out;
 	}
+	gpk_trace_end (request->token, NULL);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
 	if (error_code != NULL) {
-		g_warning ("failed to remove packages: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+		g_warning ("failed to simulate: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+		priv->simulate_failed = TRUE;
 
 		/* if obvious message, don't tell the user */
 		if (pk_error_get_code (error_code) != PK_ERROR_ENUM_TRANSACTION_CANCELLED) {
@@ -1618,63 +2394,82 @@ gpk_application_remove_packages_cb (PkTask *task, GAsyncResult *res, GpkApplicat
 			gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
 						gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
 		}
-		return;
+		goto out;
 	}
 
-	/* idle add in the background */
-	idle_id = g_idle_add ((GSourceFunc) gpk_application_perform_search_idle_cb, priv);
-	g_source_set_name_by_id (idle_id, "[GpkApplication] search");
-
-	/* clear if success */
-	pk_package_sack_clear (priv->package_sack);
-	priv->action = GPK_ACTION_NONE;
-	gpk_application_change_queue_status (priv);
+	/* keep the install half too, to spot if the removal changes it */
+	gpk_application_sack_add_changes (priv, priv->simulate_sack, results);
+	if (pk_results_get_role (results) == PK_ROLE_ENUM_INSTALL_PACKAGES)
+		gpk_application_sack_add_changes (priv, priv->simulate_install, results);
+out:
+	if (--priv->simulate_pending > 0)
+		return;
+	gpk_application_simulate_finished (priv);
 }
 
 static void
 gpk_application_button_apply_cb (GtkWidget *widget, GpkApplicationPrivate *priv)
 {
-	g_auto(GStrv) package_ids = NULL;
-	gboolean autoremove;
+	PkBitfield transaction_flags;
+	GpkTraceRequest *request;
+	g_auto(GStrv) install_ids = NULL;
+	g_auto(GStrv) remove_ids = NULL;
 
 	/* ensure new action succeeds */
 	g_cancellable_reset (priv->cancellable);
+	gpk_application_set_apply_busy (priv, TRUE);
 
-	package_ids = pk_package_sack_get_ids (priv->package_sack);
-	if (priv->action == GPK_ACTION_INSTALL) {
-		/* install */
-		pk_task_install_packages_async (priv->task, package_ids, priv->cancellable,
-						(PkProgressCallback) gpk_application_progress_cb, priv,
-						(GAsyncReadyCallback) gpk_application_install_packages_cb, priv);
-
-		/* make package array insensitive */
-		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_packages"));
-		gtk_widget_set_sensitive (widget, FALSE);
-
-		/* make apply button insensitive */
-		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_apply"));
-		gtk_widget_set_visible (widget, FALSE);
-		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_clear"));
-		gtk_widget_set_visible (widget, FALSE);
+	install_ids = gpk_application_get_queued_ids (priv, PK_INFO_ENUM_AVAILABLE);
+	remove_ids = gpk_application_get_queued_ids (priv, PK_INFO_ENUM_INSTALLED);
+	if (g_strv_length (install_ids) == 0 || g_strv_length (remove_ids) == 0) {
+		gpk_application_apply (priv, install_ids, remove_ids);
+		return;
+	}
 
-	} else if (priv->action == GPK_ACTION_REMOVE) {
-		autoremove = g_settings_get_boolean (priv->settings, GPK_SETTINGS_ENABLE_AUTOREMOVE);
+	/* PackageKit cannot simulate an install and a removal together, so
+	 * simulate both halves now to confirm the deps in one dialog */
+	priv->simulate_failed = FALSE;
+	priv->simulate_pending = 2;
+	priv->simulate_sack = pk_package_sack_new ();
+	priv->simulate_install = pk_package_sack_new ();
+	transaction_flags = pk_bitfield_value (PK_TRANSACTION_FLAG_ENUM_SIMULATE);
+	request = gpk_trace_request_new (PK_ROLE_ENUM_REMOVE_PACKAGES, priv);
+	pk_client_remove_packages_async (PK_CLIENT (priv->task), transaction_flags, remove_ids,
+					 TRUE, g_settings_get_boolean (priv->settings, GPK_SETTINGS_ENABLE_AUTOREMOVE),
+					 priv->cancellable,
+					 (PkProgressCallback) gpk_application_progress_cb, request,
+					 (GAsyncReadyCallback) gpk_application_simulate_cb, request);
+	request = gpk_trace_request_new (PK_ROLE_ENUM_INSTALL_PACKAGES, priv);
+	pk_client_install_packages_async (PK_CLIENT (priv->task), transaction_flags, install_ids,
+					  priv->cancellable,
+					  (PkProgressCallback) gpk_application_progress_cb, request,
+					  (GAsyncReadyCallback) gpk_application_simulate_cb, request);
+}
 
-		/* remove */
-		pk_task_remove_packages_async (priv->task, package_ids, TRUE, autoremove, priv->cancellable,
-					       (PkProgressCallback) gpk_application_progress_cb, priv,
-					       (GAsyncReadyCallback) gpk_application_remove_packages_cb, priv);
+static void
+gpk_application_packages_text_data_func (GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+					 GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data)
+{
+	GpkApplicationPrivate *priv = (GpkApplicationPrivate *) user_data;
+	GtkWidget *widget;
+	g_autofree gchar *text = NULL;
+	g_autofree gchar *package_id = NULL;
+	g_autofree gchar *summary = NULL;
 
-		/* make package array insensitive */
-		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_packages"));
-		gtk_widget_set_sensitive (widget, FALSE);
+	gtk_tree_model_get (model, iter,
+			    GPK_PACKAGES_COLUMN_TEXT, &text,
+			    GPK_PACKAGES_COLUMN_ID, &package_id,
+			    GPK_PACKAGES_COLUMN_SUMMARY, &summary,
+			    -1);
 
-		/* make apply button insensitive */
-		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_apply"));
-		gtk_widget_set_visible (widget, FALSE);
-		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "button_clear"));
-		gtk_widget_set_visible (widget, FALSE);
+	/* use two lines, only for the rows actually drawn */
+	if (text == NULL && package_id != NULL) {
+		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "window_manager"));
+		text = gpk_package_id_format_twoline (gtk_widget_get_style_context (widget),
+						      package_id,
+						      summary);
 	}
+	g_object_set (renderer, "markup", text, NULL);
 }
 
 static void
@@ -1683,6 +2478,8 @@ gpk_application_packages_add_columns (GpkApplicationPrivate *priv)
 	GtkCellRenderer *renderer;
 	GtkTreeViewColumn *column;
 	GtkTreeView *treeview;
+	gint width;
+	gint xpad;
 
 	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_packages"));
 
@@ -1692,8 +2489,11 @@ gpk_application_packages_add_columns (GpkApplicationPrivate *priv)
 
 	/* TRANSLATORS: column for installed status */
 	column = gtk_tree_view_column_new_with_attributes (_("Installed"), renderer,
-							   "active", PACKAGES_COLUMN_CHECKBOX,
-							   "visible", PACKAGES_COLUMN_CHECKBOX_VISIBLE, NULL);
+							   "active", GPK_PACKAGES_COLUMN_CHECKBOX,
+							   "visible", GPK_PACKAGES_COLUMN_CHECKBOX_VISIBLE, NULL);
+	gtk_cell_renderer_get_preferred_width (renderer, GTK_WIDGET (treeview), NULL, &width);
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width (column, width);
 	gtk_tree_view_append_column (treeview, column);
 
 	/* column for images */
@@ -1701,16 +2501,29 @@ gpk_application_packages_add_columns (GpkApplicationPrivate *priv)
 	renderer = gtk_cell_renderer_pixbuf_new ();
 	g_object_set (renderer, "stock-size", GTK_ICON_SIZE_DIALOG, NULL);
 	gtk_tree_view_column_pack_start (column, renderer, FALSE);
-	gtk_tree_view_column_add_attribute (column, renderer, "icon-name", PACKAGES_COLUMN_IMAGE);
+	gtk_tree_view_column_add_attribute (column, renderer, "icon-name", GPK_PACKAGES_COLUMN_IMAGE);
+	gtk_icon_size_lookup (GTK_ICON_SIZE_DIALOG, &width, NULL);
+	gtk_cell_renderer_get_padding (renderer, &xpad, NULL);
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width (column, width + 2 * xpad);
 	gtk_tree_view_append_column (treeview, column);
 
 	/* column for name */
 	renderer = gtk_cell_renderer_text_new ();
+	column = gtk_tree_view_column_new ();
 	/* TRANSLATORS: column for package name */
-	column = gtk_tree_view_column_new_with_attributes (_("Name"), renderer,
-							   "markup", PACKAGES_COLUMN_TEXT, NULL);
-	gtk_tree_view_column_set_sort_column_id (column, PACKAGES_COLUMN_TEXT);
+	gtk_tree_view_column_set_title (column, _("Name"));
+	gtk_tree_view_column_pack_start (column, renderer, TRUE);
+	gtk_tree_view_column_set_cell_data_func (column, renderer,
+						 gpk_application_packages_text_data_func,
+						 priv, NULL);
+	gtk_tree_view_column_set_sort_column_id (column, GPK_PACKAGES_COLUMN_ID);
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_expand (column, TRUE);
 	gtk_tree_view_append_column (treeview, column);
+
+	/* every row has the same icon size, so only measure one */
+	gtk_tree_view_set_fixed_height_mode (treeview, TRUE);
 }
 
 static void
@@ -1781,14 +2594,20 @@ gpk_application_groups_treeview_changed_cb (GtkTreeSelection *selection, GpkAppl
 		else
 			priv->search_mode = GPK_MODE_GROUP;
 
+		/* remember what gets used, for prefetching */
+		if (priv->search_mode == GPK_MODE_GROUP)
+			gpk_application_group_usage_add (priv, priv->search_group);
+
 		/* actually do the search */
 		gpk_application_perform_search (priv);
 	}
 }
 
 static void
-gpk_application_get_details_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv)
+gpk_application_get_details_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
 {
+	g_autoptr(GpkTraceRequest) request = user_data;
+	GpkApplicationPrivate *priv = request->user_data;
 	g_autoptr(PkResults) results = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(PkError) error_code = NULL;
@@ -1813,6 +2632,7 @@ gpk_application_get_details_cb (PkClient *client, GAsyncResult *res, GpkApplicat
 		g_warning ("failed to get list of categories: %s", error->message);
 		return;
 	}
+	gpk_trace_mark (request->token, GPK_TRACE_MARK_FINISHED);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -1912,27 +2732,34 @@ gpk_application_get_details_cb (PkClient *client, GAsyncResult *res, GpkApplicat
 	/* get the full name of the repo from the repo_id */
 	repo_name = gpk_application_get_full_repo_name (priv, split[PK_PACKAGE_ID_DATA]);
 	gtk_label_set_label (GTK_LABEL (widget), repo_name);
+	gpk_trace_end (request->token,
+		       GTK_WIDGET (gtk_builder_get_object (priv->builder, "grid_details")));
 }
 
 static void
 gpk_application_packages_treeview_clicked_cb (GtkTreeSelection *selection, GpkApplicationPrivate *priv)
 {
 	GtkWidget *widget;
+	GpkTraceRequest *request;
 	GtkTreeModel *model;
 	GtkTreeIter iter;
-	gboolean show_install = TRUE;
-	gboolean show_remove = TRUE;
-	PkBitfield state;
 	g_auto(GStrv) package_ids = NULL;
 	g_autofree gchar *package_id = NULL;
-	g_autofree gchar *summary = NULL;
 
 	/* ignore selection changed if we've just cleared the package list */
 	if (!priv->has_package)
 		return;
 
-	/* This will only work in single or browse selection mode! */
-	if (!gtk_tree_selection_get_selected (selection, &model, &iter)) {
+	/* several packages are being queued at once, so don't fetch details */
+	if (gtk_tree_selection_count_selected_rows (selection) > 1) {
+		widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "hbox_packages"));
+		gtk_widget_show (widget);
+		gpk_application_update_buttons (priv);
+		gpk_application_clear_details (priv);
+		return;
+	}
+
+	if (!gpk_application_get_selected_iter (selection, &model, &iter)) {
 		g_debug ("no row selected");
 
 		/* we cannot now add it */
@@ -1948,9 +2775,7 @@ gpk_application_packages_treeview_clicked_cb (GtkTreeSelection *selection, GpkAp
 
 	/* check we aren't a help line */
 	gtk_tree_model_get (model, &iter,
-			    PACKAGES_COLUMN_STATE, &state,
-			    PACKAGES_COLUMN_ID, &package_id,
-			    PACKAGES_COLUMN_SUMMARY, &summary,
+			    GPK_PACKAGES_COLUMN_ID, &package_id,
 			    -1);
 	if (package_id == NULL) {
 		g_debug ("ignoring help click");
@@ -1961,19 +2786,8 @@ gpk_application_packages_treeview_clicked_cb (GtkTreeSelection *selection, GpkAp
 	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "hbox_packages"));
 	gtk_widget_show (widget);
 
-	show_install = (state == 0 ||
-			state == pk_bitfield_from_enums (GPK_STATE_INSTALLED, GPK_STATE_IN_LIST, -1));
-	show_remove = (state == pk_bitfield_value (GPK_STATE_INSTALLED) ||
-		       state == pk_bitfield_value (GPK_STATE_IN_LIST));
-
-	if (priv->action == GPK_ACTION_INSTALL && !pk_bitfield_contain (state, GPK_STATE_IN_LIST))
-		show_remove = FALSE;
-	if (priv->action == GPK_ACTION_REMOVE && !pk_bitfield_contain (state, GPK_STATE_IN_LIST))
-		show_install = FALSE;
-
 	/* only show buttons if we are in the correct mode */
-	gpk_application_allow_install (priv, show_install);
-	gpk_application_allow_remove (priv, show_remove);
+	gpk_application_update_buttons (priv);
 
 	/* clear the description text */
 	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "textview_description"));
@@ -1984,9 +2798,10 @@ gpk_application_packages_treeview_clicked_cb (GtkTreeSelection *selection, GpkAp
 
 	/* get the details */
 	package_ids = pk_package_ids_from_id (package_id);
+	request = gpk_trace_request_new (PK_ROLE_ENUM_GET_DETAILS, priv);
 	pk_client_get_details_async (PK_CLIENT(priv->task), package_ids, priv->cancellable,
-				     (PkProgressCallback) gpk_application_progress_cb, priv,
-				     (GAsyncReadyCallback) gpk_application_get_details_cb, priv);
+				     (PkProgressCallback) gpk_application_progress_cb, request,
+				     (GAsyncReadyCallback) gpk_application_get_details_cb, request);
 }
 
 static void
@@ -2001,6 +2816,26 @@ gpk_application_notify_network_state_cb (PkControl *_control, GParamSpec *pspec,
 	g_debug ("state=%u", state);
 }
 
+static void
+gpk_application_updates_changed_cb (PkControl *_control, GpkApplicationPrivate *priv)
+{
+	/* the installed and available versions may have changed */
+	g_debug ("updates changed");
+	g_hash_table_remove_all (priv->depends_cache);
+	gpk_application_search_cache_clear (priv);
+	gpk_application_prefetch_schedule (priv);
+}
+
+static void
+gpk_application_repo_list_changed_cb (PkControl *_control, GpkApplicationPrivate *priv)
+{
+	/* packages may have appeared or gone away */
+	g_debug ("repo list changed");
+	g_hash_table_remove_all (priv->depends_cache);
+	gpk_application_search_cache_clear (priv);
+	gpk_application_prefetch_schedule (priv);
+}
+
 static void
 gpk_application_group_add_data (GpkApplicationPrivate *priv, PkGroupEnum group)
 {
@@ -2236,8 +3071,10 @@ gpk_application_activate_log_cb (GSimpleAction *action,
 }
 
 static void
-gpk_application_refresh_cache_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv)
+gpk_application_refresh_cache_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
 {
+	g_autoptr(GpkTraceRequest) request = user_data;
+	GpkApplicationPrivate *priv = request->user_data;
 	g_autoptr(PkResults) results = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(PkError) error_code = NULL;
@@ -2249,6 +3086,7 @@ gpk_application_refresh_cache_cb (PkClient *client, GAsyncResult *res, GpkApplic
 		g_warning ("failed to refresh: %s", error->message);
 		return;
 	}
+	gpk_trace_end (request->token, NULL);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -2271,13 +3109,15 @@ gpk_application_activate_refresh_cb (GSimpleAction *action,
 				     gpointer user_data)
 {
 	GpkApplicationPrivate *priv = user_data;
+	GpkTraceRequest *request;
 
 	/* ensure new action succeeds */
 	g_cancellable_reset (priv->cancellable);
 
+	request = gpk_trace_request_new (PK_ROLE_ENUM_REFRESH_CACHE, priv);
 	pk_task_refresh_cache_async (priv->task, TRUE, priv->cancellable,
-				     (PkProgressCallback) gpk_application_progress_cb, priv,
-				     (GAsyncReadyCallback) gpk_application_refresh_cache_cb, priv);
+				     (PkProgressCallback) gpk_application_progress_cb, request,
+				     (GAsyncReadyCallback) gpk_application_refresh_cache_cb, request);
 }
 
 static void
@@ -2300,8 +3140,8 @@ gpk_application_package_row_activated_cb (GtkTreeView *treeview, GtkTreePath *pa
 
 	/* get data */
 	gtk_tree_model_get (model, &iter,
-			    PACKAGES_COLUMN_STATE, &state,
-			    PACKAGES_COLUMN_ID, &package_id,
+			    GPK_PACKAGES_COLUMN_STATE, &state,
+			    GPK_PACKAGES_COLUMN_ID, &package_id,
 			    -1);
 
 	/* check we aren't a help line */
@@ -2310,7 +3150,7 @@ gpk_application_package_row_activated_cb (GtkTreeView *treeview, GtkTreePath *pa
 		return;
 	}
 
-	if (gpk_application_state_get_checkbox (state))
+	if (gpk_package_state_get_checkbox (state))
 		gpk_application_remove (priv);
 	else
 		gpk_application_install (priv);
@@ -2344,13 +3184,13 @@ gpk_application_add_welcome (GpkApplicationPrivate *priv)
 		welcome = _("Enter a search word to get started.");
 	}
 	gtk_list_store_set (priv->packages_store, &iter,
-			    PACKAGES_COLUMN_STATE, state,
-			    PACKAGES_COLUMN_CHECKBOX, FALSE,
-			    PACKAGES_COLUMN_CHECKBOX_VISIBLE, FALSE,
-			    PACKAGES_COLUMN_TEXT, welcome,
-			    PACKAGES_COLUMN_IMAGE, "system-search",
-			    PACKAGES_COLUMN_SUMMARY, NULL,
-			    PACKAGES_COLUMN_ID, NULL,
+			    GPK_PACKAGES_COLUMN_STATE, state,
+			    GPK_PACKAGES_COLUMN_CHECKBOX, FALSE,
+			    GPK_PACKAGES_COLUMN_CHECKBOX_VISIBLE, FALSE,
+			    GPK_PACKAGES_COLUMN_TEXT, welcome,
+			    GPK_PACKAGES_COLUMN_IMAGE, "system-search",
+			    GPK_PACKAGES_COLUMN_SUMMARY, NULL,
+			    GPK_PACKAGES_COLUMN_ID, NULL,
 			    -1);
 }
 
@@ -2377,18 +3217,67 @@ gpk_application_create_group_array_enum (GpkApplicationPrivate *priv)
 }
 
 static void
-gpk_application_get_categories_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv)
+gpk_application_add_categories (GpkApplicationPrivate *priv, GNode *node, GtkTreeIter *parent)
+{
+	GNode *child;
+	GtkTreeIter iter;
+
+	for (child = node->children; child != NULL; child = child->next) {
+		PkCategory *item = child->data;
+
+		gtk_tree_store_insert_with_values (priv->groups_store, &iter, parent, -1,
+						   GROUPS_COLUMN_NAME, pk_category_get_name (item),
+						   GROUPS_COLUMN_SUMMARY, pk_category_get_summary (item),
+						   GROUPS_COLUMN_ID, pk_category_get_id (item),
+						   GROUPS_COLUMN_ICON, pk_category_get_icon (item),
+						   GROUPS_COLUMN_ACTIVE, parent != NULL,
+						   -1);
+		if (child->children != NULL)
+			gpk_application_add_categories (priv, child, &iter);
+	}
+}
+
+static void
+gpk_application_set_interactive (GpkApplicationPrivate *priv)
 {
+	if (priv->is_interactive)
+		return;
+	priv->is_interactive = TRUE;
+	gpk_trace_interactive (GTK_WIDGET (gtk_builder_get_object (priv->builder, "window_manager")));
+}
+
+static void
+gpk_application_add_category_results (GpkApplicationPrivate *priv, PkResults *results, guint trace)
+{
+	g_autoptr(GPtrArray) array = NULL;
+	GNode *tree;
+	GtkTreeView *treeview;
+
+	/* set to expanders with indent */
+	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_groups"));
+	gtk_tree_view_set_show_expanders (treeview, TRUE);
+	gtk_tree_view_set_level_indentation  (treeview, 3);
+
+	/* add categories at any depth, the top level ones are just headings */
+	array = pk_results_get_category_array (results);
+	tree = gpk_category_array_to_tree (array);
+	gpk_application_add_categories (priv, tree, NULL);
+	g_node_destroy (tree);
+
+	/* open all expanders */
+	gtk_tree_view_collapse_all (treeview);
+	gpk_trace_end (trace, GTK_WIDGET (treeview));
+	gpk_application_set_interactive (priv);
+}
+
+static void
+gpk_application_get_categories_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GpkTraceRequest) request = user_data;
+	GpkApplicationPrivate *priv = request->user_data;
 	g_autoptr(PkResults) results = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(PkError) error_code = NULL;
-	g_autoptr(GPtrArray) array = NULL;
-	GtkTreeIter iter;
-	GtkTreeIter iter2;
-	guint i, j;
-	GtkTreeView *treeview;
-	PkCategory *item;
-	PkCategory *item2;
 	GtkWindow *window;
 
 	/* get the results */
@@ -2397,14 +3286,17 @@ gpk_application_get_categories_cb (PkClient *client, GAsyncResult *res, GpkAppli
 		g_warning ("failed to get list of categories: %s", error->message);
 		return;
 	}
+	gpk_trace_mark (request->token, GPK_TRACE_MARK_FINISHED);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
 	if (error_code != NULL) {
 		g_warning ("failed to get cats: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
 
-		/* if obvious message, don't tell the user */
-		if (pk_error_get_code (error_code) != PK_ERROR_ENUM_TRANSACTION_CANCELLED) {
+		/* if obvious message, don't tell the user; the request is
+		 * sent at startup before we know if the backend supports it */
+		if (pk_error_get_code (error_code) != PK_ERROR_ENUM_TRANSACTION_CANCELLED &&
+		    pk_error_get_code (error_code) != PK_ERROR_ENUM_NOT_SUPPORTED) {
 			window = GTK_WINDOW (gtk_builder_get_object (priv->builder, "window_manager"));
 			gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
 						gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
@@ -2412,82 +3304,29 @@ gpk_application_get_categories_cb (PkClient *client, GAsyncResult *res, GpkAppli
 		return;
 	}
 
-	/* set to expanders with indent */
-	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_groups"));
-	gtk_tree_view_set_show_expanders (treeview, TRUE);
-	gtk_tree_view_set_level_indentation  (treeview, 3);
-
-	/* add repos with descriptions */
-	array = pk_results_get_category_array (results);
-	for (i = 0; i < array->len; i++) {
-		g_autofree gchar *package_id = NULL;
-		g_autofree gchar *name = NULL;
-		g_autofree gchar *summary = NULL;
-		g_autofree gchar *cat_id = NULL;
-		g_autofree gchar *icon = NULL;
-
-		item = g_ptr_array_index (array, i);
-		g_object_get (item,
-			      "name", &name,
-			      "summary", &summary,
-			      "cat-id", &cat_id,
-			      "icon", &icon,
-			      NULL);
-
-		gtk_tree_store_append (priv->groups_store, &iter, NULL);
-		gtk_tree_store_set (priv->groups_store, &iter,
-				    GROUPS_COLUMN_NAME, name,
-				    GROUPS_COLUMN_SUMMARY, summary,
-				    GROUPS_COLUMN_ID, cat_id,
-				    GROUPS_COLUMN_ICON, icon,
-				    GROUPS_COLUMN_ACTIVE, FALSE,
-				    -1);
-		j = 0;
-		do {
-			g_autofree gchar *cat_id_tmp = NULL;
-			g_autofree gchar *icon_tmp = NULL;
-			g_autofree gchar *name_tmp = NULL;
-			g_autofree gchar *parent_id_tmp = NULL;
-			g_autofree gchar *summary_tmp = NULL;
-
-			/* only allows groups two layers deep */
-			item2 = g_ptr_array_index (array, j);
-			g_object_get (item2,
-				      "parent-id", &parent_id_tmp,
-				      "cat-id", &cat_id_tmp,
-				      "name", &name_tmp,
-				      "summary", &summary_tmp,
-				      "icon", &icon_tmp,
-				      NULL);
-			if (g_strcmp0 (parent_id_tmp, cat_id) == 0) {
-				gtk_tree_store_append (priv->groups_store, &iter2, &iter);
-				gtk_tree_store_set (priv->groups_store, &iter2,
-						    GROUPS_COLUMN_NAME, name_tmp,
-						    GROUPS_COLUMN_SUMMARY, summary_tmp,
-						    GROUPS_COLUMN_ID, cat_id_tmp,
-						    GROUPS_COLUMN_ICON, icon_tmp,
-						    GROUPS_COLUMN_ACTIVE, TRUE,
-						    -1);
-				g_ptr_array_remove (array, item2);
-			} else
-				j++;
-		} while (j < array->len);
+	/* the categories go after the groups added from the properties */
+	if (!priv->has_properties) {
+		g_set_object (&priv->categories, results);
+		priv->categories_trace = request->token;
+		request->token = 0;
+		return;
 	}
-
-	/* open all expanders */
-	gtk_tree_view_collapse_all (treeview);
+	gpk_application_add_category_results (priv, results, request->token);
 }
 
 static void
 gpk_application_create_group_array_categories (GpkApplicationPrivate *priv)
 {
+	GpkTraceRequest *request;
+
 	/* ensure new action succeeds */
 	g_cancellable_reset (priv->cancellable);
 
 	/* get categories supported */
+	request = gpk_trace_request_new (PK_ROLE_ENUM_GET_CATEGORIES, priv);
 	pk_client_get_categories_async (PK_CLIENT(priv->task), priv->cancellable,
-				        (PkProgressCallback) gpk_application_progress_cb, priv,
-				        (GAsyncReadyCallback) gpk_application_get_categories_cb, priv);
+				        (PkProgressCallback) gpk_application_progress_cb, request,
+				        (GAsyncReadyCallback) gpk_application_get_categories_cb, request);
 }
 
 static void
@@ -2544,6 +3383,7 @@ pk_backend_status_get_properties_cb (GObject *object, GAsyncResult *res, GpkAppl
 		      "filters", &filters,
 		      "groups", &priv->groups,
 		      NULL);
+	priv->has_properties = TRUE;
 
 	/* Remove description/file array if needed. */
 	if (pk_bitfield_contain (priv->roles, PK_ROLE_ENUM_GET_DETAILS) == FALSE) {
@@ -2597,12 +3437,19 @@ pk_backend_status_get_properties_cb (GObject *object, GAsyncResult *res, GpkAppl
 					      (GtkTreeViewRowSeparatorFunc) gpk_application_group_row_separator_func,
 					      priv, NULL);
 
-	/* simple array or category tree? */
+	/* simple array or category tree? the categories were requested at
+	 * startup, and may have already arrived */
 	ret = g_settings_get_boolean (priv->settings, GPK_SETTINGS_CATEGORY_GROUPS);
-	if (ret && pk_bitfield_contain (priv->roles, PK_ROLE_ENUM_GET_CATEGORIES))
-		gpk_application_create_group_array_categories (priv);
-	else
+	if (ret && pk_bitfield_contain (priv->roles, PK_ROLE_ENUM_GET_CATEGORIES)) {
+		if (priv->categories != NULL)
+			gpk_application_add_category_results (priv, priv->categories, priv->categories_trace);
+	} else {
 		gpk_application_create_group_array_enum (priv);
+		gpk_application_set_interactive (priv);
+	}
+	gpk_trace_end (priv->categories_trace, NULL);
+	priv->categories_trace = 0;
+	g_clear_object (&priv->categories);
 
 	/* set the search mode */
 	priv->search_type = g_settings_get_enum (priv->settings, GPK_SETTINGS_SEARCH_MODE);
@@ -2639,11 +3486,16 @@ pk_backend_status_get_properties_cb (GObject *object, GAsyncResult *res, GpkAppl
 
 	/* welcome */
 	gpk_application_add_welcome (priv);
+
+	/* warm up the groups used most */
+	gpk_application_prefetch_schedule (priv);
 }
 
 static void
-gpk_application_get_repo_list_cb (PkClient *client, GAsyncResult *res, GpkApplicationPrivate *priv)
+gpk_application_get_repo_list_cb (PkClient *client, GAsyncResult *res, gpointer user_data)
 {
+	g_autoptr(GpkTraceRequest) request = user_data;
+	GpkApplicationPrivate *priv = request->user_data;
 	g_autoptr(PkResults) results = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(PkError) error_code = NULL;
@@ -2658,6 +3510,7 @@ gpk_application_get_repo_list_cb (PkClient *client, GAsyncResult *res, GpkApplic
 		g_warning ("failed to get list of repos: %s", error->message);
 		return;
 	}
+	gpk_trace_end (request->token, NULL);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -2708,25 +3561,76 @@ gpk_application_startup_cb (GtkApplication *application, GpkApplicationPrivate *
 	GtkTreeSelection *selection;
 	GtkWidget *main_window;
 	GtkWidget *widget;
+	GpkTraceRequest *request;
 	guint retval;
 
 	priv->package_sack = pk_package_sack_new ();
+	priv->package_queue = g_hash_table_new_full (g_str_hash, g_str_equal,
+						     g_free, (GDestroyNotify) g_object_unref);
+	priv->queue_rows = g_hash_table_new_full (g_str_hash, g_str_equal,
+						  g_free, (GDestroyNotify) g_array_unref);
 	priv->settings = g_settings_new (GPK_SETTINGS_SCHEMA);
 	priv->cancellable = g_cancellable_new ();
 	priv->repos = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	priv->depends_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						     (GDestroyNotify) g_ptr_array_unref);
+	priv->search_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						    (GDestroyNotify) g_ptr_array_unref);
+	priv->search_cache_keys = g_queue_new ();
+	priv->group_usage = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	gpk_application_group_usage_load (priv);
+	priv->control = pk_control_new ();
+
+	/* this is what we use mainly */
+	priv->task = PK_TASK (gpk_task_new ());
+	g_object_set (priv->task,
+		      "background", FALSE,
+		      NULL);
+
+	/* for installs and removals that were already confirmed together */
+	priv->apply_task = PK_TASK (gpk_task_new ());
+	g_object_set (priv->apply_task,
+		      "background", FALSE,
+		      NULL);
+	pk_task_set_simulate (priv->apply_task, FALSE);
+
+	/* the daemon should run anything else first */
+	priv->prefetch_client = pk_client_new ();
+	g_object_set (priv->prefetch_client,
+		      "background", TRUE,
+		      "interactive", FALSE,
+		      NULL);
+
+	/* send all the queries that do not depend on each other before
+	 * building the UI, none of the results can arrive until we return */
+	pk_control_get_properties_async (priv->control, NULL, (GAsyncReadyCallback) pk_backend_status_get_properties_cb, priv);
+	g_signal_connect (priv->control, "notify::network-state",
+			  G_CALLBACK (gpk_application_notify_network_state_cb), priv);
+	g_signal_connect (priv->control, "updates-changed",
+			  G_CALLBACK (gpk_application_updates_changed_cb), priv);
+	g_signal_connect (priv->control, "repo-list-changed",
+			  G_CALLBACK (gpk_application_repo_list_changed_cb), priv);
+	g_signal_connect (priv->control, "transaction-list-changed",
+			  G_CALLBACK (gpk_application_transaction_list_changed_cb), priv);
+
+	/* get repos, so we can show the full name in the package source box */
+	request = gpk_trace_request_new (PK_ROLE_ENUM_GET_REPO_LIST, priv);
+	pk_client_get_repo_list_async (PK_CLIENT (priv->task),
+				       pk_bitfield_value (PK_FILTER_ENUM_NONE),
+				       priv->cancellable,
+				       (PkProgressCallback) gpk_application_progress_cb, request,
+				       (GAsyncReadyCallback) gpk_application_get_repo_list_cb, request);
+
+	/* the categories are slow, so ask before we know if they are
+	 * supported and ignore the results if they are not */
+	if (g_settings_get_boolean (priv->settings, GPK_SETTINGS_CATEGORY_GROUPS))
+		gpk_application_create_group_array_categories (priv);
 
 	/* watch gnome-packagekit keys */
 	g_signal_connect (priv->settings, "changed", G_CALLBACK (gpk_application_key_changed_cb), priv);
 
 	/* create array stores */
-	priv->packages_store = gtk_list_store_new (PACKAGES_COLUMN_LAST,
-					      G_TYPE_STRING,
-					      G_TYPE_UINT64,
-					      G_TYPE_BOOLEAN,
-					      G_TYPE_BOOLEAN,
-					      G_TYPE_STRING,
-					      G_TYPE_STRING,
-					      G_TYPE_STRING);
+	priv->packages_store = gpk_packages_store_new ();
 	priv->groups_store = gtk_tree_store_new (GROUPS_COLUMN_LAST,
 					   G_TYPE_STRING,
 					   G_TYPE_STRING,
@@ -2740,19 +3644,6 @@ gpk_application_startup_cb (GtkApplication *application, GpkApplicationPrivate *
 	gtk_icon_theme_append_search_path (gtk_icon_theme_get_default (),
 					   "/usr/share/gnome-packagekit/icons");
 
-	priv->control = pk_control_new ();
-
-	/* this is what we use mainly */
-	priv->task = PK_TASK (gpk_task_new ());
-	g_object_set (priv->task,
-		      "background", FALSE,
-		      NULL);
-
-	/* get properties */
-	pk_control_get_properties_async (priv->control, NULL, (GAsyncReadyCallback) pk_backend_status_get_properties_cb, priv);
-	g_signal_connect (priv->control, "notify::network-state",
-			  G_CALLBACK (gpk_application_notify_network_state_cb), priv);
-
 	/* get UI */
 	priv->builder = gtk_builder_new ();
 	retval = gtk_builder_add_from_resource (priv->builder,
@@ -2854,16 +3745,13 @@ gpk_application_startup_cb (GtkApplication *application, GpkApplicationPrivate *
 	g_signal_connect (GTK_TREE_VIEW (widget), "row-activated",
 			  G_CALLBACK (gpk_application_package_row_activated_cb), priv);
 
-	/* sorted */
-	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (priv->packages_store),
-					      PACKAGES_COLUMN_ID, GTK_SORT_ASCENDING);
-
 	/* create package tree view */
 	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_packages"));
 	gtk_tree_view_set_model (GTK_TREE_VIEW (widget),
 				 GTK_TREE_MODEL (priv->packages_store));
 
 	selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (widget));
+	gtk_tree_selection_set_mode (selection, GTK_SELECTION_MULTIPLE);
 	g_signal_connect (selection, "changed",
 			  G_CALLBACK (gpk_application_packages_treeview_clicked_cb), priv);
 
@@ -2885,15 +3773,6 @@ gpk_application_startup_cb (GtkApplication *application, GpkApplicationPrivate *
 	g_signal_connect (selection, "changed",
 			  G_CALLBACK (gpk_application_groups_treeview_changed_cb), priv);
 
-	/* get repos, so we can show the full name in the package source box */
-	pk_client_get_repo_list_async (PK_CLIENT (priv->task),
-				       pk_bitfield_value (PK_FILTER_ENUM_NONE),
-				       priv->cancellable,
-				       (PkProgressCallback) gpk_application_progress_cb, priv,
-				       (GAsyncReadyCallback) gpk_application_get_repo_list_cb, priv);
-
-	/* set current action */
-	priv->action = GPK_ACTION_NONE;
 	gpk_application_change_queue_status (priv);
 
 	/* sync toggles */
@@ -2989,6 +3868,7 @@ main (int argc, char *argv[])
 
 	/* are we already activated? */
 	priv->application = gtk_application_new ("org.gnome.Packages", 0);
+	gpk_debug_add_dump_action (G_ACTION_MAP (priv->application));
 	g_signal_connect (priv->application, "startup",
 			  G_CALLBACK (gpk_application_startup_cb), priv);
 	g_signal_connect (priv->application, "activate",
@@ -3017,6 +3897,8 @@ main (int argc, char *argv[])
 		g_object_unref (priv->control);
 	if (priv->task != NULL)
 		g_object_unref (priv->task);
+	if (priv->apply_task != NULL)
+		g_object_unref (priv->apply_task);
 	if (priv->settings != NULL)
 		g_object_unref (priv->settings);
 	if (priv->builder != NULL)
@@ -3025,13 +3907,46 @@ main (int argc, char *argv[])
 		g_object_unref (priv->cancellable);
 	if (priv->package_sack != NULL)
 		g_object_unref (priv->package_sack);
+	if (priv->simulate_install != NULL)
+		g_object_unref (priv->simulate_install);
+	if (priv->package_queue != NULL)
+		g_hash_table_unref (priv->package_queue);
+	if (priv->queue_rows != NULL)
+		g_hash_table_unref (priv->queue_rows);
+	if (priv->categories != NULL)
+		g_object_unref (priv->categories);
 	if (priv->repos != NULL)
 		g_hash_table_destroy (priv->repos);
+	if (priv->depends_cache != NULL)
+		g_hash_table_unref (priv->depends_cache);
+	if (priv->search_cache != NULL)
+		g_hash_table_unref (priv->search_cache);
+	if (priv->search_cache_keys != NULL)
+		g_queue_free (priv->search_cache_keys);
 	if (priv->status_id > 0)
 		g_source_remove (priv->status_id);
+	if (priv->page_id > 0)
+		g_source_remove (priv->page_id);
+	if (priv->prefetch_id > 0)
+		g_source_remove (priv->prefetch_id);
+	if (priv->prefetch_cancellable != NULL) {
+		g_cancellable_cancel (priv->prefetch_cancellable);
+		g_object_unref (priv->prefetch_cancellable);
+	}
+	if (priv->prefetch_client != NULL)
+		g_object_unref (priv->prefetch_client);
+	if (priv->group_usage != NULL)
+		g_hash_table_unref (priv->group_usage);
+	if (priv->page_array != NULL)
+		g_ptr_array_unref (priv->page_array);
 	g_free (priv->homepage_url);
 	g_free (priv->search_group);
 	g_free (priv->search_text);
+	g_free (priv->search_key);
+	g_free (priv->prefetch_key);
+	g_free (priv->prefetch_tid);
+	g_strfreev (priv->prefetch_tids);
+	g_strfreev (priv->apply_install_ids);
 	g_free (priv);
 
 	return status;
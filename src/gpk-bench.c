@@ -0,0 +1,287 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2007-2013 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <gtk/gtk.h>
+#include <locale.h>
+
+#include "gpk-common.h"
+#include "gpk-enum.h"
+#include "gpk-log-record.h"
+
+/* each workload is run this many times and the fastest run is reported */
+#define GPK_BENCH_RUNS		3
+
+typedef struct {
+	GPtrArray	*package_ids;
+	GPtrArray	*summaries;
+	GPtrArray	*updates;
+	GPtrArray	*records;
+	GPtrArray	*categories;
+	guint		 scale;
+} GpkBenchData;
+
+typedef void (*GpkBenchFunc) (GpkBenchData *data);
+
+static const PkInfoEnum update_kinds[] = {
+	PK_INFO_ENUM_SECURITY,
+	PK_INFO_ENUM_BUGFIX,
+	PK_INFO_ENUM_ENHANCEMENT,
+	PK_INFO_ENUM_NORMAL,
+};
+
+static void
+gpk_bench_format_twoline (GpkBenchData *data)
+{
+	guint i;
+
+	for (i = 0; i < data->scale; i++) {
+		g_autofree gchar *text = NULL;
+		text = gpk_package_id_format_twoline (NULL,
+						      g_ptr_array_index (data->package_ids, i),
+						      g_ptr_array_index (data->summaries, i));
+	}
+}
+
+static void
+gpk_bench_log_parse (GpkBenchData *data)
+{
+	guint i;
+
+	g_ptr_array_set_size (data->records, 0);
+	for (i = 0; i < data->scale; i++) {
+		GpkLogRecord *record;
+		g_autofree gchar *tid = NULL;
+		g_autofree gchar *timespec = NULL;
+		g_autoptr(GString) transaction_data = g_string_new (NULL);
+		guint j;
+
+		/* five packages per transaction is typical for an update */
+		for (j = 0; j < 5; j++) {
+			g_string_append_printf (transaction_data, "%s\t%s\n",
+						pk_info_enum_to_string (PK_INFO_ENUM_UPDATING),
+						(const gchar *) g_ptr_array_index (data->package_ids,
+										   (i * 5 + j) % data->scale));
+		}
+		tid = g_strdup_printf ("/%u_abcdefgh", i);
+		timespec = g_strdup_printf ("2023-%02u-%02uT10:%02u:00Z",
+					    (i % 12) + 1, (i % 28) + 1, i % 60);
+		record = gpk_log_record_new (tid, timespec, TRUE,
+					     PK_ROLE_ENUM_UPDATE_PACKAGES, 1000 + i,
+					     transaction_data->str, 1000,
+					     "/usr/bin/gpk-update-viewer");
+		g_ptr_array_add (data->records, record);
+	}
+}
+
+static void
+gpk_bench_log_filter (GpkBenchData *data)
+{
+	guint i;
+	guint matches = 0;
+
+	for (i = 0; i < data->records->len; i++) {
+		if (gpk_log_record_match (g_ptr_array_index (data->records, i), "pkg42"))
+			matches++;
+	}
+	g_debug ("%u matches", matches);
+}
+
+static void
+gpk_bench_package_list (GpkBenchData *data)
+{
+	GtkTreeIter iter;
+	guint i;
+	g_autoptr(GtkListStore) store = NULL;
+
+	/* the text is only formatted for the rows that are drawn */
+	store = gpk_packages_store_new ();
+	for (i = 0; i < data->scale; i++) {
+		gpk_packages_store_add (store, &iter,
+					g_ptr_array_index (data->package_ids, i),
+					g_ptr_array_index (data->summaries, i),
+					0);
+	}
+}
+
+static void
+gpk_bench_update_tree (GpkBenchData *data)
+{
+	guint i;
+	g_autoptr(GtkTreeStore) store = NULL;
+
+	store = gpk_updates_store_new ();
+	for (i = 0; i < data->scale; i++)
+		gpk_updates_store_add (store, NULL, g_ptr_array_index (data->updates, i), TRUE);
+}
+
+static void
+gpk_bench_category_tree (GpkBenchData *data)
+{
+	GNode *tree;
+
+	tree = gpk_category_array_to_tree (data->categories);
+	g_node_destroy (tree);
+}
+
+static GpkBenchData *
+gpk_bench_data_new (guint scale)
+{
+	GpkBenchData *data;
+	guint i;
+
+	data = g_new0 (GpkBenchData, 1);
+	data->scale = scale;
+	data->package_ids = g_ptr_array_new_with_free_func (g_free);
+	data->summaries = g_ptr_array_new_with_free_func (g_free);
+	data->updates = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	data->records = g_ptr_array_new_with_free_func ((GDestroyNotify) gpk_log_record_free);
+	data->categories = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 0; i < scale; i++) {
+		PkCategory *category = pk_category_new ();
+		PkPackage *package = pk_package_new ();
+		guint cat = scale - i - 1;
+		g_autofree gchar *cat_id = NULL;
+		g_autofree gchar *parent_id = NULL;
+
+		g_ptr_array_add (data->package_ids,
+				 g_strdup_printf ("pkg%u;%u.%u.%u-1.fc40;%s;fedora",
+						  i, i % 7, i % 13, i % 101,
+						  i % 3 == 0 ? "i686" : "x86_64"));
+		g_ptr_array_add (data->summaries,
+				 g_strdup_printf ("Synthetic package number %u for benchmarking", i));
+
+		/* spread over the kinds of update, like a real update list */
+		pk_package_set_id (package, g_ptr_array_index (data->package_ids, i), NULL);
+		g_object_set (package,
+			      "info", update_kinds[i % G_N_ELEMENTS (update_kinds)],
+			      "summary", g_ptr_array_index (data->summaries, i),
+			      NULL);
+		g_ptr_array_add (data->updates, package);
+
+		/* four children per category, added children first */
+		cat_id = g_strdup_printf ("cat-%u", cat);
+		if (cat > 0)
+			parent_id = g_strdup_printf ("cat-%u", (cat - 1) / 4);
+		pk_category_set_id (category, cat_id);
+		pk_category_set_parent_id (category, parent_id != NULL ? parent_id : "");
+		pk_category_set_name (category, cat_id);
+		g_ptr_array_add (data->categories, category);
+	}
+	return data;
+}
+
+static void
+gpk_bench_data_free (GpkBenchData *data)
+{
+	g_ptr_array_unref (data->package_ids);
+	g_ptr_array_unref (data->summaries);
+	g_ptr_array_unref (data->updates);
+	g_ptr_array_unref (data->records);
+	g_ptr_array_unref (data->categories);
+	g_free (data);
+}
+
+static void
+gpk_bench_run (GString *json, const gchar *name, GpkBenchFunc func, GpkBenchData *data)
+{
+	gint64 best = G_MAXINT64;
+	guint i;
+
+	for (i = 0; i < GPK_BENCH_RUNS; i++) {
+		gint64 start = g_get_monotonic_time ();
+		gint64 elapsed;
+
+		func (data);
+		elapsed = g_get_monotonic_time () - start;
+		if (elapsed < best)
+			best = elapsed;
+	}
+	if (json->str[json->len - 1] == '}')
+		g_string_append (json, ",");
+	g_string_append_printf (json,
+				"\n    {\"name\": \"%s\", \"items\": %u, "
+				"\"usec\": %" G_GINT64_FORMAT ", \"ns_per_item\": %.1f}",
+				name, data->scale, best,
+				(gdouble) best * 1000.0 / data->scale);
+}
+
+int
+main (int argc, char *argv[])
+{
+	const guint scales[] = { 1000, 10000, 100000 };
+	gint max_scale = 100000;
+	guint i;
+	g_autofree gchar *output = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GOptionContext) context = NULL;
+	g_autoptr(GString) json = NULL;
+
+	const GOptionEntry options[] = {
+		{ "output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+		  "Write the results to a file rather than stdout", NULL },
+		{ "max-scale", '\0', 0, G_OPTION_ARG_INT, &max_scale,
+		  "Skip the workloads with more items than this", NULL },
+		{ NULL}
+	};
+
+	setlocale (LC_ALL, "");
+
+	context = g_option_context_new (NULL);
+	g_option_context_set_summary (context, "GNOME PackageKit benchmarks");
+	g_option_context_add_main_entries (context, options, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		return 1;
+	}
+
+	/* machine readable, so results can be compared between releases */
+	json = g_string_new ("{\n");
+	g_string_append_printf (json, "  \"version\": \"%s\",\n", PACKAGE_VERSION);
+	g_string_append (json, "  \"results\": [");
+	for (i = 0; i < G_N_ELEMENTS (scales); i++) {
+		GpkBenchData *data;
+
+		if (scales[i] > (guint) max_scale)
+			continue;
+		data = gpk_bench_data_new (scales[i]);
+		gpk_bench_run (json, "format-twoline", gpk_bench_format_twoline, data);
+		gpk_bench_run (json, "log-parse", gpk_bench_log_parse, data);
+		gpk_bench_run (json, "log-filter", gpk_bench_log_filter, data);
+		gpk_bench_run (json, "package-list", gpk_bench_package_list, data);
+		gpk_bench_run (json, "update-tree", gpk_bench_update_tree, data);
+		gpk_bench_run (json, "category-tree", gpk_bench_category_tree, data);
+		gpk_bench_data_free (data);
+	}
+	g_string_append (json, "\n  ]\n}\n");
+
+	if (output == NULL) {
+		g_print ("%s", json->str);
+		return 0;
+	}
+	if (!g_file_set_contents (output, json->str, json->len, &error)) {
+		g_printerr ("failed to write %s: %s\n", output, error->message);
+		return 1;
+	}
+	return 0;
+}
@@ -322,3 +322,404 @@ gpk_strv_join_locale (gchar **array)
 					array[3], array[4]);
 	return NULL;
 }
+
+/**
+ * gpk_category_array_to_tree:
+ * @array: an array of #PkCategory objects
+ *
+ * Arranges the categories into a tree using their parent-id. Each category is
+ * read once and children keep the order they had in @array. Categories whose
+ * parent does not exist are added at the top level.
+ *
+ * The node data points at the #PkCategory objects in @array, so the array
+ * must outlive the tree. Free the tree with g_node_destroy().
+ *
+ * Return value: the root node, which has no data
+ **/
+GNode *
+gpk_category_array_to_tree (GPtrArray *array)
+{
+	GNode *root;
+	GNode *node;
+	GPtrArray *children;
+	guint i;
+	guint added = 0;
+	g_autoptr(GHashTable) ids = NULL;
+	g_autoptr(GHashTable) parents = NULL;
+	g_autoptr(GQueue) queue = NULL;
+
+	/* index by cat-id, and parent-id -> children */
+	ids = g_hash_table_new (g_str_hash, g_str_equal);
+	parents = g_hash_table_new_full (g_str_hash, g_str_equal,
+					 NULL, (GDestroyNotify) g_ptr_array_unref);
+	for (i = 0; i < array->len; i++) {
+		PkCategory *item = g_ptr_array_index (array, i);
+		const gchar *cat_id = pk_category_get_id (item);
+		const gchar *parent_id = pk_category_get_parent_id (item);
+
+		if (cat_id != NULL && !g_hash_table_contains (ids, cat_id))
+			g_hash_table_insert (ids, (gpointer) cat_id, item);
+		if (parent_id == NULL || parent_id[0] == '\0')
+			continue;
+		children = g_hash_table_lookup (parents, parent_id);
+		if (children == NULL) {
+			children = g_ptr_array_new ();
+			g_hash_table_insert (parents, (gpointer) parent_id, children);
+		}
+		g_ptr_array_add (children, item);
+	}
+
+	/* anything without a known parent goes at the top level */
+	root = g_node_new (NULL);
+	queue = g_queue_new ();
+	for (i = 0; i < array->len; i++) {
+		PkCategory *item = g_ptr_array_index (array, i);
+		const gchar *parent_id = pk_category_get_parent_id (item);
+
+		if (parent_id != NULL &&
+		    parent_id[0] != '\0' &&
+		    g_hash_table_contains (ids, parent_id) &&
+		    g_strcmp0 (parent_id, pk_category_get_id (item)) != 0)
+			continue;
+		node = g_node_append_data (root, item);
+		g_queue_push_tail (queue, node);
+		added++;
+	}
+
+	/* breadth first, so there is no limit on the depth; each list of
+	 * children is taken out of the index once used, which also stops a
+	 * duplicated cat-id or a loop adding anything twice */
+	while ((node = g_queue_pop_head (queue)) != NULL) {
+		const gchar *cat_id = pk_category_get_id (node->data);
+
+		if (cat_id == NULL)
+			continue;
+		children = g_hash_table_lookup (parents, cat_id);
+		if (children == NULL)
+			continue;
+		g_hash_table_steal (parents, cat_id);
+		for (i = 0; i < children->len; i++) {
+			PkCategory *item = g_ptr_array_index (children, i);
+			GNode *child;
+
+			/* its own parent, so added at the top level already */
+			if (g_strcmp0 (pk_category_get_parent_id (item),
+				       pk_category_get_id (item)) == 0)
+				continue;
+			child = g_node_append_data (node, item);
+			g_queue_push_tail (queue, child);
+			added++;
+		}
+		g_ptr_array_unref (children);
+	}
+
+	/* only categories in a parent-id loop are left over */
+	if (added != array->len)
+		g_warning ("ignored %u categories with a parent-id loop",
+			   array->len - added);
+	return root;
+}
+
+/**
+ * gpk_package_state_get_icon:
+ * @state: a bitfield of #GpkPackageState
+ *
+ * Return value: the icon to show for a row of the package list
+ **/
+const gchar *
+gpk_package_state_get_icon (PkBitfield state)
+{
+	if (state == 0)
+		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_AVAILABLE);
+
+	if (state == pk_bitfield_value (GPK_PACKAGE_STATE_INSTALLED))
+		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_INSTALLED);
+
+	if (state == pk_bitfield_value (GPK_PACKAGE_STATE_IN_LIST))
+		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_INSTALLING);
+
+	if (state == pk_bitfield_from_enums (GPK_PACKAGE_STATE_INSTALLED, GPK_PACKAGE_STATE_IN_LIST, -1))
+		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_REMOVING);
+
+	if (state == pk_bitfield_value (GPK_PACKAGE_STATE_COLLECTION))
+		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_COLLECTION_AVAILABLE);
+
+	if (state == pk_bitfield_from_enums (GPK_PACKAGE_STATE_INSTALLED, GPK_PACKAGE_STATE_COLLECTION, -1))
+		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_COLLECTION_INSTALLED);
+
+	if (state == pk_bitfield_from_enums (GPK_PACKAGE_STATE_IN_LIST, GPK_PACKAGE_STATE_INSTALLED, GPK_PACKAGE_STATE_COLLECTION, -1))
+		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_REMOVING); // need new icon
+
+	if (state == pk_bitfield_from_enums (GPK_PACKAGE_STATE_IN_LIST, GPK_PACKAGE_STATE_COLLECTION, -1))
+		return gpk_info_enum_to_icon_name (PK_INFO_ENUM_INSTALLING); // need new icon
+
+	return NULL;
+}
+
+/**
+ * gpk_package_state_get_checkbox:
+ * @state: a bitfield of #GpkPackageState
+ *
+ * Return value: %TRUE if the checkbox of a row of the package list is ticked
+ **/
+gboolean
+gpk_package_state_get_checkbox (PkBitfield state)
+{
+	PkBitfield state_local;
+
+	/* remove any we don't care about */
+	state_local = state;
+	pk_bitfield_remove (state_local, GPK_PACKAGE_STATE_COLLECTION);
+
+	/* installed or in array */
+	if (state_local == pk_bitfield_value (GPK_PACKAGE_STATE_INSTALLED) ||
+	    state_local == pk_bitfield_value (GPK_PACKAGE_STATE_IN_LIST))
+		return TRUE;
+	return FALSE;
+}
+
+static gint
+gpk_packages_store_sort_cb (GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b, gpointer user_data)
+{
+	g_autofree gchar *package_id_a = NULL;
+	g_autofree gchar *package_id_b = NULL;
+
+	gtk_tree_model_get (model, a, GPK_PACKAGES_COLUMN_ID, &package_id_a, -1);
+	gtk_tree_model_get (model, b, GPK_PACKAGES_COLUMN_ID, &package_id_b, -1);
+	return g_strcmp0 (package_id_a, package_id_b);
+}
+
+/**
+ * gpk_packages_store_new:
+ *
+ * Creates the store for the package list, sorted by package-id in the same
+ * order as the search results are added.
+ *
+ * Return value: a new #GtkListStore with the #GpkPackagesColumn columns
+ **/
+GtkListStore *
+gpk_packages_store_new (void)
+{
+	GtkListStore *store;
+
+	store = gtk_list_store_new (GPK_PACKAGES_COLUMN_LAST,
+				    G_TYPE_STRING,
+				    G_TYPE_UINT64,
+				    G_TYPE_BOOLEAN,
+				    G_TYPE_BOOLEAN,
+				    G_TYPE_STRING,
+				    G_TYPE_STRING,
+				    G_TYPE_STRING);
+	gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (store),
+					 GPK_PACKAGES_COLUMN_ID,
+					 gpk_packages_store_sort_cb,
+					 NULL, NULL);
+	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store),
+					      GPK_PACKAGES_COLUMN_ID, GTK_SORT_ASCENDING);
+	return store;
+}
+
+/**
+ * gpk_packages_store_add:
+ * @iter: (out): the new row
+ * @state: a bitfield of #GpkPackageState
+ *
+ * Adds a package to the package list. The text is left empty, as it is
+ * only formatted when the row is drawn.
+ **/
+void
+gpk_packages_store_add (GtkListStore *store,
+			GtkTreeIter *iter,
+			const gchar *package_id,
+			const gchar *summary,
+			PkBitfield state)
+{
+	gtk_list_store_append (store, iter);
+	gtk_list_store_set (store, iter,
+			    GPK_PACKAGES_COLUMN_STATE, state,
+			    GPK_PACKAGES_COLUMN_CHECKBOX, gpk_package_state_get_checkbox (state),
+			    GPK_PACKAGES_COLUMN_CHECKBOX_VISIBLE, TRUE,
+			    GPK_PACKAGES_COLUMN_SUMMARY, summary,
+			    GPK_PACKAGES_COLUMN_ID, package_id,
+			    GPK_PACKAGES_COLUMN_IMAGE, gpk_package_state_get_icon (state),
+			    -1);
+}
+
+/**
+ * gpk_updates_store_new:
+ *
+ * Return value: a new #GtkTreeStore with the #GpkUpdatesColumn columns
+ **/
+GtkTreeStore *
+gpk_updates_store_new (void)
+{
+	return gtk_tree_store_new (GPK_UPDATES_COLUMN_LAST, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_INT,
+				   G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN,
+				   G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT,
+				   G_TYPE_UINT, G_TYPE_POINTER, G_TYPE_POINTER, G_TYPE_INT, G_TYPE_BOOLEAN);
+}
+
+static const gchar *
+gpk_updates_store_get_header (PkInfoEnum info)
+{
+	const gchar *text = NULL;
+	switch (info) {
+	case PK_INFO_ENUM_LOW:
+		/* TRANSLATORS: The type of update */
+		text = _("Trivial updates");
+		break;
+	case PK_INFO_ENUM_IMPORTANT:
+		/* TRANSLATORS: The type of update */
+		text = _("Important updates");
+		break;
+	case PK_INFO_ENUM_SECURITY:
+		/* TRANSLATORS: The type of update */
+		text = _("Security updates");
+		break;
+	case PK_INFO_ENUM_BUGFIX:
+		/* TRANSLATORS: The type of update */
+		text = _("Bug fix updates");
+		break;
+	case PK_INFO_ENUM_ENHANCEMENT:
+		/* TRANSLATORS: The type of update */
+		text = _("Enhancement updates");
+		break;
+	case PK_INFO_ENUM_BLOCKED:
+		/* TRANSLATORS: The type of update */
+		text = _("Blocked updates");
+		break;
+	default:
+		/* TRANSLATORS: The type of update, i.e. unspecified */
+		text = _("Other updates");
+	}
+	return text;
+}
+
+static void
+gpk_updates_store_get_parent (GtkTreeStore *store, PkInfoEnum info, GtkTreeIter *parent)
+{
+	gboolean is_package;
+	gboolean ret = FALSE;
+	gboolean valid;
+	g_autofree gchar *title = NULL;
+	GtkTreeIter iter;
+	GtkTreeModel *model = GTK_TREE_MODEL (store);
+	PkInfoEnum info_tmp;
+
+	/* get the first iter in the array */
+	valid = gtk_tree_model_get_iter_first (model, &iter);
+
+	/* smush some update states together */
+	switch (info) {
+	case PK_INFO_ENUM_ENHANCEMENT:
+	case PK_INFO_ENUM_LOW:
+		info = PK_INFO_ENUM_NORMAL;
+		break;
+	default:
+		break;
+	}
+
+	/* find out how many we should update */
+	while (valid) {
+		g_autofree gchar *package_id_tmp = NULL;
+		gtk_tree_model_get (model, &iter,
+				    GPK_UPDATES_COLUMN_INFO, &info_tmp,
+				    GPK_UPDATES_COLUMN_ID, &package_id_tmp,
+				    -1);
+		is_package = package_id_tmp != NULL;
+
+		/* right section? */
+		if (!is_package && info_tmp == info) {
+			*parent = iter;
+			ret = TRUE;
+			break;
+		}
+
+		valid = gtk_tree_model_iter_next (model, &iter);
+	}
+
+	/* create */
+	if (!ret) {
+		title = g_strdup_printf ("<b>%s</b>",
+					 gpk_updates_store_get_header (info));
+		gtk_tree_store_append (store, &iter, NULL);
+		gtk_tree_store_set (store, &iter,
+				    GPK_UPDATES_COLUMN_TEXT, title,
+				    GPK_UPDATES_COLUMN_ID, NULL,
+				    GPK_UPDATES_COLUMN_INFO, info,
+				    GPK_UPDATES_COLUMN_SELECT, TRUE,
+				    GPK_UPDATES_COLUMN_VISIBLE, FALSE,
+				    GPK_UPDATES_COLUMN_CLICKABLE, FALSE,
+				    GPK_UPDATES_COLUMN_RESTART, PK_RESTART_ENUM_NONE,
+				    GPK_UPDATES_COLUMN_STATUS, PK_INFO_ENUM_UNKNOWN,
+				    GPK_UPDATES_COLUMN_SIZE, 0,
+				    GPK_UPDATES_COLUMN_SIZE_DISPLAY, 0,
+				    GPK_UPDATES_COLUMN_PERCENTAGE, 0,
+				    GPK_UPDATES_COLUMN_PULSE, -1,
+				    -1);
+		*parent = iter;
+	}
+}
+
+/**
+ * gpk_updates_store_add:
+ * @style: the style to format the text with, or %NULL
+ * @can_select: if the updates can be chosen one by one
+ *
+ * Adds an update below the header for its kind of update, adding the
+ * header first if needed.
+ **/
+void
+gpk_updates_store_add (GtkTreeStore *store,
+		       GtkStyleContext *style,
+		       PkPackage *package,
+		       gboolean can_select)
+{
+	gboolean selected;
+	gboolean sensitive;
+	GtkTreeIter iter;
+	GtkTreeIter parent;
+	PkInfoEnum info;
+	g_autofree gchar *package_id = NULL;
+	g_autofree gchar *summary = NULL;
+	g_autofree gchar *text = NULL;
+
+	/* get data */
+	g_object_get (package,
+		      "info", &info,
+		      "package-id", &package_id,
+		      "summary", &summary,
+		      NULL);
+
+	/* find our parent */
+	gpk_updates_store_get_parent (store, info, &parent);
+
+	/* add to array store */
+	text = gpk_package_id_format_twoline (style, package_id, summary);
+	g_debug ("adding: id=%s, text=%s", package_id, text);
+	selected = (info != PK_INFO_ENUM_BLOCKED);
+
+	/* only make the checkbox selectable if:
+	 *  - we can do UpdatePackages rather than just UpdateSystem
+	 *  - the update is not blocked
+	 */
+	sensitive = selected && can_select;
+
+	/* add to model */
+	gtk_tree_store_append (store, &iter, &parent);
+	gtk_tree_store_set (store, &iter,
+			    GPK_UPDATES_COLUMN_TEXT, text,
+			    GPK_UPDATES_COLUMN_ID, package_id,
+			    GPK_UPDATES_COLUMN_INFO, info,
+			    GPK_UPDATES_COLUMN_SELECT, selected,
+			    GPK_UPDATES_COLUMN_SENSITIVE, sensitive,
+			    GPK_UPDATES_COLUMN_VISIBLE, TRUE,
+			    GPK_UPDATES_COLUMN_CLICKABLE, selected,
+			    GPK_UPDATES_COLUMN_RESTART, PK_RESTART_ENUM_NONE,
+			    GPK_UPDATES_COLUMN_STATUS, PK_INFO_ENUM_UNKNOWN,
+			    GPK_UPDATES_COLUMN_SIZE, 0,
+			    GPK_UPDATES_COLUMN_SIZE_DISPLAY, 0,
+			    GPK_UPDATES_COLUMN_PERCENTAGE, 0,
+			    GPK_UPDATES_COLUMN_PULSE, -1,
+			    -1);
+}
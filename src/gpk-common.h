@@ -42,13 +42,17 @@ G_BEGIN_DECLS
 #define GPK_SETTINGS_FILTER_BASENAME			"filter-basename"
 #define GPK_SETTINGS_FILTER_NEWEST			"filter-newest"
 #define GPK_SETTINGS_FILTER_SUPPORTED			"filter-supported"
+#define GPK_SETTINGS_GROUP_USAGE			"group-usage"
 #define GPK_SETTINGS_IGNORED_DBUS_REQUESTS		"ignored-dbus-requests"
+#define GPK_SETTINGS_LOG_MAX_TRANSACTIONS		"log-max-transactions"
+#define GPK_SETTINGS_LOG_PAGE_SIZE			"log-page-size"
 #define GPK_SETTINGS_ONLY_NEWEST			"only-newest"
 #define GPK_SETTINGS_REPO_SHOW_DETAILS			"repo-show-details"
 #define GPK_SETTINGS_SCROLL_ACTIVE			"scroll-active"
 #define GPK_SETTINGS_SEARCH_MODE			"search-mode"
 #define GPK_SETTINGS_SHOW_ALL_PACKAGES			"show-all-packages"
 #define GPK_SETTINGS_SHOW_DEPENDS			"show-depends"
+#define GPK_SETTINGS_UPDATE_VIEWER_IDLE_TIMEOUT		"update-viewer-idle-timeout"
 
 #define GPK_ICON_SOFTWARE_UPDATE		"system-software-update"
 #define GPK_ICON_SOFTWARE_SOURCES		"gpk-repo"
@@ -59,6 +63,46 @@ G_BEGIN_DECLS
 /* any status that is slower than this will not be shown in the UI */
 #define GPK_UI_STATUS_SHOW_DELAY		750 /* ms */
 
+/* the bits of GPK_PACKAGES_COLUMN_STATE */
+typedef enum {
+	GPK_PACKAGE_STATE_INSTALLED,
+	GPK_PACKAGE_STATE_IN_LIST,
+	GPK_PACKAGE_STATE_COLLECTION,
+	GPK_PACKAGE_STATE_UNKNOWN
+} GpkPackageState;
+
+/* the package list in gpk-application */
+typedef enum {
+	GPK_PACKAGES_COLUMN_IMAGE,
+	GPK_PACKAGES_COLUMN_STATE,  /* state of the item */
+	GPK_PACKAGES_COLUMN_CHECKBOX,  /* what we show in the checkbox */
+	GPK_PACKAGES_COLUMN_CHECKBOX_VISIBLE, /* visible */
+	GPK_PACKAGES_COLUMN_TEXT,
+	GPK_PACKAGES_COLUMN_ID,
+	GPK_PACKAGES_COLUMN_SUMMARY,
+	GPK_PACKAGES_COLUMN_LAST
+} GpkPackagesColumn;
+
+/* the update tree in gpk-update-viewer */
+typedef enum {
+	GPK_UPDATES_COLUMN_TEXT,
+	GPK_UPDATES_COLUMN_ID,
+	GPK_UPDATES_COLUMN_INFO,
+	GPK_UPDATES_COLUMN_SELECT,
+	GPK_UPDATES_COLUMN_SENSITIVE,
+	GPK_UPDATES_COLUMN_CLICKABLE,
+	GPK_UPDATES_COLUMN_RESTART,
+	GPK_UPDATES_COLUMN_SIZE,
+	GPK_UPDATES_COLUMN_SIZE_DISPLAY,
+	GPK_UPDATES_COLUMN_PERCENTAGE,
+	GPK_UPDATES_COLUMN_STATUS,
+	GPK_UPDATES_COLUMN_DETAILS_OBJ,
+	GPK_UPDATES_COLUMN_UPDATE_DETAIL_OBJ,
+	GPK_UPDATES_COLUMN_PULSE,
+	GPK_UPDATES_COLUMN_VISIBLE,
+	GPK_UPDATES_COLUMN_LAST
+} GpkUpdatesColumn;
+
 gchar		*gpk_package_id_format_twoline		(GtkStyleContext *style,
 							 const gchar 	*package_id,
 							 const gchar	*summary);
@@ -74,6 +118,21 @@ gboolean	 gpk_window_set_parent_xid		(GtkWindow	*window,
 							 guint32	 xid);
 GPtrArray	*pk_strv_to_ptr_array			(gchar		**array)
 							 G_GNUC_WARN_UNUSED_RESULT;
+GNode		*gpk_category_array_to_tree		(GPtrArray	*array)
+							 G_GNUC_WARN_UNUSED_RESULT;
+const gchar	*gpk_package_state_get_icon		(PkBitfield	 state);
+gboolean	 gpk_package_state_get_checkbox		(PkBitfield	 state);
+GtkListStore	*gpk_packages_store_new			(void);
+void		 gpk_packages_store_add			(GtkListStore	*store,
+							 GtkTreeIter	*iter,
+							 const gchar	*package_id,
+							 const gchar	*summary,
+							 PkBitfield	 state);
+GtkTreeStore	*gpk_updates_store_new			(void);
+void		 gpk_updates_store_add			(GtkTreeStore	*store,
+							 GtkStyleContext *style,
+							 PkPackage	*package,
+							 gboolean	 can_select);
 
 G_END_DECLS
 
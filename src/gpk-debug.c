@@ -20,6 +20,11 @@
  */
 
 #include <glib/gi18n.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <stdio.h>
 
@@ -29,6 +34,23 @@
 
 static gboolean _verbose = FALSE;
 static gboolean _console = FALSE;
+static gchar *_trace_filename = NULL;
+static FILE *_trace = NULL;
+
+typedef struct {
+	PkRoleEnum	 role;
+	guint		 id;
+	guint		 marks;		/* bitfield of GpkTraceMark */
+	GtkWidget	*widget;
+	gulong		 draw_id;
+} GpkTraceSpan;
+
+/* token -> GpkTraceSpan, for the spans still waiting for results */
+static GHashTable *_trace_spans = NULL;
+static guint _trace_id = 0;
+/* user_data -> GpkTraceRequest, shared by its requests when not tracing */
+static GHashTable *_trace_untraced = NULL;
+static gint64 _trace_start = 0;
 
 static void
 gpk_debug_ignore_cb (const gchar *log_domain, GLogLevelFlags log_level,
@@ -48,51 +70,268 @@ gpk_debug_ignore_cb (const gchar *log_domain, GLogLevelFlags log_level,
 
 #define GPK_DEBUG_LOG_DOMAIN_LENGTH	20
 
+/* formatting state for each thread that logs */
+typedef struct {
+	GString		*line;
+	gint64		 second;
+	gchar		 str_time[16];
+} GpkDebugThread;
+
+static void
+gpk_debug_thread_free (GpkDebugThread *thread)
+{
+	g_string_free (thread->line, TRUE);
+	g_free (thread);
+}
+
+static GPrivate _thread_private = G_PRIVATE_INIT ((GDestroyNotify) gpk_debug_thread_free);
+
+/* whole lines waiting for the writer thread */
+static GString *_pending = NULL;
+static GMutex _pending_lock;
+static GCond _pending_cond;
+static GMutex _write_lock;
+
+/* the last few lines, even when not verbose */
+static gint _ring_size = 0;
+static gchar **_ring = NULL;
+static guint _ring_next = 0;
+static GMutex _ring_lock;
+
+static GpkDebugThread *
+gpk_debug_thread_get (void)
+{
+	GpkDebugThread *thread = g_private_get (&_thread_private);
+	if (thread == NULL) {
+		thread = g_new0 (GpkDebugThread, 1);
+		thread->line = g_string_sized_new (256);
+		thread->second = -1;
+		g_private_set (&_thread_private, thread);
+	}
+	return thread;
+}
+
+static void
+gpk_debug_write_fd (gint fd, const gchar *data, gsize len)
+{
+	while (len > 0) {
+		gssize wrote = write (fd, data, len);
+		if (wrote < 0) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		data += wrote;
+		len -= wrote;
+	}
+}
+
+/* only one writer at a time, so lines never get reordered */
+static void
+gpk_debug_write_pending (void)
+{
+	g_autoptr(GString) data = NULL;
+
+	g_mutex_lock (&_write_lock);
+	g_mutex_lock (&_pending_lock);
+	if (_pending != NULL && _pending->len > 0) {
+		data = _pending;
+		_pending = g_string_sized_new (data->allocated_len);
+	}
+	g_mutex_unlock (&_pending_lock);
+	if (data != NULL)
+		gpk_debug_write_fd (STDOUT_FILENO, data->str, data->len);
+	g_mutex_unlock (&_write_lock);
+}
+
+static gpointer
+gpk_debug_writer_thread_cb (gpointer user_data)
+{
+	while (TRUE) {
+		g_mutex_lock (&_pending_lock);
+		while (_pending->len == 0)
+			g_cond_wait (&_pending_cond, &_pending_lock);
+		g_mutex_unlock (&_pending_lock);
+		gpk_debug_write_pending ();
+	}
+	return NULL;
+}
+
+/**
+ * gpk_debug_flush:
+ *
+ * Writes any debug lines still waiting for the writer thread.
+ **/
+void
+gpk_debug_flush (void)
+{
+	gpk_debug_write_pending ();
+}
+
+static gpointer
+gpk_debug_writer_start_cb (gpointer user_data)
+{
+	_pending = g_string_sized_new (4096);
+	g_thread_unref (g_thread_new ("gpk-debug", gpk_debug_writer_thread_cb, NULL));
+	atexit (gpk_debug_flush);
+	return NULL;
+}
+
+static void
+gpk_debug_queue_line (const gchar *line, gsize len)
+{
+	static GOnce writer_once = G_ONCE_INIT;
+
+	g_once (&writer_once, gpk_debug_writer_start_cb, NULL);
+	g_mutex_lock (&_pending_lock);
+	g_string_append_len (_pending, line, len);
+	g_cond_signal (&_pending_cond);
+	g_mutex_unlock (&_pending_lock);
+}
+
+static void
+gpk_debug_ring_add (GpkDebugThread *thread, const gchar *log_domain, const gchar *message)
+{
+	gchar *line;
+
+	line = g_strdup_printf ("%s\t%s\t%s\n", thread->str_time, log_domain, message);
+	g_mutex_lock (&_ring_lock);
+	g_free (_ring[_ring_next]);
+	_ring[_ring_next] = line;
+	_ring_next = (_ring_next + 1) % _ring_size;
+	g_mutex_unlock (&_ring_lock);
+}
+
+/* also called from the crash handler, so cannot allocate or take locks */
+static void
+gpk_debug_ring_write (gint fd)
+{
+	const gchar header[] = "*** last debug messages ***\n";
+	guint i;
+
+	gpk_debug_write_fd (fd, header, sizeof (header) - 1);
+	for (i = 0; i < (guint) _ring_size; i++) {
+		const gchar *line = _ring[(_ring_next + i) % _ring_size];
+		if (line != NULL)
+			gpk_debug_write_fd (fd, line, strlen (line));
+	}
+}
+
+/**
+ * gpk_debug_dump:
+ *
+ * Writes the ring buffer of recent debug messages to stderr, oldest first.
+ * This does nothing unless --debug-buffer was used.
+ **/
+void
+gpk_debug_dump (void)
+{
+	if (_ring == NULL)
+		return;
+	g_mutex_lock (&_ring_lock);
+	gpk_debug_ring_write (STDERR_FILENO);
+	g_mutex_unlock (&_ring_lock);
+}
+
+static void
+gpk_debug_crash_cb (gint signum)
+{
+	gpk_debug_ring_write (STDERR_FILENO);
+
+	/* the handler has been reset, so this crashes for real */
+	raise (signum);
+}
+
+static void
+gpk_debug_dump_activated_cb (GSimpleAction *action, GVariant *parameter, gpointer user_data)
+{
+	gpk_debug_dump ();
+}
+
+/**
+ * gpk_debug_add_dump_action:
+ *
+ * Adds a "debug-dump" action, so the ring buffer can be dumped over D-Bus
+ * using the org.gtk.Actions interface of a running application.
+ **/
+void
+gpk_debug_add_dump_action (GActionMap *map)
+{
+	g_autoptr(GSimpleAction) action = NULL;
+
+	if (_ring == NULL)
+		return;
+	action = g_simple_action_new ("debug-dump", NULL);
+	g_signal_connect (action, "activate",
+			  G_CALLBACK (gpk_debug_dump_activated_cb), NULL);
+	g_action_map_add_action (map, G_ACTION (action));
+}
+
 static void
 gpk_debug_handler_cb (const gchar *log_domain, GLogLevelFlags log_level,
 		     const gchar *message, gpointer user_data)
 {
-	gchar str_time[255];
-	time_t the_time;
+	GpkDebugThread *thread = gpk_debug_thread_get ();
+	GString *line = thread->line;
+	gint64 second;
 	guint len;
-	guint i;
 
-	/* time header */
-	time (&the_time);
-	strftime (str_time, 254, "%H:%M:%S", localtime (&the_time));
+	/* only format the time once a second */
+	second = g_get_real_time () / G_USEC_PER_SEC;
+	if (second != thread->second) {
+		time_t the_time = (time_t) second;
+		struct tm tm;
+		localtime_r (&the_time, &tm);
+		strftime (thread->str_time, sizeof (thread->str_time), "%H:%M:%S", &tm);
+		thread->second = second;
+	}
+
+	/* keep for later */
+	if (_ring != NULL)
+		gpk_debug_ring_add (thread, log_domain, message);
+	if (!_verbose)
+		return;
+
+	g_string_truncate (line, 0);
 
 	/* no color please, we're British */
 	if (!_console) {
 		if (log_level == G_LOG_LEVEL_DEBUG) {
-			g_print ("%s\t%s\t%s\n", str_time, log_domain, message);
+			g_string_append_printf (line, "%s\t%s\t%s\n", thread->str_time, log_domain, message);
 		} else {
-			g_print ("***\n%s\t%s\t%s\n***\n", str_time, log_domain, message);
+			g_string_append_printf (line, "***\n%s\t%s\t%s\n***\n", thread->str_time, log_domain, message);
 		}
-		return;
+		goto out;
 	}
 
 	/* time in green */
-	g_print ("%c[%dm%s\t", 0x1B, CONSOLE_GREEN, str_time);
+	g_string_append_printf (line, "%c[%dm%s\t", 0x1B, CONSOLE_GREEN, thread->str_time);
 
 	/* log domain in either blue */
-	if (g_strcmp0 (log_domain, G_LOG_DOMAIN) == 0)
-		g_print ("%c[%dm%s%c[%dm", 0x1B, CONSOLE_BLUE, log_domain, 0x1B, CONSOLE_RESET);
-	else
-		g_print ("%c[%dm%s%c[%dm", 0x1B, CONSOLE_CYAN, log_domain, 0x1B, CONSOLE_RESET);
+	g_string_append_printf (line, "%c[%dm%s%c[%dm", 0x1B,
+				g_strcmp0 (log_domain, G_LOG_DOMAIN) == 0 ? CONSOLE_BLUE : CONSOLE_CYAN,
+				log_domain, 0x1B, CONSOLE_RESET);
 
 	/* pad with spaces */
 	len = strlen (log_domain);
-	for (i=len; i<GPK_DEBUG_LOG_DOMAIN_LENGTH; i++)
-		g_print (" ");
+	if (len < GPK_DEBUG_LOG_DOMAIN_LENGTH)
+		g_string_append_printf (line, "%*s", (gint) (GPK_DEBUG_LOG_DOMAIN_LENGTH - len), "");
 
 	/* critical is also in red */
 	if (log_level == G_LOG_LEVEL_CRITICAL ||
 	    log_level == G_LOG_LEVEL_ERROR) {
-		g_print ("%c[%dm%s\n%c[%dm", 0x1B, CONSOLE_RED, message, 0x1B, CONSOLE_RESET);
+		g_string_append_printf (line, "%c[%dm%s\n%c[%dm", 0x1B, CONSOLE_RED, message, 0x1B, CONSOLE_RESET);
 	} else {
 		/* debug in blue */
-		g_print ("%c[%dm%s\n%c[%dm", 0x1B, CONSOLE_BLUE, message, 0x1B, CONSOLE_RESET);
+		g_string_append_printf (line, "%c[%dm%s\n%c[%dm", 0x1B, CONSOLE_BLUE, message, 0x1B, CONSOLE_RESET);
 	}
+out:
+	gpk_debug_queue_line (line->str, line->len);
+
+	/* these are fatal, so don't leave anything in the queue */
+	if (log_level == G_LOG_LEVEL_CRITICAL ||
+	    log_level == G_LOG_LEVEL_ERROR)
+		gpk_debug_flush ();
 }
 
 static gboolean
@@ -102,6 +341,12 @@ gpk_debug_pre_parse_hook (GOptionContext *context, GOptionGroup *group, gpointer
 		{ "verbose", 'v', 0, G_OPTION_ARG_NONE, &_verbose,
 		  /* TRANSLATORS: turn on all debugging */
 		  N_("Show debugging information for all files"), NULL },
+		{ "debug-buffer", '\0', 0, G_OPTION_ARG_INT, &_ring_size,
+		  /* TRANSLATORS: keep the last few debug messages in memory */
+		  N_("Keep this many debug messages to show after a crash"), NULL },
+		{ "trace", '\0', 0, G_OPTION_ARG_FILENAME, &_trace_filename,
+		  /* TRANSLATORS: record how long each PackageKit request takes */
+		  N_("Write timings for each request to a trace file"), NULL },
 		{ NULL}
 	};
 
@@ -121,6 +366,11 @@ gpk_debug_add_log_domain (const gchar *log_domain)
 				   G_LOG_LEVEL_DEBUG |
 				   G_LOG_LEVEL_WARNING,
 				   gpk_debug_handler_cb, NULL);
+	} else if (_ring != NULL) {
+		/* only keep the debugging in memory */
+		g_log_set_handler (log_domain,
+				   G_LOG_LEVEL_DEBUG | G_LOG_LEVEL_WARNING,
+				   gpk_debug_handler_cb, NULL);
 	} else {
 		/* hide all debugging */
 		g_log_set_handler (log_domain,
@@ -132,13 +382,245 @@ gpk_debug_add_log_domain (const gchar *log_domain)
 static gboolean
 gpk_debug_post_parse_hook (GOptionContext *context, GOptionGroup *group, gpointer data, GError **error)
 {
+	/* dump the recent messages if we crash */
+	if (_ring_size > 0) {
+		struct sigaction sa;
+		memset (&sa, 0, sizeof (sa));
+		sa.sa_handler = gpk_debug_crash_cb;
+		sa.sa_flags = SA_RESETHAND;
+		sigemptyset (&sa.sa_mask);
+		sigaction (SIGSEGV, &sa, NULL);
+		sigaction (SIGABRT, &sa, NULL);
+		sigaction (SIGBUS, &sa, NULL);
+		sigaction (SIGFPE, &sa, NULL);
+		_ring = g_new0 (gchar *, _ring_size);
+	}
+
 	/* verbose? */
 	gpk_debug_add_log_domain (G_LOG_DOMAIN);
 	_console = (isatty (fileno (stdout)) == 1);
 	g_debug ("Verbose debugging %s (on console %i)", _verbose ? "enabled" : "disabled", _console);
+
+	/* Chrome trace-event format, where the closing bracket is optional
+	 * so events can be written as they happen */
+	if (_trace_filename != NULL) {
+		_trace = fopen (_trace_filename, "w");
+		if (_trace == NULL) {
+			g_set_error (error, G_OPTION_ERROR, G_OPTION_ERROR_FAILED,
+				     "failed to open %s", _trace_filename);
+			return FALSE;
+		}
+		_trace_start = g_get_monotonic_time ();
+		setvbuf (_trace, NULL, _IOLBF, 0);
+		fprintf (_trace, "[\n");
+		_trace_spans = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+						      NULL, (GDestroyNotify) g_free);
+	}
 	return TRUE;
 }
 
+static void
+gpk_trace_write (GpkTraceSpan *span, const gchar *phase, const gchar *name)
+{
+	fprintf (_trace,
+		 "{\"name\": \"%s\", \"cat\": \"packagekit\", \"ph\": \"%s\", "
+		 "\"id\": %u, \"pid\": %i, \"tid\": 1, \"ts\": %" G_GINT64_FORMAT "},\n",
+		 name, phase, span->id, (gint) getpid (), g_get_monotonic_time ());
+}
+
+/**
+ * gpk_trace_enabled:
+ *
+ * Return value: %TRUE if --trace was used
+ **/
+gboolean
+gpk_trace_enabled (void)
+{
+	return _trace != NULL;
+}
+
+/**
+ * gpk_trace_begin:
+ *
+ * Starts a span just before the request for @role is sent.
+ *
+ * Return value: the token to pass to the marks and the end of this request,
+ * or 0 if --trace was not used
+ **/
+guint
+gpk_trace_begin (PkRoleEnum role)
+{
+	GpkTraceSpan *span;
+
+	if (_trace == NULL)
+		return 0;
+	span = g_new0 (GpkTraceSpan, 1);
+	span->role = role;
+	span->id = ++_trace_id;
+	g_hash_table_insert (_trace_spans, GUINT_TO_POINTER (span->id), span);
+	gpk_trace_write (span, "b", pk_role_enum_to_string (role));
+	return span->id;
+}
+
+/**
+ * gpk_trace_mark:
+ *
+ * Records @mark in the span for @token, only the first time it happens.
+ **/
+void
+gpk_trace_mark (guint token, GpkTraceMark mark)
+{
+	GpkTraceSpan *span;
+	static const gchar *names[] = { "first-progress", "first-package",
+					"finished", "model-populated" };
+
+	if (_trace == NULL || token == 0)
+		return;
+	span = g_hash_table_lookup (_trace_spans, GUINT_TO_POINTER (token));
+	if (span == NULL || (span->marks & (1u << mark)) > 0)
+		return;
+	span->marks |= 1u << mark;
+	gpk_trace_write (span, "n", names[mark]);
+}
+
+/**
+ * gpk_trace_progress:
+ *
+ * Records the first progress and first package marks, call this from the
+ * #PkProgressCallback.
+ **/
+void
+gpk_trace_progress (guint token, PkProgressType type)
+{
+	gpk_trace_mark (token,
+			type == PK_PROGRESS_TYPE_PACKAGE ||
+			type == PK_PROGRESS_TYPE_PACKAGE_ID ?
+				GPK_TRACE_MARK_FIRST_PACKAGE :
+				GPK_TRACE_MARK_FIRST_PROGRESS);
+}
+
+static gboolean
+gpk_trace_draw_cb (GtkWidget *widget, cairo_t *cr, GpkTraceSpan *span)
+{
+	gpk_trace_write (span, "n", "first-paint");
+	gpk_trace_write (span, "e", pk_role_enum_to_string (span->role));
+	g_signal_handler_disconnect (widget, span->draw_id);
+	g_object_unref (span->widget);
+	g_free (span);
+	return FALSE;
+}
+
+/**
+ * gpk_trace_end:
+ * @widget: the widget showing the results, or %NULL
+ *
+ * Records that @widget has been populated with the results, and ends the
+ * span for @token when it is next painted, or straight away if there is no
+ * widget showing the results.
+ **/
+void
+gpk_trace_end (guint token, GtkWidget *widget)
+{
+	GpkTraceSpan *span;
+
+	if (_trace == NULL || token == 0)
+		return;
+	if (widget != NULL)
+		gpk_trace_mark (token, GPK_TRACE_MARK_POPULATED);
+	span = g_hash_table_lookup (_trace_spans, GUINT_TO_POINTER (token));
+	if (span == NULL)
+		return;
+	g_hash_table_steal (_trace_spans, GUINT_TO_POINTER (token));
+	if (widget == NULL || !gtk_widget_is_drawable (widget)) {
+		gpk_trace_write (span, "e", pk_role_enum_to_string (span->role));
+		g_free (span);
+		return;
+	}
+	span->widget = g_object_ref (widget);
+	span->draw_id = g_signal_connect_after (widget, "draw",
+						G_CALLBACK (gpk_trace_draw_cb), span);
+	gtk_widget_queue_draw (widget);
+}
+
+/**
+ * gpk_trace_request_new:
+ * @user_data: what the callbacks of the request would otherwise get
+ *
+ * Starts a span for @role, and keeps its token with @user_data so both can
+ * be passed to the callbacks of one request. Without --trace there is no
+ * token to keep, so every request for @user_data shares one that is never
+ * freed.
+ **/
+GpkTraceRequest *
+gpk_trace_request_new (PkRoleEnum role, gpointer user_data)
+{
+	GpkTraceRequest *request;
+	guint token = gpk_trace_begin (role);
+
+	if (token == 0) {
+		if (_trace_untraced == NULL)
+			_trace_untraced = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+								 NULL, (GDestroyNotify) g_free);
+		request = g_hash_table_lookup (_trace_untraced, user_data);
+		if (request == NULL) {
+			request = g_new0 (GpkTraceRequest, 1);
+			request->user_data = user_data;
+			g_hash_table_insert (_trace_untraced, user_data, request);
+		}
+		return request;
+	}
+	request = g_new0 (GpkTraceRequest, 1);
+	request->user_data = user_data;
+	request->token = token;
+	return request;
+}
+
+/**
+ * gpk_trace_request_free:
+ *
+ * Also ends the span if the request failed before the callback got to it.
+ **/
+void
+gpk_trace_request_free (GpkTraceRequest *request)
+{
+	if (_trace_untraced != NULL &&
+	    g_hash_table_lookup (_trace_untraced, request->user_data) == request)
+		return;
+	gpk_trace_end (request->token, NULL);
+	g_free (request);
+}
+
+static gboolean
+gpk_trace_interactive_draw_cb (GtkWidget *widget, cairo_t *cr, gpointer user_data)
+{
+	gint64 now = g_get_monotonic_time ();
+
+	fprintf (_trace,
+		 "{\"name\": \"time-to-interactive\", \"cat\": \"startup\", \"ph\": \"X\", "
+		 "\"pid\": %i, \"tid\": 1, \"ts\": %" G_GINT64_FORMAT ", \"dur\": %" G_GINT64_FORMAT "},\n",
+		 (gint) getpid (), _trace_start, now - _trace_start);
+	g_debug ("interactive after %" G_GINT64_FORMAT "ms", (now - _trace_start) / 1000);
+	g_signal_handlers_disconnect_by_func (widget, gpk_trace_interactive_draw_cb, user_data);
+	return FALSE;
+}
+
+/**
+ * gpk_trace_interactive:
+ * @widget: the main window
+ *
+ * Records the time from the command line being parsed until @widget is
+ * next painted, which should be once the user can start using it.
+ **/
+void
+gpk_trace_interactive (GtkWidget *widget)
+{
+	if (_trace == NULL)
+		return;
+	g_signal_connect_after (widget, "draw",
+				G_CALLBACK (gpk_trace_interactive_draw_cb), NULL);
+	gtk_widget_queue_draw (widget);
+}
+
 /**
  * gpk_debug_get_option_group:
  *
@@ -23,8 +23,51 @@
 #define __GPK_DEBUG_H__
 
 #include <glib.h>
+#include <gtk/gtk.h>
+#include <packagekit-glib2/packagekit.h>
+
+/**
+ * GpkTraceMark:
+ *
+ * The points recorded between sending a request and the results being shown
+ **/
+typedef enum {
+	GPK_TRACE_MARK_FIRST_PROGRESS,
+	GPK_TRACE_MARK_FIRST_PACKAGE,
+	GPK_TRACE_MARK_FINISHED,
+	GPK_TRACE_MARK_POPULATED,
+	GPK_TRACE_MARK_LAST
+} GpkTraceMark;
 
 GOptionGroup	*gpk_debug_get_option_group	(void);
 void		 gpk_debug_add_log_domain	(const gchar	*log_domain);
+void		 gpk_debug_add_dump_action	(GActionMap	*map);
+void		 gpk_debug_dump			(void);
+void		 gpk_debug_flush		(void);
+
+/**
+ * GpkTraceRequest:
+ *
+ * The user data for the callbacks of one traced request
+ **/
+typedef struct {
+	gpointer	 user_data;
+	guint		 token;
+} GpkTraceRequest;
+
+gboolean	 gpk_trace_enabled		(void);
+guint		 gpk_trace_begin		(PkRoleEnum	 role);
+void		 gpk_trace_mark			(guint		 token,
+						 GpkTraceMark	 mark);
+void		 gpk_trace_progress		(guint		 token,
+						 PkProgressType	 type);
+void		 gpk_trace_end			(guint		 token,
+						 GtkWidget	*widget);
+void		 gpk_trace_interactive		(GtkWidget	*widget);
+GpkTraceRequest	*gpk_trace_request_new		(PkRoleEnum	 role,
+						 gpointer	 user_data);
+void		 gpk_trace_request_free		(GpkTraceRequest *request);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GpkTraceRequest, gpk_trace_request_free)
 
 #endif /* __GPK_DEBUG_H__ */
@@ -29,6 +29,7 @@
 #include "gpk-common.h"
 #include "gpk-dialog.h"
 #include "gpk-enum.h"
+#include "gpk-file-list.h"
 
 enum {
 	GPK_DIALOG_STORE_IMAGE,
@@ -190,50 +191,111 @@ gpk_dialog_embed_package_list_widget (GtkDialog *dialog, GPtrArray *array)
 	return TRUE;
 }
 
+typedef struct {
+	GPtrArray		*files;
+	GtkTreeView		*treeview;
+	GtkToggleButton		*tree;
+	GtkEntry		*filter;
+} GpkDialogFileList;
+
+static void
+gpk_dialog_file_list_free (GpkDialogFileList *helper)
+{
+	g_ptr_array_unref (helper->files);
+	g_free (helper);
+}
+
+static void
+gpk_dialog_file_list_refresh (GpkDialogFileList *helper)
+{
+	g_autoptr(GpkFileList) list = NULL;
+
+	/* a new model is cheap, as nothing is copied or expanded */
+	list = gpk_file_list_new (helper->files,
+				  gtk_toggle_button_get_active (helper->tree),
+				  gtk_entry_get_text (helper->filter));
+	gtk_tree_view_set_model (helper->treeview, GTK_TREE_MODEL (list));
+}
+
 gboolean
 gpk_dialog_embed_file_list_widget (GtkDialog *dialog, GPtrArray *files)
 {
+	GpkDialogFileList *helper;
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+	GtkWidget *box;
+	GtkWidget *hbox;
 	GtkWidget *scroll;
 	GtkWidget *widget;
-	GtkTextBuffer *buffer;
-	g_auto(GStrv) array = NULL;
-	g_autofree gchar *text = NULL;
+	const guint tree_threshold = 1000;
 
-	/* split and show */
-	array = pk_ptr_array_to_strv (files);
-	text = g_strjoinv ("\n", array);
-	if (text[0] == '\0') {
-		g_free (text);
-		text = g_strdup (_("No files"));
+	/* add some spacing to conform to the GNOME HIG */
+	box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 6);
+	gtk_container_set_border_width (GTK_CONTAINER (box), 6);
+	gtk_widget_show (box);
+	widget = gtk_dialog_get_content_area (GTK_DIALOG(dialog));
+	gtk_box_pack_start (GTK_BOX (widget), box, TRUE, TRUE, 0);
+
+	/* nothing to browse */
+	if (files->len == 0) {
+		widget = gtk_label_new (_("No files"));
+		gtk_widget_show (widget);
+		gtk_box_pack_start (GTK_BOX (box), widget, TRUE, TRUE, 0);
+		return TRUE;
 	}
 
-	/* create a text view to hold the store */
-	widget = gtk_text_view_new ();
-	gtk_text_view_set_editable (GTK_TEXT_VIEW (widget), FALSE);
-	gtk_text_view_set_left_margin (GTK_TEXT_VIEW (widget), 5);
-	gtk_text_view_set_right_margin (GTK_TEXT_VIEW (widget), 5);
+	helper = g_new0 (GpkDialogFileList, 1);
+	helper->files = g_ptr_array_ref (files);
+	g_object_set_data_full (G_OBJECT (box), "gpk-dialog-file-list", helper,
+				(GDestroyNotify) gpk_dialog_file_list_free);
+
+	/* filter and view mode */
+	hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
+	gtk_widget_show (hbox);
+	gtk_box_pack_start (GTK_BOX (box), hbox, FALSE, FALSE, 0);
+	widget = gtk_search_entry_new ();
+	helper->filter = GTK_ENTRY (widget);
+	gtk_widget_show (widget);
+	gtk_box_pack_start (GTK_BOX (hbox), widget, TRUE, TRUE, 0);
+	/* TRANSLATORS: show the files as an expandable directory tree */
+	widget = gtk_check_button_new_with_mnemonic (_("Show as _tree"));
+	helper->tree = GTK_TOGGLE_BUTTON (widget);
+	gtk_toggle_button_set_active (helper->tree, files->len > tree_threshold);
+	gtk_widget_show (widget);
+	gtk_box_pack_start (GTK_BOX (hbox), widget, FALSE, FALSE, 0);
+
+	/* rows all have the same height, so none are measured up front */
+	widget = gtk_tree_view_new ();
+	helper->treeview = GTK_TREE_VIEW (widget);
+	gtk_tree_view_set_headers_visible (helper->treeview, FALSE);
+	gtk_tree_view_set_enable_search (helper->treeview, FALSE);
+	column = gtk_tree_view_column_new ();
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	renderer = gtk_cell_renderer_pixbuf_new ();
+	gtk_tree_view_column_pack_start (column, renderer, FALSE);
+	gtk_tree_view_column_add_attribute (column, renderer, "icon-name", GPK_FILE_LIST_COLUMN_ICON);
+	renderer = gtk_cell_renderer_text_new ();
+	gtk_tree_view_column_pack_start (column, renderer, TRUE);
+	gtk_tree_view_column_add_attribute (column, renderer, "text", GPK_FILE_LIST_COLUMN_TEXT);
+	gtk_tree_view_append_column (helper->treeview, column);
+	gtk_tree_view_set_fixed_height_mode (helper->treeview, TRUE);
+	gtk_widget_show (widget);
 
 	/* scroll the treeview */
 	scroll = gtk_scrolled_window_new (NULL, NULL);
 	gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scroll),
-					GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+					GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+	gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scroll), GTK_SHADOW_IN);
 	gtk_container_add (GTK_CONTAINER (scroll), widget);
-	gtk_widget_show (scroll);
-
-	/* set in buffer */
-	buffer = gtk_text_buffer_new (NULL);
-	gtk_text_buffer_set_text (buffer, text, -1);
-	gtk_text_view_set_buffer (GTK_TEXT_VIEW (widget), buffer);
-	gtk_widget_show (widget);
-
-	/* add some spacing to conform to the GNOME HIG */
-	gtk_container_set_border_width (GTK_CONTAINER (scroll), 6);
 	gtk_widget_set_size_request (GTK_WIDGET (scroll), -1, 300);
+	gtk_widget_show (scroll);
+	gtk_box_pack_start (GTK_BOX (box), scroll, TRUE, TRUE, 0);
 
-	/* add scrolled window */
-	widget = gtk_dialog_get_content_area (GTK_DIALOG(dialog));
-	gtk_box_pack_start (GTK_BOX (widget), scroll, TRUE, TRUE, 0);
-
+	gpk_dialog_file_list_refresh (helper);
+	g_signal_connect_swapped (helper->filter, "search-changed",
+				  G_CALLBACK (gpk_dialog_file_list_refresh), helper);
+	g_signal_connect_swapped (helper->tree, "toggled",
+				  G_CALLBACK (gpk_dialog_file_list_refresh), helper);
 	return TRUE;
 }
 
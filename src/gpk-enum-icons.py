@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2007-2008 Richard Hughes <richard@hughsie.com>
+#
+# Licensed under the GNU General Public License Version 2
+#
+# Turns gpk-enum-icons.txt into dense icon name arrays indexed by enum value.
+
+import sys
+
+
+def _parse(path):
+    sections = []
+    rows = None
+    with open(path, encoding='utf-8') as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+            if line.startswith('[') and line.endswith(']'):
+                rows = []
+                sections.append((line[1:-1], rows))
+                continue
+            cols = line.split()
+            if rows is None or len(cols) not in (2, 3):
+                sys.exit('%s:%i: invalid line' % (path, lineno))
+            if cols[1] == '""':
+                cols[1] = ''
+            rows.append((cols[0], cols[1], cols[2] if len(cols) == 3 else None))
+    return sections
+
+
+def _write(path, sections):
+    out = ['/* generated by gpk-enum-icons.py from gpk-enum-icons.txt, do not edit */',
+           '',
+           '#ifndef __GPK_ENUM_ICONS_H',
+           '#define __GPK_ENUM_ICONS_H',
+           '',
+           '#include <packagekit-glib2/packagekit.h>']
+    for name, rows in sections:
+        out.append('')
+        out.append('static const gchar * const enum_%s_icon_name[PK_%s_ENUM_LAST] = {' %
+                   (name, name.upper()))
+        for enum, icon, version in rows:
+            if version:
+                out.append('#if PK_CHECK_VERSION(%s)' % version)
+            out.append('\t[%s] = "%s",' % (enum, icon))
+            if version:
+                out.append('#endif')
+        out.append('};')
+    out.append('')
+    out.append('#endif /* __GPK_ENUM_ICONS_H */')
+    with open(path, 'w', encoding='utf-8') as f:
+        f.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit('usage: %s INPUT OUTPUT' % sys.argv[0])
+    _write(sys.argv[2], _parse(sys.argv[1]))
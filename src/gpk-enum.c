@@ -26,183 +26,24 @@
 #include <packagekit-glib2/packagekit.h>
 
 #include "gpk-enum.h"
+#include "gpk-enum-icons.h"
+#include "gpk-enum-private.h"
 #include "gpk-common.h"
 
-/* icon names */
-static const PkEnumMatch enum_info_icon_name[] = {
-	{PK_INFO_ENUM_UNKNOWN,			"help-browser"},	/* fall though value */
-	{PK_INFO_ENUM_INSTALLED,		"pk-package-installed"},
-	{PK_INFO_ENUM_AVAILABLE,		"pk-package-available"},
-	{PK_INFO_ENUM_LOW,			"pk-update-low"},
-	{PK_INFO_ENUM_NORMAL,			"pk-update-normal"},
-	{PK_INFO_ENUM_IMPORTANT,		"pk-update-high"},
-	{PK_INFO_ENUM_CRITICAL,			"pk-update-security"},
-	{PK_INFO_ENUM_SECURITY,			"pk-update-security"},
-	{PK_INFO_ENUM_BUGFIX,			"pk-update-bugfix"},
-	{PK_INFO_ENUM_ENHANCEMENT,		"pk-update-enhancement"},
-	{PK_INFO_ENUM_BLOCKED,			"pk-package-blocked"},
-#if PK_CHECK_VERSION(1,0,4)
-	{PK_INFO_ENUM_UNAVAILABLE,		"pk-package-blocked"},
-#endif
-	{PK_INFO_ENUM_DOWNLOADING,		"pk-package-download"},
-	{PK_INFO_ENUM_UPDATING,			"pk-package-update"},
-	{PK_INFO_ENUM_INSTALLING,		"pk-package-add"},
-	{PK_INFO_ENUM_REMOVING,			"pk-package-delete"},
-	{PK_INFO_ENUM_OBSOLETING,		"pk-package-cleanup"},
-	{PK_INFO_ENUM_CLEANUP,			"pk-package-cleanup"},
-	{PK_INFO_ENUM_COLLECTION_INSTALLED,	"pk-collection-installed"},
-	{PK_INFO_ENUM_COLLECTION_AVAILABLE,	"pk-collection-available"},
-	{PK_INFO_ENUM_FINISHED,			"dialog-information"},
-	{PK_INFO_ENUM_REINSTALLING,		"dialog-information"},
-	{PK_INFO_ENUM_DOWNGRADING,		"pk-package-update"},
-	{PK_INFO_ENUM_PREPARING,		"dialog-information"},
-	{PK_INFO_ENUM_DECOMPRESSING,		"dialog-information"},
-	{PK_INFO_ENUM_TRUSTED,			"dialog-information"},
-	{PK_INFO_ENUM_UNTRUSTED,		"dialog-information"},
-	{0, NULL}
-};
-
-static const PkEnumMatch enum_status_icon_name[] = {
-	{PK_STATUS_ENUM_UNKNOWN,		"help-browser"},	/* fall though value */
-	{PK_STATUS_ENUM_CANCEL,			"pk-package-cleanup"}, /* TODO: need better icon */
-	{PK_STATUS_ENUM_CLEANUP,		"pk-package-cleanup"},
-	{PK_STATUS_ENUM_COMMIT,			"pk-setup"}, /* TODO: need better icon */
-	{PK_STATUS_ENUM_DEP_RESOLVE,		"pk-package-info"}, /* TODO: need better icon */
-	{PK_STATUS_ENUM_DOWNLOAD_CHANGELOG,	"pk-refresh-cache"},
-	{PK_STATUS_ENUM_DOWNLOAD_FILELIST,	"pk-refresh-cache"},
-	{PK_STATUS_ENUM_DOWNLOAD_GROUP,		"pk-refresh-cache"},
-	{PK_STATUS_ENUM_DOWNLOAD_PACKAGELIST,	"pk-refresh-cache"},
-	{PK_STATUS_ENUM_DOWNLOAD,		"pk-package-download"},
-	{PK_STATUS_ENUM_DOWNLOAD_REPOSITORY,	"pk-refresh-cache"},
-	{PK_STATUS_ENUM_DOWNLOAD_UPDATEINFO,	"pk-refresh-cache"},
-	{PK_STATUS_ENUM_FINISHED,		"pk-package-cleanup"}, /* TODO: need better icon */
-	{PK_STATUS_ENUM_GENERATE_PACKAGE_LIST,	"pk-refresh-cache"}, /* TODO: need better icon */
-	{PK_STATUS_ENUM_WAITING_FOR_LOCK,	"pk-package-blocked"},
-	{PK_STATUS_ENUM_WAITING_FOR_AUTH,	"gtk-dialog-authentication"},
-	{PK_STATUS_ENUM_INFO,			"pk-package-info"},
-	{PK_STATUS_ENUM_INSTALL,		"pk-package-add"},
-	{PK_STATUS_ENUM_LOADING_CACHE,		"pk-refresh-cache"},
-	{PK_STATUS_ENUM_OBSOLETE,		"pk-package-cleanup"},
-	{PK_STATUS_ENUM_QUERY,			"pk-package-search"},
-	{PK_STATUS_ENUM_REFRESH_CACHE,		"pk-refresh-cache"},
-	{PK_STATUS_ENUM_REMOVE,			"pk-package-delete"},
-	{PK_STATUS_ENUM_REPACKAGING,		"pk-package-cleanup"},
-	{PK_STATUS_ENUM_REQUEST,		"pk-package-search"},
-	{PK_STATUS_ENUM_RUNNING,		"pk-setup"},
-	{PK_STATUS_ENUM_SCAN_APPLICATIONS,	"pk-package-search"}, /* TODO: need better icon */
-	{PK_STATUS_ENUM_SETUP,			"pk-setup"},
-	{PK_STATUS_ENUM_SIG_CHECK,		"pk-package-info"}, /* TODO: need better icon */
-	{PK_STATUS_ENUM_TEST_COMMIT,		"pk-package-info"}, /* TODO: need better icon */
-	{PK_STATUS_ENUM_UPDATE,			"pk-package-update"},
-	{PK_STATUS_ENUM_WAIT,			"pk-wait"},
-	{PK_STATUS_ENUM_SCAN_PROCESS_LIST,	"pk-package-info"},
-	{PK_STATUS_ENUM_CHECK_EXECUTABLE_FILES,	"pk-package-info"},
-	{PK_STATUS_ENUM_CHECK_LIBRARIES,	"pk-package-info"},
-	{PK_STATUS_ENUM_COPY_FILES,		"pk-package-info"},
-#if PK_CHECK_VERSION(1,1,6)
-	{PK_STATUS_ENUM_RUN_HOOK,		"pk-setup"},
-#endif
-	{0, NULL}
-};
-
-static const PkEnumMatch enum_role_icon_name[] = {
-	{PK_ROLE_ENUM_UNKNOWN,			"help-browser"},	/* fall though value */
-	{PK_ROLE_ENUM_ACCEPT_EULA,		"pk-package-info"},
-	{PK_ROLE_ENUM_CANCEL,			"process-stop"},
-	{PK_ROLE_ENUM_DEPENDS_ON,		"pk-package-info"},
-	{PK_ROLE_ENUM_DOWNLOAD_PACKAGES,	"pk-package-download"},
-	{PK_ROLE_ENUM_GET_CATEGORIES,		"pk-package-info"},
-	{PK_ROLE_ENUM_GET_DETAILS,		"pk-package-info"},
-	{PK_ROLE_ENUM_GET_DETAILS_LOCAL,	"pk-package-search"},
-	{PK_ROLE_ENUM_GET_DISTRO_UPGRADES,	"pk-package-info"},
-	{PK_ROLE_ENUM_GET_FILES,		"pk-package-search"},
-	{PK_ROLE_ENUM_GET_FILES_LOCAL,		"pk-package-search"},
-	{PK_ROLE_ENUM_GET_OLD_TRANSACTIONS,	"pk-package-info"},
-	{PK_ROLE_ENUM_GET_PACKAGES,		"pk-package-search"},
-	{PK_ROLE_ENUM_GET_REPO_LIST,		"pk-package-sources"},
-	{PK_ROLE_ENUM_GET_UPDATE_DETAIL,	"pk-package-info"},
-	{PK_ROLE_ENUM_GET_UPDATES,		"pk-package-info"},
-	{PK_ROLE_ENUM_INSTALL_FILES,		"pk-package-add"},
-	{PK_ROLE_ENUM_INSTALL_PACKAGES,		"pk-package-add"},
-	{PK_ROLE_ENUM_INSTALL_SIGNATURE,	"emblem-system"},
-	{PK_ROLE_ENUM_REFRESH_CACHE,		"pk-refresh-cache"},
-	{PK_ROLE_ENUM_REMOVE_PACKAGES,		"pk-package-delete"},
-	{PK_ROLE_ENUM_REPO_ENABLE,		"pk-package-sources"},
-	{PK_ROLE_ENUM_REPO_SET_DATA,		"pk-package-sources"},
-	{PK_ROLE_ENUM_REPO_REMOVE,		"pk-package-sources"},
-	{PK_ROLE_ENUM_REQUIRED_BY,		"pk-package-info"},
-	{PK_ROLE_ENUM_RESOLVE,			"pk-package-search"},
-	{PK_ROLE_ENUM_SEARCH_DETAILS,		"pk-package-search"},
-	{PK_ROLE_ENUM_SEARCH_FILE,		"pk-package-search"},
-	{PK_ROLE_ENUM_SEARCH_GROUP,		"pk-package-search"},
-	{PK_ROLE_ENUM_SEARCH_NAME,		"pk-package-search"},
-	{PK_ROLE_ENUM_UPDATE_PACKAGES,		"pk-package-update"},
-	{PK_ROLE_ENUM_WHAT_PROVIDES,		"pk-package-search"},
-	{PK_ROLE_ENUM_REPAIR_SYSTEM,		"system-software-update"},
-#if PK_CHECK_VERSION(1,0,10)
-	{PK_ROLE_ENUM_UPGRADE_SYSTEM,		"system-software-update"},
-#endif
-	{0, NULL}
-};
-
-static const PkEnumMatch enum_group_icon_name[] = {
-	{PK_GROUP_ENUM_UNKNOWN,			"help-browser"},	/* fall though value */
-	{PK_GROUP_ENUM_ACCESSIBILITY,		"preferences-desktop-accessibility"},
-	{PK_GROUP_ENUM_ACCESSORIES,		"applications-utilities"},
-	{PK_GROUP_ENUM_ADMIN_TOOLS,		"system-lock-screen"},
-	{PK_GROUP_ENUM_COLLECTIONS,		"pk-collection-installed"},
-	{PK_GROUP_ENUM_COMMUNICATION,		"network-workgroup"},
-	{PK_GROUP_ENUM_DESKTOP_GNOME,		"pk-desktop-gnome"},
-	{PK_GROUP_ENUM_DESKTOP_KDE,		"pk-desktop-kde"},
-	{PK_GROUP_ENUM_DESKTOP_XFCE,		"pk-desktop-xfce"},
-	{PK_GROUP_ENUM_DESKTOP_OTHER,		"preferences-desktop-wallpaper"},
-#if PK_CHECK_VERSION(1,2,7)
-	{PK_GROUP_ENUM_DESKTOP_DDE,		"preferences-desktop-wallpaper"},
-#endif
-	{PK_GROUP_ENUM_DOCUMENTATION,		"system-help"},
-	{PK_GROUP_ENUM_EDUCATION,		"utilities-system-monitor"},
-	{PK_GROUP_ENUM_ELECTRONICS,		"applications-engineering"},
-	{PK_GROUP_ENUM_FONTS,			"preferences-desktop-font"},
-	{PK_GROUP_ENUM_GAMES,			"applications-games"},
-	{PK_GROUP_ENUM_GRAPHICS,		"applications-graphics"},
-	{PK_GROUP_ENUM_INTERNET,		"applications-internet"},
-	{PK_GROUP_ENUM_LEGACY,			"media-floppy"},
-	{PK_GROUP_ENUM_LOCALIZATION,		"preferences-desktop-locale"},
-	{PK_GROUP_ENUM_MAPS,			"applications-multimedia"},
-	{PK_GROUP_ENUM_MULTIMEDIA,		"applications-multimedia"},
-	{PK_GROUP_ENUM_NETWORK,			"network-wired"},
-	{PK_GROUP_ENUM_OFFICE,			"applications-office"},
-	{PK_GROUP_ENUM_OTHER,			"applications-other"},
-	{PK_GROUP_ENUM_POWER_MANAGEMENT,	"battery"},
-	{PK_GROUP_ENUM_PROGRAMMING,		"applications-development"},
-	{PK_GROUP_ENUM_PUBLISHING,		"accessories-dictionary"},
-	{PK_GROUP_ENUM_REPOS,			"x-package-repository"},
-	{PK_GROUP_ENUM_SCIENCE,			"applications-science"},
-	{PK_GROUP_ENUM_SECURITY,		"network-wireless-encrypted"},
-	{PK_GROUP_ENUM_SERVERS,			"network-server"},
-	{PK_GROUP_ENUM_SYSTEM,			"applications-system"},
-	{PK_GROUP_ENUM_VIRTUALIZATION,		"computer"},
-	{PK_GROUP_ENUM_VENDOR,			"application-certificate"},
-	{PK_GROUP_ENUM_NEWEST,			"dialog-information"},
-	{0, NULL}
-};
-
-static const PkEnumMatch enum_restart_icon_name[] = {
-	{PK_RESTART_ENUM_UNKNOWN,		"help-browser"},	/* fall though value */
-	{PK_RESTART_ENUM_NONE,			""},
-	{PK_RESTART_ENUM_SYSTEM,		"system-shutdown"},
-	{PK_RESTART_ENUM_SESSION,		"system-log-out"},
-	{PK_RESTART_ENUM_APPLICATION,		"emblem-symbolic-link"},
-	{PK_RESTART_ENUM_SECURITY_SYSTEM,	"system-shutdown"},
-	{PK_RESTART_ENUM_SECURITY_SESSION,	"system-log-out"},
-	{0, NULL}
-};
+/* icon names are direct lookups, falling back to the UNKNOWN value */
+static const gchar *
+gpk_enum_icon_name_lookup (const gchar * const *table, guint len, guint value)
+{
+	if (value >= len || table[value] == NULL)
+		return table[0];
+	return table[value];
+}
 
-const gchar *
-gpk_media_type_enum_to_localised_text (PkMediaTypeEnum type)
+static const gchar *
+gpk_media_type_enum_localise_text (guint value)
 {
 	const gchar *text = NULL;
-	switch (type) {
+	switch ((PkMediaTypeEnum) value) {
 	case PK_MEDIA_TYPE_ENUM_CD:
 		/* TRANSLATORS: this is compact disk (CD) media */
 		text = _("CD");
@@ -220,16 +61,16 @@ gpk_media_type_enum_to_localised_text (PkMediaTypeEnum type)
 		text = _("media");
 		break;
 	default:
-		g_warning ("Unknown media type");
+		break;
 	}
 	return text;
 }
 
-const gchar *
-gpk_error_enum_to_localised_text (PkErrorEnum code)
+static const gchar *
+gpk_error_enum_localise_text (guint value)
 {
 	const gchar *text = NULL;
-	switch (code) {
+	switch ((PkErrorEnum) value) {
 	case PK_ERROR_ENUM_UNKNOWN:
 		text = _("Failed with unknown error code");
 		break;
@@ -440,16 +281,16 @@ gpk_error_enum_to_localised_text (PkErrorEnum code)
 		break;
 #endif
 	default:
-		g_warning ("Unknown error %i", code);
+		break;
 	}
 	return text;
 }
 
-const gchar *
-gpk_error_enum_to_localised_message (PkErrorEnum code)
+static const gchar *
+gpk_error_enum_localise_message (guint value)
 {
 	const gchar *text = NULL;
-	switch (code) {
+	switch ((PkErrorEnum) value) {
 	case PK_ERROR_ENUM_UNKNOWN:
 		text = _("Failed with unknown error code.");
 		break;
@@ -704,11 +545,11 @@ gpk_error_enum_to_localised_message (PkErrorEnum code)
 	return text;
 }
 
-const gchar *
-gpk_restart_enum_to_localised_text_future (PkRestartEnum restart)
+static const gchar *
+gpk_restart_enum_localise_text_future (guint value)
 {
 	const gchar *text = NULL;
-	switch (restart) {
+	switch ((PkRestartEnum) value) {
 	case PK_RESTART_ENUM_NONE:
 		text = _("No restart is necessary.");
 		break;
@@ -728,16 +569,16 @@ gpk_restart_enum_to_localised_text_future (PkRestartEnum restart)
 		text = _("A restart will be required due to a security update.");
 		break;
 	default:
-		g_warning ("restart unrecognized: %u", restart);
+		break;
 	}
 	return text;
 }
 
-const gchar *
-gpk_restart_enum_to_localised_text (PkRestartEnum restart)
+static const gchar *
+gpk_restart_enum_localise_text (guint value)
 {
 	const gchar *text = NULL;
-	switch (restart) {
+	switch ((PkRestartEnum) value) {
 	case PK_RESTART_ENUM_NONE:
 		text = _("No restart is required.");
 		break;
@@ -757,16 +598,16 @@ gpk_restart_enum_to_localised_text (PkRestartEnum restart)
 		text = _("A restart is required to remain secure.");
 		break;
 	default:
-		g_warning ("restart unrecognized: %u", restart);
+		break;
 	}
 	return text;
 }
 
-const gchar *
-gpk_status_enum_to_localised_text (PkStatusEnum status)
+static const gchar *
+gpk_status_enum_localise_text (guint value)
 {
 	const gchar *text = NULL;
-	switch (status) {
+	switch ((PkStatusEnum) value) {
 	case PK_STATUS_ENUM_UNKNOWN:
 		/* TRANSLATORS: This is when the transaction status is not known */
 		text = _("Unknown state");
@@ -918,16 +759,16 @@ gpk_status_enum_to_localised_text (PkStatusEnum status)
 		break;
 #endif
 	default:
-		g_warning ("status unrecognized: %s", pk_status_enum_to_string (status));
+		break;
 	}
 	return text;
 }
 
-const gchar *
-gpk_info_enum_to_localised_text (PkInfoEnum info)
+static const gchar *
+gpk_info_enum_localise_text (guint value)
 {
 	const gchar *text = NULL;
-	switch (info) {
+	switch ((PkInfoEnum) value) {
 	case PK_INFO_ENUM_LOW:
 		/* TRANSLATORS: The type of update */
 		text = _("Trivial update");
@@ -981,16 +822,16 @@ gpk_info_enum_to_localised_text (PkInfoEnum info)
 		break;
 #endif
 	default:
-		g_warning ("info unrecognized: %s", pk_info_enum_to_string (info));
+		break;
 	}
 	return text;
 }
 
 static const gchar *
-gpk_info_enum_to_localised_present (PkInfoEnum info)
+gpk_info_enum_localise_present (guint value)
 {
 	const gchar *text = NULL;
-	switch (info) {
+	switch ((PkInfoEnum) value) {
 	case PK_INFO_ENUM_DOWNLOADING:
 		/* TRANSLATORS: The action of the package, in present tense */
 		text = _("Downloading");
@@ -1028,16 +869,16 @@ gpk_info_enum_to_localised_present (PkInfoEnum info)
 		text = _("Decompressing");
 		break;
 	default:
-		g_warning ("info unrecognized: %s", pk_info_enum_to_string (info));
+		break;
 	}
 	return text;
 }
 
-const gchar *
-gpk_info_enum_to_localised_past (PkInfoEnum info)
+static const gchar *
+gpk_info_enum_localise_past (guint value)
 {
 	const gchar *text = NULL;
-	switch (info) {
+	switch ((PkInfoEnum) value) {
 	case PK_INFO_ENUM_DOWNLOADING:
 		/* TRANSLATORS: The action of the package, in past tense */
 		text = _("Downloaded");
@@ -1075,16 +916,16 @@ gpk_info_enum_to_localised_past (PkInfoEnum info)
 		text = _("Decompressed");
 		break;
 	default:
-		g_warning ("info unrecognized: %s", pk_info_enum_to_string (info));
+		break;
 	}
 	return text;
 }
 
-const gchar *
-gpk_role_enum_to_localised_past (PkRoleEnum role)
+static const gchar *
+gpk_role_enum_localise_past (guint value)
 {
 	const gchar *text = NULL;
-	switch (role) {
+	switch ((PkRoleEnum) value) {
 	case PK_ROLE_ENUM_UNKNOWN:
 		/* TRANSLATORS: The role of the transaction, in past tense */
 		text = _("Unknown role type");
@@ -1218,16 +1059,16 @@ gpk_role_enum_to_localised_past (PkRoleEnum role)
 		break;
 #endif
 	default:
-		g_warning ("role unrecognized: %s", pk_role_enum_to_string (role));
+		break;
 	}
 	return text;
 }
 
-const gchar *
-gpk_group_enum_to_localised_text (PkGroupEnum group)
+static const gchar *
+gpk_group_enum_localise_text (guint value)
 {
 	const gchar *text = NULL;
-	switch (group) {
+	switch ((PkGroupEnum) value) {
 	case PK_GROUP_ENUM_ACCESSIBILITY:
 		/* TRANSLATORS: The group type */
 		text = _("Accessibility");
@@ -1375,40 +1216,252 @@ gpk_group_enum_to_localised_text (PkGroupEnum group)
 		text = _("Unknown group");
 		break;
 	default:
-		g_warning ("group unrecognized: %u", group);
+		break;
+	}
+	return text;
+}
+
+/* the localised strings are looked up once per locale and kept in arrays
+ * indexed by the enum value; the parser threads in gpk-log use these too */
+typedef struct {
+	const gchar	*(*localise)	(guint		 value);
+	guint		 len;
+	gint		 generation;
+	const gchar	**text;
+} GpkEnumLocalised;
+
+static gint localised_generation = 1;
+static guint localised_rebuilds = 0;
+G_LOCK_DEFINE_STATIC (localised);
+
+static GpkEnumLocalised localised_media_type =
+	{ gpk_media_type_enum_localise_text, PK_MEDIA_TYPE_ENUM_LAST };
+static GpkEnumLocalised localised_error_text =
+	{ gpk_error_enum_localise_text, PK_ERROR_ENUM_LAST };
+static GpkEnumLocalised localised_error_message =
+	{ gpk_error_enum_localise_message, PK_ERROR_ENUM_LAST };
+static GpkEnumLocalised localised_restart_future =
+	{ gpk_restart_enum_localise_text_future, PK_RESTART_ENUM_LAST };
+static GpkEnumLocalised localised_restart_text =
+	{ gpk_restart_enum_localise_text, PK_RESTART_ENUM_LAST };
+static GpkEnumLocalised localised_status_text =
+	{ gpk_status_enum_localise_text, PK_STATUS_ENUM_LAST };
+static GpkEnumLocalised localised_info_text =
+	{ gpk_info_enum_localise_text, PK_INFO_ENUM_LAST };
+static GpkEnumLocalised localised_info_present =
+	{ gpk_info_enum_localise_present, PK_INFO_ENUM_LAST };
+static GpkEnumLocalised localised_info_past =
+	{ gpk_info_enum_localise_past, PK_INFO_ENUM_LAST };
+static GpkEnumLocalised localised_role_past =
+	{ gpk_role_enum_localise_past, PK_ROLE_ENUM_LAST };
+static GpkEnumLocalised localised_group_text =
+	{ gpk_group_enum_localise_text, PK_GROUP_ENUM_LAST };
+
+static const gchar *
+gpk_enum_localised_lookup (GpkEnumLocalised *table, guint value)
+{
+	gint generation = g_atomic_int_get (&localised_generation);
+
+	/* rebuild the whole table the first time, or after a locale change */
+	if (g_atomic_int_get (&table->generation) != generation) {
+		G_LOCK (localised);
+		if (g_atomic_int_get (&table->generation) != generation) {
+			guint i;
+			if (table->text == NULL)
+				table->text = g_new0 (const gchar *, table->len);
+			for (i = 0; i < table->len; i++)
+				table->text[i] = table->localise (i);
+			g_atomic_int_set (&table->generation, generation);
+			localised_rebuilds++;
+		}
+		G_UNLOCK (localised);
 	}
+	if (value >= table->len)
+		return NULL;
+	return table->text[value];
+}
+
+/**
+ * gpk_enum_localised_invalidate:
+ *
+ * Drops the cached translations so they are looked up again using the
+ * current locale. Call this after changing LC_MESSAGES with setlocale().
+ **/
+void
+gpk_enum_localised_invalidate (void)
+{
+	g_atomic_int_inc (&localised_generation);
+}
+
+/**
+ * gpk_enum_localised_get_generation:
+ *
+ * Return value: the generation the tables are rebuilt for, which changes
+ * each time gpk_enum_localised_invalidate() is called
+ **/
+gint
+gpk_enum_localised_get_generation (void)
+{
+	return g_atomic_int_get (&localised_generation);
+}
+
+/**
+ * gpk_enum_localised_get_rebuilds:
+ *
+ * Return value: how many times any of the tables has been built, for the
+ * self tests
+ **/
+guint
+gpk_enum_localised_get_rebuilds (void)
+{
+	guint rebuilds;
+
+	G_LOCK (localised);
+	rebuilds = localised_rebuilds;
+	G_UNLOCK (localised);
+	return rebuilds;
+}
+
+const gchar *
+gpk_media_type_enum_to_localised_text (PkMediaTypeEnum type)
+{
+	const gchar *text;
+	text = gpk_enum_localised_lookup (&localised_media_type, type);
+	if (text == NULL)
+		g_warning ("Unknown media type");
+	return text;
+}
+
+const gchar *
+gpk_error_enum_to_localised_text (PkErrorEnum code)
+{
+	const gchar *text;
+	text = gpk_enum_localised_lookup (&localised_error_text, code);
+	if (text == NULL)
+		g_warning ("Unknown error %i", code);
+	return text;
+}
+
+const gchar *
+gpk_error_enum_to_localised_message (PkErrorEnum code)
+{
+	return gpk_enum_localised_lookup (&localised_error_message, code);
+}
+
+const gchar *
+gpk_restart_enum_to_localised_text_future (PkRestartEnum restart)
+{
+	const gchar *text;
+	text = gpk_enum_localised_lookup (&localised_restart_future, restart);
+	if (text == NULL)
+		g_warning ("restart unrecognized: %u", restart);
+	return text;
+}
+
+const gchar *
+gpk_restart_enum_to_localised_text (PkRestartEnum restart)
+{
+	const gchar *text;
+	text = gpk_enum_localised_lookup (&localised_restart_text, restart);
+	if (text == NULL)
+		g_warning ("restart unrecognized: %u", restart);
+	return text;
+}
+
+const gchar *
+gpk_status_enum_to_localised_text (PkStatusEnum status)
+{
+	const gchar *text;
+	text = gpk_enum_localised_lookup (&localised_status_text, status);
+	if (text == NULL)
+		g_warning ("status unrecognized: %s", pk_status_enum_to_string (status));
+	return text;
+}
+
+const gchar *
+gpk_info_enum_to_localised_text (PkInfoEnum info)
+{
+	const gchar *text;
+	text = gpk_enum_localised_lookup (&localised_info_text, info);
+	if (text == NULL)
+		g_warning ("info unrecognized: %s", pk_info_enum_to_string (info));
+	return text;
+}
+
+static const gchar *
+gpk_info_enum_to_localised_present (PkInfoEnum info)
+{
+	const gchar *text;
+	text = gpk_enum_localised_lookup (&localised_info_present, info);
+	if (text == NULL)
+		g_warning ("info unrecognized: %s", pk_info_enum_to_string (info));
+	return text;
+}
+
+const gchar *
+gpk_info_enum_to_localised_past (PkInfoEnum info)
+{
+	const gchar *text;
+	text = gpk_enum_localised_lookup (&localised_info_past, info);
+	if (text == NULL)
+		g_warning ("info unrecognized: %s", pk_info_enum_to_string (info));
+	return text;
+}
+
+const gchar *
+gpk_role_enum_to_localised_past (PkRoleEnum role)
+{
+	const gchar *text;
+	text = gpk_enum_localised_lookup (&localised_role_past, role);
+	if (text == NULL)
+		g_warning ("role unrecognized: %s", pk_role_enum_to_string (role));
+	return text;
+}
+
+const gchar *
+gpk_group_enum_to_localised_text (PkGroupEnum group)
+{
+	const gchar *text;
+	text = gpk_enum_localised_lookup (&localised_group_text, group);
+	if (text == NULL)
+		g_warning ("group unrecognized: %u", group);
 	return text;
 }
 
 const gchar *
 gpk_info_enum_to_icon_name (PkInfoEnum info)
 {
-	return pk_enum_find_string (enum_info_icon_name, info);
+	return gpk_enum_icon_name_lookup (enum_info_icon_name,
+					  G_N_ELEMENTS (enum_info_icon_name), info);
 }
 
 const gchar *
 gpk_status_enum_to_icon_name (PkStatusEnum status)
 {
-	return pk_enum_find_string (enum_status_icon_name, status);
+	return gpk_enum_icon_name_lookup (enum_status_icon_name,
+					  G_N_ELEMENTS (enum_status_icon_name), status);
 }
 
 const gchar *
 gpk_role_enum_to_icon_name (PkRoleEnum role)
 {
-	return pk_enum_find_string (enum_role_icon_name, role);
+	return gpk_enum_icon_name_lookup (enum_role_icon_name,
+					  G_N_ELEMENTS (enum_role_icon_name), role);
 }
 
 const gchar *
 gpk_group_enum_to_icon_name (PkGroupEnum group)
 {
-	return pk_enum_find_string (enum_group_icon_name, group);
+	return gpk_enum_icon_name_lookup (enum_group_icon_name,
+					  G_N_ELEMENTS (enum_group_icon_name), group);
 }
 
 const gchar *
 gpk_restart_enum_to_icon_name (PkRestartEnum restart)
 {
 	const gchar *tmp;
-	tmp = pk_enum_find_string (enum_restart_icon_name, restart);
+	tmp = gpk_enum_icon_name_lookup (enum_restart_icon_name,
+					 G_N_ELEMENTS (enum_restart_icon_name), restart);
 	if (tmp[0] == '\0')
 		tmp = NULL;
 	return tmp;
@@ -82,6 +82,7 @@ const gchar	*gpk_group_enum_to_localised_text	(PkGroupEnum	 group)
 const gchar	*gpk_group_enum_to_icon_name		(PkGroupEnum	 group);
 const gchar	*gpk_info_status_enum_to_string		(GpkInfoStatusEnum info);
 const gchar	*gpk_info_status_enum_to_icon_name	(GpkInfoStatusEnum info);
+void		 gpk_enum_localised_invalidate		(void);
 
 G_END_DECLS
 
@@ -0,0 +1,457 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2008 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+#include <gtk/gtk.h>
+
+#include "gpk-file-list.h"
+
+/* a directory or file in the tree, covering the range of files below it */
+typedef struct _GpkFileListNode GpkFileListNode;
+struct _GpkFileListNode {
+	GpkFileListNode		*parent;
+	GPtrArray		*children;	/* NULL until the node is expanded */
+	guint			 index;		/* in parent->children */
+	guint			 start;
+	guint			 end;
+	guint			 name_offset;	/* of the name in files[start] */
+	guint			 path_len;	/* of the path in files[start] */
+};
+
+struct _GpkFileList
+{
+	GObject			 parent_instance;
+	GPtrArray		*source;
+	GPtrArray		*files;		/* source, or the filtered subset */
+	GpkFileListNode		*root;		/* NULL for a flat list */
+	gint			 stamp;
+};
+
+static void gpk_file_list_tree_model_init (GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (GpkFileList, gpk_file_list, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
+						gpk_file_list_tree_model_init))
+
+static gint
+gpk_file_list_compare (const gchar **a_ptr, const gchar **b_ptr)
+{
+	const gchar *a = *a_ptr;
+	const gchar *b = *b_ptr;
+	guchar ca;
+	guchar cb;
+
+	/* sort the separator before everything else so that every
+	 * directory and the files below it are in one contiguous range */
+	while (*a != '\0' && *a == *b) {
+		a++;
+		b++;
+	}
+	ca = *a == '/' ? 1 : (guchar) *a;
+	cb = *b == '/' ? 1 : (guchar) *b;
+	return ca - cb;
+}
+
+/**
+ * gpk_file_list_sort:
+ *
+ * Sorts @files into the order needed by gpk_file_list_new(), which is
+ * alphabetical with the files in each directory following it directly.
+ **/
+void
+gpk_file_list_sort (GPtrArray *files)
+{
+	g_ptr_array_sort (files, (GCompareFunc) gpk_file_list_compare);
+}
+
+static const gchar *
+gpk_file_list_get_file (GpkFileList *list, guint idx)
+{
+	return g_ptr_array_index (list->files, idx);
+}
+
+static GpkFileListNode *
+gpk_file_list_node_new (GpkFileListNode *parent, guint start, guint end,
+			guint name_offset, guint path_len)
+{
+	GpkFileListNode *node = g_new0 (GpkFileListNode, 1);
+	node->parent = parent;
+	node->start = start;
+	node->end = end;
+	node->name_offset = name_offset;
+	node->path_len = path_len;
+	return node;
+}
+
+static void
+gpk_file_list_node_free (GpkFileListNode *node)
+{
+	if (node->children != NULL)
+		g_ptr_array_unref (node->children);
+	g_free (node);
+}
+
+/* the first file in [start, end) not below the first @path_len bytes of files[start] */
+static guint
+gpk_file_list_get_range_end (GpkFileList *list, guint start, guint end, guint path_len)
+{
+	const gchar *path = gpk_file_list_get_file (list, start);
+	guint lo = start + 1;
+	guint hi = end;
+
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		const gchar *file = gpk_file_list_get_file (list, mid);
+		if (strncmp (file, path, path_len) == 0 &&
+		    (file[path_len] == '\0' || file[path_len] == '/'))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static void
+gpk_file_list_node_ensure_children (GpkFileList *list, GpkFileListNode *node)
+{
+	guint i;
+
+	if (node->children != NULL)
+		return;
+
+	/* only the direct children, the rest is done when expanded */
+	node->children = g_ptr_array_new_with_free_func ((GDestroyNotify) gpk_file_list_node_free);
+	i = node->start;
+	while (i < node->end) {
+		const gchar *file = gpk_file_list_get_file (list, i);
+		const gchar *sep;
+		guint name_offset;
+		guint path_len;
+		GpkFileListNode *child;
+
+		/* keep the leading '/' on the top level names */
+		name_offset = node == list->root ? 0 : node->path_len + 1;
+
+		/* the directory itself */
+		if (strlen (file) <= name_offset) {
+			i++;
+			continue;
+		}
+
+		sep = strchr (file + name_offset + 1, '/');
+		path_len = sep != NULL ? (guint) (sep - file) : strlen (file);
+		child = gpk_file_list_node_new (node, i,
+						gpk_file_list_get_range_end (list, i, node->end, path_len),
+						name_offset, path_len);
+		child->index = node->children->len;
+		g_ptr_array_add (node->children, child);
+		i = child->end;
+	}
+}
+
+static gboolean
+gpk_file_list_node_has_children (GpkFileList *list, GpkFileListNode *node)
+{
+	if (node->end - node->start > 1)
+		return TRUE;
+	return strlen (gpk_file_list_get_file (list, node->start)) > node->path_len + 1;
+}
+
+/* only the next file can be below a directory in the sorted list */
+static gboolean
+gpk_file_list_is_directory (GpkFileList *list, guint idx)
+{
+	const gchar *file;
+	const gchar *next;
+	gsize len;
+
+	if (idx + 1 >= list->files->len)
+		return FALSE;
+	file = gpk_file_list_get_file (list, idx);
+	next = gpk_file_list_get_file (list, idx + 1);
+	len = strlen (file);
+	return strncmp (next, file, len) == 0 && next[len] == '/';
+}
+
+static guint
+gpk_file_list_get_n_rows (GpkFileList *list, GpkFileListNode *node)
+{
+	if (list->root == NULL)
+		return node == NULL ? list->files->len : 0;
+	if (node == NULL)
+		node = list->root;
+	gpk_file_list_node_ensure_children (list, node);
+	return node->children->len;
+}
+
+static gboolean
+gpk_file_list_set_iter (GpkFileList *list, GtkTreeIter *iter,
+			GpkFileListNode *parent, guint n)
+{
+	if (n >= gpk_file_list_get_n_rows (list, parent))
+		return FALSE;
+	iter->stamp = list->stamp;
+	if (list->root == NULL) {
+		iter->user_data = GUINT_TO_POINTER (n);
+	} else {
+		if (parent == NULL)
+			parent = list->root;
+		iter->user_data = g_ptr_array_index (parent->children, n);
+	}
+	return TRUE;
+}
+
+static GtkTreeModelFlags
+gpk_file_list_get_flags (GtkTreeModel *model)
+{
+	GpkFileList *list = GPK_FILE_LIST (model);
+	if (list->root == NULL)
+		return GTK_TREE_MODEL_LIST_ONLY | GTK_TREE_MODEL_ITERS_PERSIST;
+	return GTK_TREE_MODEL_ITERS_PERSIST;
+}
+
+static gint
+gpk_file_list_get_n_columns (GtkTreeModel *model)
+{
+	return GPK_FILE_LIST_COLUMN_LAST;
+}
+
+static GType
+gpk_file_list_get_column_type (GtkTreeModel *model, gint column)
+{
+	return G_TYPE_STRING;
+}
+
+static gboolean
+gpk_file_list_get_iter (GtkTreeModel *model, GtkTreeIter *iter, GtkTreePath *path)
+{
+	GpkFileList *list = GPK_FILE_LIST (model);
+	GpkFileListNode *node = NULL;
+	gint depth = 0;
+	gint *indices;
+	gint i;
+
+	indices = gtk_tree_path_get_indices_with_depth (path, &depth);
+	if (depth == 0 || (depth > 1 && list->root == NULL))
+		return FALSE;
+	for (i = 0; i < depth; i++) {
+		if (!gpk_file_list_set_iter (list, iter, node, indices[i]))
+			return FALSE;
+		node = iter->user_data;
+	}
+	return TRUE;
+}
+
+static GtkTreePath *
+gpk_file_list_get_path (GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GpkFileList *list = GPK_FILE_LIST (model);
+	GpkFileListNode *node;
+	GtkTreePath *path;
+
+	g_return_val_if_fail (iter->stamp == list->stamp, NULL);
+
+	if (list->root == NULL)
+		return gtk_tree_path_new_from_indices (GPOINTER_TO_UINT (iter->user_data), -1);
+	path = gtk_tree_path_new ();
+	for (node = iter->user_data; node != list->root; node = node->parent)
+		gtk_tree_path_prepend_index (path, node->index);
+	return path;
+}
+
+static void
+gpk_file_list_get_value (GtkTreeModel *model, GtkTreeIter *iter,
+			 gint column, GValue *value)
+{
+	GpkFileList *list = GPK_FILE_LIST (model);
+	GpkFileListNode *node;
+	const gchar *file;
+	guint idx;
+
+	g_return_if_fail (iter->stamp == list->stamp);
+
+	g_value_init (value, G_TYPE_STRING);
+
+	/* flat list of the full paths */
+	if (list->root == NULL) {
+		idx = GPOINTER_TO_UINT (iter->user_data);
+		if (column == GPK_FILE_LIST_COLUMN_TEXT) {
+			g_value_set_static_string (value, gpk_file_list_get_file (list, idx));
+		} else {
+			g_value_set_static_string (value, gpk_file_list_is_directory (list, idx) ?
+						   "folder" : "text-x-generic");
+		}
+		return;
+	}
+
+	/* just the name in the tree */
+	node = iter->user_data;
+	if (column == GPK_FILE_LIST_COLUMN_TEXT) {
+		file = gpk_file_list_get_file (list, node->start);
+		g_value_take_string (value, g_strndup (file + node->name_offset,
+						       node->path_len - node->name_offset));
+	} else {
+		g_value_set_static_string (value, gpk_file_list_node_has_children (list, node) ?
+					   "folder" : "text-x-generic");
+	}
+}
+
+static gboolean
+gpk_file_list_iter_next (GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GpkFileList *list = GPK_FILE_LIST (model);
+	GpkFileListNode *node;
+
+	if (list->root == NULL)
+		return gpk_file_list_set_iter (list, iter, NULL, GPOINTER_TO_UINT (iter->user_data) + 1);
+	node = iter->user_data;
+	return gpk_file_list_set_iter (list, iter, node->parent, node->index + 1);
+}
+
+static gboolean
+gpk_file_list_iter_nth_child (GtkTreeModel *model, GtkTreeIter *iter,
+			      GtkTreeIter *parent, gint n)
+{
+	GpkFileList *list = GPK_FILE_LIST (model);
+	if (parent != NULL && list->root == NULL)
+		return FALSE;
+	return gpk_file_list_set_iter (list, iter, parent != NULL ? parent->user_data : NULL, n);
+}
+
+static gboolean
+gpk_file_list_iter_children (GtkTreeModel *model, GtkTreeIter *iter, GtkTreeIter *parent)
+{
+	return gpk_file_list_iter_nth_child (model, iter, parent, 0);
+}
+
+static gboolean
+gpk_file_list_iter_has_child (GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GpkFileList *list = GPK_FILE_LIST (model);
+	if (list->root == NULL)
+		return FALSE;
+	return gpk_file_list_node_has_children (list, iter->user_data);
+}
+
+static gint
+gpk_file_list_iter_n_children (GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GpkFileList *list = GPK_FILE_LIST (model);
+	if (iter != NULL && list->root == NULL)
+		return 0;
+	return gpk_file_list_get_n_rows (list, iter != NULL ? iter->user_data : NULL);
+}
+
+static gboolean
+gpk_file_list_iter_parent (GtkTreeModel *model, GtkTreeIter *iter, GtkTreeIter *child)
+{
+	GpkFileList *list = GPK_FILE_LIST (model);
+	GpkFileListNode *node;
+
+	if (list->root == NULL)
+		return FALSE;
+	node = child->user_data;
+	if (node->parent == list->root)
+		return FALSE;
+	iter->stamp = list->stamp;
+	iter->user_data = node->parent;
+	return TRUE;
+}
+
+static void
+gpk_file_list_tree_model_init (GtkTreeModelIface *iface)
+{
+	iface->get_flags = gpk_file_list_get_flags;
+	iface->get_n_columns = gpk_file_list_get_n_columns;
+	iface->get_column_type = gpk_file_list_get_column_type;
+	iface->get_iter = gpk_file_list_get_iter;
+	iface->get_path = gpk_file_list_get_path;
+	iface->get_value = gpk_file_list_get_value;
+	iface->iter_next = gpk_file_list_iter_next;
+	iface->iter_children = gpk_file_list_iter_children;
+	iface->iter_has_child = gpk_file_list_iter_has_child;
+	iface->iter_n_children = gpk_file_list_iter_n_children;
+	iface->iter_nth_child = gpk_file_list_iter_nth_child;
+	iface->iter_parent = gpk_file_list_iter_parent;
+}
+
+static void
+gpk_file_list_finalize (GObject *object)
+{
+	GpkFileList *list = GPK_FILE_LIST (object);
+
+	if (list->root != NULL)
+		gpk_file_list_node_free (list->root);
+	g_ptr_array_unref (list->files);
+	g_ptr_array_unref (list->source);
+
+	G_OBJECT_CLASS (gpk_file_list_parent_class)->finalize (object);
+}
+
+static void
+gpk_file_list_class_init (GpkFileListClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = gpk_file_list_finalize;
+}
+
+static void
+gpk_file_list_init (GpkFileList *list)
+{
+	list->stamp = g_random_int ();
+}
+
+/**
+ * gpk_file_list_new:
+ * @files: file names sorted with gpk_file_list_sort()
+ * @tree: %TRUE to show the files as an expandable directory tree
+ * @filter: only show files containing this text, or %NULL
+ *
+ * Creates a tree model showing @files without copying them; the tree is
+ * only built as far as it has been expanded.
+ *
+ * Return value: a new #GpkFileList
+ **/
+GpkFileList *
+gpk_file_list_new (GPtrArray *files, gboolean tree, const gchar *filter)
+{
+	GpkFileList *list;
+	guint i;
+
+	list = g_object_new (GPK_TYPE_FILE_LIST, NULL);
+	list->source = g_ptr_array_ref (files);
+	if (filter != NULL && filter[0] != '\0') {
+		list->files = g_ptr_array_new ();
+		for (i = 0; i < files->len; i++) {
+			const gchar *file = g_ptr_array_index (files, i);
+			if (strstr (file, filter) != NULL)
+				g_ptr_array_add (list->files, (gpointer) file);
+		}
+	} else {
+		list->files = g_ptr_array_ref (files);
+	}
+	if (tree)
+		list->root = gpk_file_list_node_new (NULL, 0, list->files->len, 0, 0);
+	return list;
+}
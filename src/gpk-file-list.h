@@ -0,0 +1,46 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2008 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef GPK_FILE_LIST_H
+#define GPK_FILE_LIST_H
+
+#include <glib-object.h>
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define GPK_TYPE_FILE_LIST (gpk_file_list_get_type())
+G_DECLARE_FINAL_TYPE (GpkFileList, gpk_file_list, GPK, FILE_LIST, GObject)
+
+enum {
+	GPK_FILE_LIST_COLUMN_ICON,
+	GPK_FILE_LIST_COLUMN_TEXT,
+	GPK_FILE_LIST_COLUMN_LAST
+};
+
+GpkFileList	*gpk_file_list_new			(GPtrArray	*files,
+							 gboolean	 tree,
+							 const gchar	*filter);
+void		 gpk_file_list_sort			(GPtrArray	*files);
+
+G_END_DECLS
+
+#endif /* GPK_FILE_LIST_H */
@@ -0,0 +1,375 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2007-2008 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <string.h>
+#include <sys/types.h>
+#include <pwd.h>
+
+#include <packagekit-glib2/packagekit.h>
+
+#include "gpk-common.h"
+#include "gpk-enum.h"
+#include "gpk-log-record.h"
+
+typedef struct {
+	gchar		*user_name;
+	gchar		*real_name;
+} GpkLogRecordUser;
+
+/* uid -> GpkLogRecordUser, as the same few users do all the transactions;
+ * entries are never removed, so the strings can be used without the lock */
+static GHashTable *users = NULL;
+G_LOCK_DEFINE_STATIC (users);
+
+static void
+gpk_log_record_package_clear (GpkLogRecordPackage *package)
+{
+	g_free (package->package_id);
+	g_strfreev (package->split);
+}
+
+static void
+gpk_log_record_parse_data (GpkLogRecord *record, const gchar *data)
+{
+	guint i;
+	g_auto(GStrv) lines = NULL;
+
+	/* each line is "info\tpackage_id" */
+	lines = g_strsplit (data, "\n", 0);
+	for (i = 0; lines[i] != NULL; i++) {
+		GpkLogRecordPackage package;
+		gchar *tab;
+
+		tab = strchr (lines[i], '\t');
+		if (tab == NULL)
+			continue;
+		*tab = '\0';
+		package.split = pk_package_id_split (tab + 1);
+		if (package.split == NULL) {
+			g_debug ("invalid package-id %s in %s", tab + 1, record->tid);
+			continue;
+		}
+		package.info = pk_info_enum_from_string (lines[i]);
+		package.package_id = g_strdup (tab + 1);
+		g_array_append_val (record->packages, package);
+	}
+}
+
+/**
+ * gpk_log_record_new:
+ *
+ * Parses one transaction from the history database. The arguments are the
+ * same as the Transaction signal emitted by GetOldTransactions.
+ *
+ * Return value: a new #GpkLogRecord
+ **/
+GpkLogRecord *
+gpk_log_record_new (const gchar *tid,
+		    const gchar *timespec,
+		    gboolean succeeded,
+		    PkRoleEnum role,
+		    guint duration,
+		    const gchar *data,
+		    guint uid,
+		    const gchar *cmdline)
+{
+	GpkLogRecord *record;
+
+	record = g_new0 (GpkLogRecord, 1);
+	record->tid = g_strdup (tid);
+	record->timespec = g_strdup (timespec);
+	record->succeeded = succeeded;
+	record->role = role;
+	record->duration = duration;
+	record->uid = uid;
+	record->cmdline = g_strdup (cmdline != NULL ? cmdline : "");
+	record->packages = g_array_new (FALSE, FALSE, sizeof (GpkLogRecordPackage));
+	g_array_set_clear_func (record->packages, (GDestroyNotify) gpk_log_record_package_clear);
+	if (data != NULL)
+		gpk_log_record_parse_data (record, data);
+	return record;
+}
+
+/**
+ * gpk_log_record_new_from_past:
+ *
+ * Return value: a new #GpkLogRecord
+ **/
+GpkLogRecord *
+gpk_log_record_new_from_past (PkTransactionPast *item)
+{
+	return gpk_log_record_new (pk_transaction_past_get_id (item),
+				   pk_transaction_past_get_timespec (item),
+				   pk_transaction_past_get_succeeded (item),
+				   pk_transaction_past_get_role (item),
+				   pk_transaction_past_get_duration (item),
+				   pk_transaction_past_get_data (item),
+				   pk_transaction_past_get_uid (item),
+				   pk_transaction_past_get_cmdline (item));
+}
+
+/**
+ * gpk_log_record_free:
+ **/
+void
+gpk_log_record_free (GpkLogRecord *record)
+{
+	g_free (record->tid);
+	g_free (record->timespec);
+	g_free (record->cmdline);
+	g_array_unref (record->packages);
+	g_free (record);
+}
+
+/**
+ * gpk_log_record_match:
+ * @text: the filter text, or %NULL to match everything
+ *
+ * Only transactions that succeeded are ever matched.
+ *
+ * Return value: %TRUE if the transaction should be shown
+ **/
+gboolean
+gpk_log_record_match (GpkLogRecord *record, const gchar *text)
+{
+	guint i;
+
+	/* only show transactions that succeeded */
+	if (!record->succeeded)
+		return FALSE;
+
+	if (text == NULL)
+		return TRUE;
+
+	/* matches cmdline */
+	if (strstr (record->cmdline, text) != NULL)
+		return TRUE;
+
+	/* look in all the data for the filter string */
+	for (i = 0; i < record->packages->len; i++) {
+		GpkLogRecordPackage *package;
+		package = &g_array_index (record->packages, GpkLogRecordPackage, i);
+
+		/* check if type matches filter */
+		if (strstr (pk_info_enum_to_string (package->info), text) != NULL)
+			return TRUE;
+
+		/* check to see if package name, version or arch matches */
+		if (strstr (package->split[PK_PACKAGE_ID_NAME], text) != NULL)
+			return TRUE;
+		if (strstr (package->split[PK_PACKAGE_ID_VERSION], text) != NULL)
+			return TRUE;
+		if (strstr (package->split[PK_PACKAGE_ID_ARCH], text) != NULL)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static gchar *
+gpk_log_record_get_type_line (GpkLogRecord *record, PkInfoEnum info)
+{
+	guint i;
+	GString *string;
+
+	string = g_string_new ("");
+
+	/* find all of this type */
+	for (i = 0; i < record->packages->len; i++) {
+		GpkLogRecordPackage *package;
+		g_autofree gchar *str = NULL;
+
+		package = &g_array_index (record->packages, GpkLogRecordPackage, i);
+		if (package->info != info)
+			continue;
+		str = gpk_package_id_format_oneline (package->package_id, NULL);
+		g_string_append_printf (string, "%s, ", str);
+	}
+
+	/* nothing, so return NULL */
+	if (string->len == 0) {
+		g_string_free (string, TRUE);
+		return NULL;
+	}
+
+	/* remove last comma space */
+	g_string_set_size (string, string->len - 2);
+
+	/* add a nice header, and make text italic */
+	g_string_prepend (string, "</b>: ");
+	g_string_prepend (string, gpk_info_enum_to_localised_past (info));
+	g_string_prepend (string, "<b>");
+	g_string_append_c (string, '\n');
+	return g_string_free (string, FALSE);
+}
+
+/**
+ * gpk_log_record_get_details:
+ *
+ * Return value: the localised packages affected, as Pango markup
+ **/
+gchar *
+gpk_log_record_get_details (GpkLogRecord *record)
+{
+	GString *string;
+	gchar *text;
+
+	string = g_string_new ("");
+
+	/* get each type */
+	text = gpk_log_record_get_type_line (record, PK_INFO_ENUM_INSTALLING);
+	if (text != NULL)
+		g_string_append (string, text);
+	g_free (text);
+	text = gpk_log_record_get_type_line (record, PK_INFO_ENUM_REMOVING);
+	if (text != NULL)
+		g_string_append (string, text);
+	g_free (text);
+	text = gpk_log_record_get_type_line (record, PK_INFO_ENUM_UPDATING);
+	if (text != NULL)
+		g_string_append (string, text);
+	g_free (text);
+
+	/* remove last \n */
+	if (string->len > 0)
+		g_string_set_size (string, string->len - 1);
+
+	return g_string_free (string, FALSE);
+}
+
+/**
+ * gpk_log_record_get_date:
+ *
+ * Return value: the localised date of the transaction
+ **/
+gchar *
+gpk_log_record_get_date (GpkLogRecord *record)
+{
+	g_autoptr(GDateTime) date_time = NULL;
+
+	date_time = g_date_time_new_from_iso8601 (record->timespec, NULL);
+	if (date_time == NULL) {
+		g_warning ("failed to parse date %s", record->timespec);
+		return g_strdup (record->timespec);
+	}
+
+	/* TRANSLATORS: strftime formatted please */
+	return g_date_time_format (date_time, _("%d %B %Y"));
+}
+
+/**
+ * gpk_log_record_get_tool:
+ *
+ * Return value: a user-friendly name for the program that did the transaction
+ **/
+const gchar *
+gpk_log_record_get_tool (GpkLogRecord *record)
+{
+	const gchar *cmdline = record->cmdline;
+
+	if (strstr (cmdline, "pkcon") != NULL)
+		/* TRANSLATORS: user-friendly name for pkcon */
+		return _("Command line client");
+	if (strstr (cmdline, "gpk-application") != NULL)
+		/* TRANSLATORS: user-friendly name for gpk-update-viewer */
+		return _("GNOME Packages");
+	if (strstr (cmdline, "gpk-update-viewer") != NULL)
+		/* TRANSLATORS: user-friendly name for gpk-update-viewer */
+		return _("GNOME Package Updater");
+	if (strstr (cmdline, "gpk-update-icon") != NULL)
+		/* TRANSLATORS: user-friendly name for gpk-update-icon, which used to exist */
+		return _("Update Icon");
+	if (strstr (cmdline, "pk-command-not-found") != NULL)
+		/* TRANSLATORS: user-friendly name for the command not found plugin */
+		return _("Bash – Command Not Found");
+	if (strstr (cmdline, "gnome-settings-daemon") != NULL)
+		/* TRANSLATORS: user-friendly name for gnome-settings-daemon, which used to handle updates */
+		return _("GNOME Session");
+	if (strstr (cmdline, "gnome-software") != NULL)
+		/* TRANSLATORS: user-friendly name for gnome-software */
+		return _("GNOME Software");
+	return cmdline;
+}
+
+static void
+gpk_log_record_user_free (GpkLogRecordUser *user)
+{
+	g_free (user->user_name);
+	g_free (user->real_name);
+	g_free (user);
+}
+
+static GpkLogRecordUser *
+gpk_log_record_get_user (guint uid)
+{
+	GpkLogRecordUser *user;
+	struct passwd pwbuf;
+	struct passwd *pw = NULL;
+	gchar buf[1024];
+
+	G_LOCK (users);
+	if (users == NULL) {
+		users = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+					       (GDestroyNotify) gpk_log_record_user_free);
+	}
+	user = g_hash_table_lookup (users, GUINT_TO_POINTER (uid));
+	if (user != NULL)
+		goto out;
+
+	/* query real name, this is called from the parser threads too */
+	user = g_new0 (GpkLogRecordUser, 1);
+	if (getpwuid_r (uid, &pwbuf, buf, sizeof (buf), &pw) == 0 && pw != NULL) {
+		user->user_name = g_strdup (pw->pw_name);
+		if (pw->pw_gecos != NULL)
+			user->real_name = g_strdup (pw->pw_gecos);
+		else
+			user->real_name = g_strdup (pw->pw_name);
+	}
+	g_hash_table_insert (users, GUINT_TO_POINTER (uid), user);
+out:
+	G_UNLOCK (users);
+	return user;
+}
+
+/**
+ * gpk_log_record_get_user_name:
+ *
+ * Return value: the login name of the user, or %NULL if unknown
+ **/
+const gchar *
+gpk_log_record_get_user_name (GpkLogRecord *record)
+{
+	return gpk_log_record_get_user (record->uid)->user_name;
+}
+
+/**
+ * gpk_log_record_get_real_name:
+ *
+ * Return value: the full name of the user, or %NULL if unknown
+ **/
+const gchar *
+gpk_log_record_get_real_name (GpkLogRecord *record)
+{
+	return gpk_log_record_get_user (record->uid)->real_name;
+}
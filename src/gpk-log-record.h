@@ -0,0 +1,69 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2007-2008 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __GPK_LOG_RECORD_H
+#define __GPK_LOG_RECORD_H
+
+#include <glib.h>
+#include <packagekit-glib2/packagekit.h>
+
+G_BEGIN_DECLS
+
+typedef struct {
+	PkInfoEnum	 info;
+	gchar		*package_id;
+	gchar		**split;
+} GpkLogRecordPackage;
+
+typedef struct {
+	gchar		*tid;
+	gchar		*timespec;
+	gboolean	 succeeded;
+	PkRoleEnum	 role;
+	guint		 duration;
+	guint		 uid;
+	gchar		*cmdline;
+	GArray		*packages;
+} GpkLogRecord;
+
+GpkLogRecord	*gpk_log_record_new			(const gchar	*tid,
+							 const gchar	*timespec,
+							 gboolean	 succeeded,
+							 PkRoleEnum	 role,
+							 guint		 duration,
+							 const gchar	*data,
+							 guint		 uid,
+							 const gchar	*cmdline);
+GpkLogRecord	*gpk_log_record_new_from_past		(PkTransactionPast *item);
+void		 gpk_log_record_free			(GpkLogRecord	*record);
+gboolean	 gpk_log_record_match			(GpkLogRecord	*record,
+							 const gchar	*text);
+gchar		*gpk_log_record_get_details		(GpkLogRecord	*record);
+gchar		*gpk_log_record_get_date		(GpkLogRecord	*record);
+const gchar	*gpk_log_record_get_tool		(GpkLogRecord	*record);
+const gchar	*gpk_log_record_get_user_name		(GpkLogRecord	*record);
+const gchar	*gpk_log_record_get_real_name		(GpkLogRecord	*record);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(GpkLogRecord, gpk_log_record_free)
+
+G_END_DECLS
+
+#endif	/* __GPK_LOG_RECORD_H */
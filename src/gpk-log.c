@@ -26,23 +26,63 @@
 
 #include <gtk/gtk.h>
 #include <locale.h>
-#include <sys/types.h>
-#include <pwd.h>
+#include <string.h>
 
 #include <packagekit-glib2/packagekit.h>
 
 #include "gpk-common.h"
 #include "gpk-debug.h"
+#include "gpk-log-record.h"
 
 static GtkBuilder *builder = NULL;
 static GtkListStore *list_store = NULL;
+static GtkTreeModel *filter_model = NULL;
 static PkClient *client = NULL;
 static gchar *transaction_id = NULL;
 static gchar *filter = NULL;
 static GPtrArray *transactions = NULL;
-static GtkTreePath *path_global = NULL;
+static GHashTable *transaction_ids = NULL;
+static GCancellable *cancellable = NULL;
+static GSettings *settings = NULL;
+static guint history_requested = 0;
+static gboolean history_complete = FALSE;
+static guint fetch_page_id = 0;
+static GQueue pending_rows = G_QUEUE_INIT;
+static guint pending_batches = 0;
+static guint insert_id = 0;
+static guint insert_trace = 0;	/* for the page being inserted */
 static guint xid = 0;
 
+#define GPK_LOG_FILTER_DELAY		150 /* ms */
+#define GPK_LOG_SCAN_SLICE		4000 /* us */
+#define GPK_LOG_INSERT_SLICE		4000 /* us */
+#define GPK_LOG_PARSE_BATCH		250
+
+/* parsed and formatted on a worker thread, ready to insert */
+typedef struct {
+	GpkLogRecord	*record;
+	gchar		*details;
+	gchar		*date;
+	const gchar	*icon_name;
+	const gchar	*role_text;
+	const gchar	*user;
+	const gchar	*tool;
+} GpkLogRow;
+
+typedef struct {
+	guint8		*data;
+	gsize		 len;
+} GpkLogBitmap;
+
+/* one bit per transaction, set if it matches the filter */
+static GpkLogBitmap filter_bitmap = { NULL, 0 };
+static GpkLogBitmap scan_bitmap = { NULL, 0 };
+static gchar *scan_filter = NULL;
+static gboolean scan_incremental = FALSE;
+static guint scan_idx = 0;
+static guint scan_id = 0;
+static guint filter_timeout_id = 0;
+
 enum
 {
 	GPK_LOG_COLUMN_ICON,
@@ -54,162 +94,10 @@ enum
 	GPK_LOG_COLUMN_ID,
 	GPK_LOG_COLUMN_USER,
 	GPK_LOG_COLUMN_TOOL,
-	GPK_LOG_COLUMN_ACTIVE,
+	GPK_LOG_COLUMN_INDEX,
 	GPK_LOG_COLUMN_LAST
 };
 
-static gboolean
-gpk_log_find_iter_model_cb (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, const gchar *id)
-{
-	gchar *id_tmp = NULL;
-	gtk_tree_model_get (model, iter, GPK_LOG_COLUMN_ID, &id_tmp, -1);
-	if (strcmp (id_tmp, id) == 0) {
-		path_global = gtk_tree_path_copy (path);
-		return TRUE;
-	}
-	return FALSE;
-}
-
-static gboolean
-gpk_log_mark_nonactive_cb (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, gpointer data)
-{
-	gtk_list_store_set (GTK_LIST_STORE(model), iter, GPK_LOG_COLUMN_ACTIVE, FALSE, -1);
-	return FALSE;
-}
-
-static void
-gpk_log_mark_nonactive (GtkTreeModel *model)
-{
-	gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) gpk_log_mark_nonactive_cb, NULL);
-}
-
-static gboolean
-gpk_log_remove_nonactive_cb (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, gboolean *ret)
-{
-	gboolean active;
-	gtk_tree_model_get (model, iter, GPK_LOG_COLUMN_ACTIVE, &active, -1);
-	if (!active) {
-		*ret = TRUE;
-		gtk_list_store_remove (GTK_LIST_STORE(model), iter);
-		return TRUE;
-	}
-	return FALSE;
-}
-
-static void
-gpk_log_remove_nonactive (GtkTreeModel *model)
-{
-	gboolean ret;
-	/* do this again and again as removing in gtk_tree_model_foreach causes errors */
-	do {
-		ret = FALSE;
-		gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) gpk_log_remove_nonactive_cb, &ret);
-	} while (ret);
-}
-
-static gboolean
-gpk_log_model_get_iter (GtkTreeModel *model, GtkTreeIter *iter, const gchar *id)
-{
-	gboolean ret = TRUE;
-	path_global = NULL;
-	gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) gpk_log_find_iter_model_cb, (gpointer) id);
-	if (path_global == NULL) {
-		gtk_list_store_append (GTK_LIST_STORE(model), iter);
-	} else {
-		ret = gtk_tree_model_get_iter (model, iter, path_global);
-		gtk_tree_path_free (path_global);
-	}
-	return ret;
-}
-
-static gchar *
-gpk_log_get_localised_date (const gchar *timespec)
-{
-	g_autoptr(GDateTime) date_time = NULL;
-
-	date_time = g_date_time_new_from_iso8601 (timespec, NULL);
-	if (date_time == NULL) {
-		g_warning ("failed to parse date %s", timespec);
-		return g_strdup (timespec);
-	}
-
-	/* TRANSLATORS: strftime formatted please */
-	return g_date_time_format (date_time, _("%d %B %Y"));
-}
-
-static gchar *
-gpk_log_get_type_line (gchar **array, PkInfoEnum info)
-{
-	guint i;
-	guint size;
-	PkInfoEnum info_local;
-	const gchar *info_text;
-	GString *string;
-	g_autofree gchar *text = NULL;
-	gchar *whole;
-
-	string = g_string_new ("");
-	size = g_strv_length (array);
-	info_text = gpk_info_enum_to_localised_past (info);
-
-	/* find all of this type */
-	for (i = 0; i < size; i++) {
-		g_auto(GStrv) sections = NULL;
-		sections = g_strsplit (array[i], "\t", 0);
-		info_local = pk_info_enum_from_string (sections[0]);
-		if (info_local == info) {
-			g_autofree gchar *str = NULL;
-			str = gpk_package_id_format_oneline (sections[1], NULL);
-			g_string_append_printf (string, "%s, ", str);
-		}
-	}
-
-	/* nothing, so return NULL */
-	if (string->len == 0) {
-		g_string_free (string, TRUE);
-		return NULL;
-	}
-
-	/* remove last comma space */
-	g_string_set_size (string, string->len - 2);
-
-	/* add a nice header, and make text italic */
-	text = g_string_free (string, FALSE);
-	whole = g_strdup_printf ("<b>%s</b>: %s\n", info_text, text);
-	return whole;
-}
-
-static gchar *
-gpk_log_get_details_localised (const gchar *timespec, const gchar *data)
-{
-	GString *string;
-	gchar *text;
-	g_auto(GStrv) array = NULL;
-
-	string = g_string_new ("");
-	array = g_strsplit (data, "\n", 0);
-
-	/* get each type */
-	text = gpk_log_get_type_line (array, PK_INFO_ENUM_INSTALLING);
-	if (text != NULL)
-		g_string_append (string, text);
-	g_free (text);
-	text = gpk_log_get_type_line (array, PK_INFO_ENUM_REMOVING);
-	if (text != NULL)
-		g_string_append (string, text);
-	g_free (text);
-	text = gpk_log_get_type_line (array, PK_INFO_ENUM_UPDATING);
-	if (text != NULL)
-		g_string_append (string, text);
-	g_free (text);
-
-	/* remove last \n */
-	if (string->len > 0)
-		g_string_set_size (string, string->len - 1);
-
-	return g_string_free (string, FALSE);
-}
-
 static void
 gpk_log_treeview_size_allocate_cb (GtkWidget *widget, GtkAllocation *allocation, GtkCellRenderer *cell)
 {
@@ -292,214 +180,324 @@ gpk_log_treeview_clicked_cb (GtkTreeSelection *selection, gpointer data)
 {
 	GtkTreeModel *model;
 	GtkTreeIter iter;
-	gchar *id;
 
 	/* This will only work in single or browse selection mode! */
 	if (gtk_tree_selection_get_selected (selection, &model, &iter)) {
 		g_free (transaction_id);
-		gtk_tree_model_get (model, &iter, GPK_LOG_COLUMN_ID, &id, -1);
+		gtk_tree_model_get (model, &iter, GPK_LOG_COLUMN_ID, &transaction_id, -1);
 
 		/* show transaction_id */
-		g_debug ("selected row is: %s", id);
-		g_free (id);
+		g_debug ("selected row is: %s", transaction_id);
 	} else {
 		g_debug ("no row selected");
 	}
 }
 
 static gboolean
-gpk_log_filter (PkTransactionPast *item)
+gpk_log_bitmap_get (GpkLogBitmap *bitmap, guint idx)
 {
-	gboolean ret = FALSE;
-	guint i;
-	guint length;
-	g_auto(GStrv) packages = NULL;
-	g_autofree gchar *tid = NULL;
-	gboolean succeeded;
-	g_autofree gchar *cmdline = NULL;
-	g_autofree gchar *data = NULL;
-
-	/* get data */
-	g_object_get (item,
-		      "tid", &tid,
-		      "succeeded", &succeeded,
-		      "cmdline", &cmdline,
-		      "data", &data,
-		      NULL);
-
-	/* only show transactions that succeeded */
-	if (!succeeded) {
-		g_debug ("tid %s did not succeed, so not adding", tid);
+	if (idx / 8 >= bitmap->len)
 		return FALSE;
-	}
+	return (bitmap->data[idx / 8] & (1 << (idx % 8))) > 0;
+}
 
-	if (filter == NULL)
-		return TRUE;
-
-	/* matches cmdline */
-	if (cmdline != NULL && g_strrstr (cmdline, filter) != NULL)
-		ret = TRUE;
-
-	/* look in all the data for the filter string */
-	packages = g_strsplit (data, "\n", 0);
-	length = g_strv_length (packages);
-	for (i = 0; i < length; i++) {
-		g_auto(GStrv) split = NULL;
-		g_auto(GStrv) sections = NULL;
-		sections = g_strsplit (packages[i], "\t", 0);
-
-		/* check if type matches filter */
-		if (g_strrstr (sections[0], filter) != NULL)
-			ret = TRUE;
-
-		/* check to see if package name, version or arch matches */
-		split = pk_package_id_split (sections[1]);
-		if (g_strrstr (split[0], filter) != NULL)
-			ret = TRUE;
-		if (split[1] != NULL && g_strrstr (split[1], filter) != NULL)
-			ret = TRUE;
-		if (split[2] != NULL && g_strrstr (split[2], filter) != NULL)
-			ret = TRUE;
-
-		/* shortcut for speed */
-		if (ret)
-			break;
+static void
+gpk_log_bitmap_set (GpkLogBitmap *bitmap, guint idx, gboolean match)
+{
+	gsize len = (idx / 8) + 1;
+
+	/* grow the bitmap as pages of history arrive */
+	if (len > bitmap->len) {
+		len = MAX (len, bitmap->len * 2);
+		bitmap->data = g_realloc (bitmap->data, len);
+		memset (bitmap->data + bitmap->len, 0, len - bitmap->len);
+		bitmap->len = len;
 	}
-	return ret;
+	if (match)
+		bitmap->data[idx / 8] |= 1 << (idx % 8);
+	else
+		bitmap->data[idx / 8] &= ~(1 << (idx % 8));
+}
+
+static gboolean
+gpk_log_visible_func (GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data)
+{
+	guint idx;
+
+	gtk_tree_model_get (model, iter, GPK_LOG_COLUMN_INDEX, &idx, -1);
+	return gpk_log_bitmap_get (&filter_bitmap, idx);
 }
 
 static void
-gpk_log_add_item (PkTransactionPast *item)
+gpk_log_scan_stop (void)
 {
-	GtkTreeIter iter;
-	g_autofree gchar *details = NULL;
-	g_autofree gchar *date = NULL;
-	const gchar *icon_name;
-	const gchar *role_text;
-	const gchar *username = NULL;
-	const gchar *tool;
-	static guint count;
-	struct passwd *pw;
-	g_autofree gchar *tid = NULL;
-	g_autofree gchar *timespec = NULL;
-	gboolean succeeded;
-	guint duration;
-	g_autofree gchar *cmdline = NULL;
-	guint uid;
-	g_autofree gchar *data = NULL;
-	PkRoleEnum role;
-	GtkTreeView *treeview = GTK_TREE_VIEW (gtk_builder_get_object (builder, "treeview_simple"));
-	GtkTreeModel *model = gtk_tree_view_get_model (treeview);
-
-	/* get data */
-	g_object_get (item,
-		      "role", &role,
-		      "tid", &tid,
-		      "timespec", &timespec,
-		      "succeeded", &succeeded,
-		      "duration", &duration,
-		      "cmdline", &cmdline,
-		      "uid", &uid,
-		      "data", &data,
-		      NULL);
+	if (scan_id != 0) {
+		g_source_remove (scan_id);
+		scan_id = 0;
+	}
+	g_clear_pointer (&scan_filter, g_free);
+}
 
-	/* put formatted text into treeview */
-	details = gpk_log_get_details_localised (timespec, data);
-	date = gpk_log_get_localised_date (timespec);
-
-	icon_name = gpk_role_enum_to_icon_name (role);
-	role_text = gpk_role_enum_to_localised_past (role);
-
-	/* query real name */
-	pw = getpwuid(uid);
-	if (pw != NULL) {
-		if (pw->pw_gecos != NULL)
-			username = pw->pw_gecos;
-		else if (pw->pw_name != NULL)
-			username = pw->pw_name;
-	}
-
-	/* get nice name for tool name */
-	if (strstr (cmdline, "pkcon") != NULL)
-		/* TRANSLATORS: user-friendly name for pkcon */
-		tool = _("Command line client");
-	else if (strstr (cmdline, "gpk-application") != NULL)
-		/* TRANSLATORS: user-friendly name for gpk-update-viewer */
-		tool = _("GNOME Packages");
-	else if (strstr (cmdline, "gpk-update-viewer") != NULL)
-		/* TRANSLATORS: user-friendly name for gpk-update-viewer */
-		tool = _("GNOME Package Updater");
-	else if (strstr (cmdline, "gpk-update-icon") != NULL)
-		/* TRANSLATORS: user-friendly name for gpk-update-icon, which used to exist */
-		tool = _("Update Icon");
-	else if (strstr (cmdline, "pk-command-not-found") != NULL)
-		/* TRANSLATORS: user-friendly name for the command not found plugin */
-		tool = _("Bash – Command Not Found");
-	else if (strstr (cmdline, "gnome-settings-daemon") != NULL)
-		/* TRANSLATORS: user-friendly name for gnome-settings-daemon, which used to handle updates */
-		tool = _("GNOME Session");
-	else if (strstr (cmdline, "gnome-software") != NULL)
-		/* TRANSLATORS: user-friendly name for gnome-software */
-		tool = _("GNOME Software");
-	else
-		tool = cmdline;
-
-	gpk_log_model_get_iter (model, &iter, tid);
-	gtk_list_store_set (list_store, &iter,
-			    GPK_LOG_COLUMN_ICON, icon_name,
-			    GPK_LOG_COLUMN_TIMESPEC, timespec,
-			    GPK_LOG_COLUMN_DATE_TEXT, date,
-			    GPK_LOG_COLUMN_DATE, timespec,
-			    GPK_LOG_COLUMN_ROLE, role_text,
-			    GPK_LOG_COLUMN_DETAILS, details,
-			    GPK_LOG_COLUMN_ID, tid,
-			    GPK_LOG_COLUMN_USER, username,
-			    GPK_LOG_COLUMN_TOOL, tool,
-			    GPK_LOG_COLUMN_ACTIVE, TRUE, -1);
-
-	/* spin the gui */
-	if (count++ % 10 == 0)
-		while (gtk_events_pending ())
-			gtk_main_iteration ();
+static gboolean
+gpk_log_scan_cb (gpointer user_data)
+{
+	GpkLogBitmap tmp;
+	GpkLogRecord *record;
+	gboolean match;
+	gint64 start;
+
+	/* only do a slice of the work so typing never stalls */
+	start = g_get_monotonic_time ();
+	while (scan_idx < transactions->len) {
+
+		/* only rows that matched the previous filter can match this one */
+		if (scan_incremental && !gpk_log_bitmap_get (&filter_bitmap, scan_idx)) {
+			match = FALSE;
+		} else {
+			record = g_ptr_array_index (transactions, scan_idx);
+			match = gpk_log_record_match (record, scan_filter);
+		}
+		gpk_log_bitmap_set (&scan_bitmap, scan_idx++, match);
+		if (g_get_monotonic_time () - start > GPK_LOG_SCAN_SLICE)
+			return G_SOURCE_CONTINUE;
+	}
+
+	/* the rows stay in the base model, we just hide the ones that do not match */
+	g_debug ("filtered %u transactions with '%s'", transactions->len, scan_filter);
+	tmp = filter_bitmap;
+	filter_bitmap = scan_bitmap;
+	scan_bitmap = tmp;
+	g_free (filter);
+	filter = g_steal_pointer (&scan_filter);
+	gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter_model));
+	scan_id = 0;
+	return G_SOURCE_REMOVE;
 }
 
 static void
 gpk_log_refilter (void)
 {
-	guint i;
-	gboolean ret;
-	PkTransactionPast *item;
 	GtkWidget *widget;
 	const gchar *package;
-	GtkTreeView *treeview;
-	GtkTreeModel *model;
 
-	/* set the new filter */
-	g_free (filter);
+	/* any pass for an older query is now stale */
+	gpk_log_scan_stop ();
+	if (filter_timeout_id != 0) {
+		g_source_remove (filter_timeout_id);
+		filter_timeout_id = 0;
+	}
+
+	/* get the new filter */
 	widget = GTK_WIDGET (gtk_builder_get_object (builder, "entry_package"));
 	package = gtk_entry_get_text (GTK_ENTRY(widget));
 	if (package != NULL && package[0] != '\0')
-		filter = g_strdup (package);
-	else
-		filter = NULL;
+		scan_filter = g_strdup (package);
 
-	g_debug ("len=%u", transactions->len);
+	/* already showing this */
+	if (g_strcmp0 (scan_filter, filter) == 0) {
+		g_clear_pointer (&scan_filter, g_free);
+		return;
+	}
+
+	/* a longer query can only match a subset of the rows shown now */
+	scan_incremental = filter != NULL && scan_filter != NULL &&
+			   strstr (scan_filter, filter) != NULL;
+	g_debug ("filtering %u transactions with '%s' (incremental: %i)",
+		 transactions->len, scan_filter, scan_incremental);
 
-	/* mark the items as not used */
-	treeview = GTK_TREE_VIEW (gtk_builder_get_object (builder, "treeview_simple"));
-	model = gtk_tree_view_get_model (treeview);
-	gpk_log_mark_nonactive (model);
+	scan_idx = 0;
+	scan_id = g_idle_add (gpk_log_scan_cb, NULL);
+	g_source_set_name_by_id (scan_id, "[GpkLog] filter");
+}
 
-	/* go through the list, adding and removing the items as required */
-	for (i = 0; i < transactions->len; i++) {
-		item = g_ptr_array_index (transactions, i);
-		ret = gpk_log_filter (item);
-		if (ret)
-			gpk_log_add_item (item);
+static gboolean
+gpk_log_filter_timeout_cb (gpointer user_data)
+{
+	filter_timeout_id = 0;
+	gpk_log_refilter ();
+	return G_SOURCE_REMOVE;
+}
+
+static void
+gpk_log_row_free (GpkLogRow *row)
+{
+	if (row->record != NULL)
+		gpk_log_record_free (row->record);
+	g_free (row->details);
+	g_free (row->date);
+	g_free (row);
+}
+
+static void
+gpk_log_rows_free (GPtrArray *rows)
+{
+	g_ptr_array_foreach (rows, (GFunc) gpk_log_row_free, NULL);
+	g_ptr_array_unref (rows);
+}
+
+static void
+gpk_log_parse_thread_cb (GTask *task,
+			 gpointer source_object,
+			 gpointer task_data,
+			 GCancellable *task_cancellable)
+{
+	GPtrArray *items = (GPtrArray *) task_data;
+	GPtrArray *rows;
+	GpkLogRow *row;
+	guint i;
+
+	/* do all the parsing and formatting here, off the main thread */
+	rows = g_ptr_array_sized_new (items->len);
+	for (i = 0; i < items->len; i++) {
+		if (g_cancellable_is_cancelled (task_cancellable)) {
+			gpk_log_rows_free (rows);
+			g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+						 "history loading was cancelled");
+			return;
+		}
+		row = g_new0 (GpkLogRow, 1);
+		row->record = gpk_log_record_new_from_past (g_ptr_array_index (items, i));
+		if (row->record->succeeded) {
+			row->details = gpk_log_record_get_details (row->record);
+			row->date = gpk_log_record_get_date (row->record);
+			row->icon_name = gpk_role_enum_to_icon_name (row->record->role);
+			row->role_text = gpk_role_enum_to_localised_past (row->record->role);
+			row->user = gpk_log_record_get_real_name (row->record);
+			row->tool = gpk_log_record_get_tool (row->record);
+		}
+		g_ptr_array_add (rows, row);
 	}
+	g_task_return_pointer (task, rows, (GDestroyNotify) gpk_log_rows_free);
+}
+
+static void
+gpk_log_insert_row (GpkLogRow *row)
+{
+	GpkLogRecord *record = g_steal_pointer (&row->record);
+	guint idx;
 
-	/* remove the items that are not used */
-	gpk_log_remove_nonactive (model);
+	g_ptr_array_add (transactions, record);
+	idx = transactions->len - 1;
+
+	/* work out if it is visible before the row is added */
+	gpk_log_bitmap_set (&filter_bitmap, idx, gpk_log_record_match (record, filter));
+
+	/* only show transactions that succeeded */
+	if (!record->succeeded)
+		return;
+	gtk_list_store_insert_with_values (list_store, NULL, -1,
+					   GPK_LOG_COLUMN_ICON, row->icon_name,
+					   GPK_LOG_COLUMN_TIMESPEC, record->timespec,
+					   GPK_LOG_COLUMN_DATE_TEXT, row->date,
+					   GPK_LOG_COLUMN_DATE, record->timespec,
+					   GPK_LOG_COLUMN_ROLE, row->role_text,
+					   GPK_LOG_COLUMN_DETAILS, row->details,
+					   GPK_LOG_COLUMN_ID, record->tid,
+					   GPK_LOG_COLUMN_USER, row->user,
+					   GPK_LOG_COLUMN_TOOL, row->tool,
+					   GPK_LOG_COLUMN_INDEX, idx, -1);
+}
+
+static void gpk_log_fetch_page (void);
+
+static gboolean
+gpk_log_fetch_page_cb (gpointer user_data)
+{
+	fetch_page_id = 0;
+	gpk_log_fetch_page ();
+	return G_SOURCE_REMOVE;
+}
+
+static void
+gpk_log_page_done (void)
+{
+	guint max_transactions;
+
+	g_debug ("%u transactions loaded", transactions->len);
+	gpk_trace_end (insert_trace,
+		       GTK_WIDGET (gtk_builder_get_object (builder, "treeview_simple")));
+	insert_trace = 0;
+
+	/* we got less than we asked for, so there is no more history */
+	if (history_complete) {
+		g_debug ("loaded all history");
+		return;
+	}
+
+	/* keep the number of transactions in memory bounded */
+	max_transactions = g_settings_get_uint (settings, GPK_SETTINGS_LOG_MAX_TRANSACTIONS);
+	if (max_transactions > 0 && history_requested >= max_transactions) {
+		g_debug ("not loading more than %u transactions", max_transactions);
+		return;
+	}
+
+	/* get the next, older, page when the UI is idle */
+	fetch_page_id = g_idle_add_full (G_PRIORITY_LOW, gpk_log_fetch_page_cb, NULL, NULL);
+	g_source_set_name_by_id (fetch_page_id, "[GpkLog] fetch page");
+}
+
+static gboolean
+gpk_log_insert_cb (gpointer user_data)
+{
+	GpkLogRow *row;
+	gint64 start;
+
+	/* only insert for a few ms at a time so the window can still draw */
+	start = g_get_monotonic_time ();
+	while ((row = g_queue_pop_head (&pending_rows)) != NULL) {
+		gpk_log_insert_row (row);
+		gpk_log_row_free (row);
+		if (g_get_monotonic_time () - start > GPK_LOG_INSERT_SLICE)
+			return G_SOURCE_CONTINUE;
+	}
+	insert_id = 0;
+
+	/* wait for the rest of the page */
+	if (pending_batches == 0)
+		gpk_log_page_done ();
+	return G_SOURCE_REMOVE;
+}
+
+static void
+gpk_log_parse_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GError) error = NULL;
+	GPtrArray *rows;
+	guint i;
+
+	rows = g_task_propagate_pointer (G_TASK (res), &error);
+	if (rows == NULL) {
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			g_warning ("failed to parse transactions: %s", error->message);
+		return;
+	}
+
+	/* from before a refresh */
+	if (g_cancellable_is_cancelled (g_task_get_cancellable (G_TASK (res)))) {
+		gpk_log_rows_free (rows);
+		return;
+	}
+
+	/* queue up the rows for the main thread */
+	for (i = 0; i < rows->len; i++)
+		g_queue_push_tail (&pending_rows, g_ptr_array_index (rows, i));
+	g_ptr_array_unref (rows);
+	pending_batches--;
+	if (insert_id == 0) {
+		insert_id = g_idle_add (gpk_log_insert_cb, NULL);
+		g_source_set_name_by_id (insert_id, "[GpkLog] insert rows");
+	}
+}
+
+static void
+gpk_log_parse_batch (GPtrArray *batch)
+{
+	g_autoptr(GTask) task = NULL;
+
+	task = g_task_new (NULL, cancellable, gpk_log_parse_cb, NULL);
+	g_task_set_task_data (task, batch, (GDestroyNotify) g_ptr_array_unref);
+	g_task_run_in_thread (task, gpk_log_parse_thread_cb);
+	pending_batches++;
 }
 
 static void
@@ -507,15 +505,25 @@ gpk_log_get_old_transactions_cb (GObject *object, GAsyncResult *res, gpointer us
 {
 //	PkClient *client = PK_CLIENT (object);
 	g_autoptr(GError) error = NULL;
-	PkResults *results = NULL;
+	g_autoptr(PkResults) results = NULL;
 	g_autoptr(PkError) error_code = NULL;
+	g_autoptr(GPtrArray) array = NULL;
+	g_autoptr(GPtrArray) batch = NULL;
+	PkTransactionPast *item;
+	guint added = 0;
+	guint i;
+	guint token = GPOINTER_TO_UINT (user_data);
 
 	/* get the results */
 	results = pk_client_generic_finish (client, res, &error);
 	if (results == NULL) {
+		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			return;
 		g_warning ("failed to get old transactions: %s", error->message);
 		return;
 	}
+	gpk_trace_mark (token, GPK_TRACE_MARK_FINISHED);
+	insert_trace = token;
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -524,19 +532,88 @@ gpk_log_get_old_transactions_cb (GObject *object, GAsyncResult *res, gpointer us
 		return;
 	}
 
-	/* get the list */
-	if (transactions != NULL)
-		g_ptr_array_unref (transactions);
-	transactions = pk_results_get_transaction_array (results);
-	gpk_log_refilter ();
+	/* the daemon has no offset, so each page also contains the newer
+	 * transactions we already have -- only add the ones we have not seen */
+	array = pk_results_get_transaction_array (results);
+	for (i = 0; i < array->len; i++) {
+		item = g_ptr_array_index (array, i);
+		if (g_hash_table_contains (transaction_ids, pk_transaction_past_get_id (item)))
+			continue;
+		g_hash_table_add (transaction_ids, g_strdup (pk_transaction_past_get_id (item)));
+		added++;
+
+		/* parse in batches on the worker threads */
+		if (batch == NULL)
+			batch = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+		g_ptr_array_add (batch, g_object_ref (item));
+		if (batch->len == GPK_LOG_PARSE_BATCH)
+			gpk_log_parse_batch (g_steal_pointer (&batch));
+	}
+	if (batch != NULL)
+		gpk_log_parse_batch (g_steal_pointer (&batch));
+	g_debug ("parsing %u of %u transactions", added, array->len);
+
+	/* we got less than we asked for, so there is no more history */
+	history_complete = array->len < history_requested;
+	if (pending_batches == 0)
+		gpk_log_page_done ();
+}
+
+static void
+gpk_log_fetch_page (void)
+{
+	guint page_size;
+	guint max_transactions;
+
+	/* double the window each time so the total transferred stays linear */
+	page_size = g_settings_get_uint (settings, GPK_SETTINGS_LOG_PAGE_SIZE);
+	max_transactions = g_settings_get_uint (settings, GPK_SETTINGS_LOG_MAX_TRANSACTIONS);
+	if (history_requested == 0)
+		history_requested = page_size;
+	else
+		history_requested *= 2;
+	if (max_transactions > 0)
+		history_requested = MIN (history_requested, max_transactions);
+
+	/* get the most recent transactions async */
+	g_debug ("getting %u most recent transactions", history_requested);
+	pk_client_get_old_transactions_async (client, history_requested, cancellable, NULL, NULL,
+					      (GAsyncReadyCallback) gpk_log_get_old_transactions_cb,
+					      GUINT_TO_POINTER (gpk_trace_begin (PK_ROLE_ENUM_GET_OLD_TRANSACTIONS)));
 }
 
 static void
 gpk_log_refresh (void)
 {
-	/* get the list async */
-	pk_client_get_old_transactions_async (client, 0, NULL, NULL, NULL,
-					      (GAsyncReadyCallback) gpk_log_get_old_transactions_cb, NULL);
+	/* stop loading any older pages */
+	g_cancellable_cancel (cancellable);
+	g_object_unref (cancellable);
+	cancellable = g_cancellable_new ();
+	if (fetch_page_id != 0) {
+		g_source_remove (fetch_page_id);
+		fetch_page_id = 0;
+	}
+	if (insert_id != 0) {
+		g_source_remove (insert_id);
+		insert_id = 0;
+	}
+	g_queue_foreach (&pending_rows, (GFunc) gpk_log_row_free, NULL);
+	g_queue_clear (&pending_rows);
+	pending_batches = 0;
+
+	/* new pages are matched against the filter as they arrive */
+	if (scan_id != 0) {
+		g_free (filter);
+		filter = g_steal_pointer (&scan_filter);
+		gpk_log_scan_stop ();
+	}
+
+	/* start again with the first page */
+	gtk_list_store_clear (list_store);
+	g_ptr_array_set_size (transactions, 0);
+	g_hash_table_remove_all (transaction_ids);
+	history_requested = 0;
+	gpk_log_fetch_page ();
 }
 
 static void
@@ -552,11 +629,14 @@ gpk_log_button_filter_cb (GtkWidget *widget2, gpointer data)
 	gpk_log_refilter ();
 }
 
-static gboolean
-gpk_log_entry_filter_cb (GtkWidget *widget, GdkEventKey *event, gpointer user_data)
+static void
+gpk_log_entry_changed_cb (GtkEditable *editable, gpointer user_data)
 {
-	gpk_log_refilter ();
-	return FALSE;
+	/* wait for the user to stop typing */
+	if (filter_timeout_id != 0)
+		g_source_remove (filter_timeout_id);
+	filter_timeout_id = g_timeout_add (GPK_LOG_FILTER_DELAY, gpk_log_filter_timeout_cb, NULL);
+	g_source_set_name_by_id (filter_timeout_id, "[GpkLog] filter delay");
 }
 
 static void
@@ -574,12 +654,17 @@ gpk_log_startup_cb (GtkApplication *application, gpointer user_data)
 	GtkTreeSelection *selection;
 	GtkWidget *widget;
 	GtkWindow *window;
+	g_autoptr(GtkTreeModel) sort_model = NULL;
 	guint retval;
 
 	client = pk_client_new ();
 	g_object_set (client,
 		      "background", FALSE,
 		      NULL);
+	cancellable = g_cancellable_new ();
+	settings = g_settings_new (GPK_SETTINGS_SCHEMA);
+	transactions = g_ptr_array_new_with_free_func ((GDestroyNotify) gpk_log_record_free);
+	transaction_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
 	/* get UI */
 	builder = gtk_builder_new ();
@@ -588,7 +673,7 @@ gpk_log_startup_cb (GtkApplication *application, gpointer user_data)
 						&error);
 	if (retval == 0) {
 		g_warning ("failed to load ui: %s", error->message);
-		goto out;
+		return;
 	}
 
 	window = GTK_WINDOW (gtk_builder_get_object (builder, "dialog_simple"));
@@ -614,18 +699,23 @@ gpk_log_startup_cb (GtkApplication *application, gpointer user_data)
 	widget = GTK_WIDGET (gtk_builder_get_object (builder, "entry_package"));
 	g_signal_connect (widget, "activate", G_CALLBACK (gpk_log_button_filter_cb), NULL);
 
-	/* autocompletion can be turned off as it's slow */
-	g_signal_connect (widget, "key-release-event", G_CALLBACK (gpk_log_entry_filter_cb), NULL);
+	/* filter as you type */
+	g_signal_connect (widget, "changed", G_CALLBACK (gpk_log_entry_changed_cb), NULL);
 
 	/* create list stores */
 	list_store = gtk_list_store_new (GPK_LOG_COLUMN_LAST, G_TYPE_STRING, G_TYPE_STRING,
 					 G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
-					 G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_BOOLEAN);
+					 G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_UINT);
+
+	/* the filter hides rows, the sort model on top makes the columns sortable */
+	filter_model = gtk_tree_model_filter_new (GTK_TREE_MODEL (list_store), NULL);
+	gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter_model),
+						gpk_log_visible_func, NULL, NULL);
+	sort_model = gtk_tree_model_sort_new_with_model (filter_model);
 
 	/* create transaction_id tree view */
 	widget = GTK_WIDGET (gtk_builder_get_object (builder, "treeview_simple"));
-	gtk_tree_view_set_model (GTK_TREE_VIEW (widget),
-				 GTK_TREE_MODEL (list_store));
+	gtk_tree_view_set_model (GTK_TREE_VIEW (widget), sort_model);
 
 	selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (widget));
 	g_signal_connect (selection, "changed",
@@ -635,7 +725,7 @@ gpk_log_startup_cb (GtkApplication *application, gpointer user_data)
 	pk_treeview_add_general_columns (GTK_TREE_VIEW (widget));
 	gtk_tree_view_columns_autosize (GTK_TREE_VIEW (widget));
 
-	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (list_store),
+	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
 					      GPK_LOG_COLUMN_TIMESPEC, GTK_SORT_DESCENDING);
 
 	/* show */
@@ -650,13 +740,302 @@ gpk_log_startup_cb (GtkApplication *application, gpointer user_data)
 
 	/* get the update list */
 	gpk_log_refresh ();
+}
+
+typedef struct {
+	GMainLoop	*loop;
+	GDateTime	*since;
+	gboolean	 json;
+	GString		*buffer;
+	guint		 count;
+	gboolean	 ret;
+} GpkLogExport;
+
+static void
+gpk_log_export_json_string (GString *buffer, const gchar *text)
+{
+	const gchar *tmp;
+
+	if (text == NULL) {
+		g_string_append (buffer, "null");
+		return;
+	}
+	g_string_append_c (buffer, '"');
+	for (tmp = text; *tmp != '\0'; tmp++) {
+		switch (*tmp) {
+		case '"':
+			g_string_append (buffer, "\\\"");
+			break;
+		case '\\':
+			g_string_append (buffer, "\\\\");
+			break;
+		case '\n':
+			g_string_append (buffer, "\\n");
+			break;
+		case '\t':
+			g_string_append (buffer, "\\t");
+			break;
+		default:
+			if ((guchar) *tmp < 0x20)
+				g_string_append_printf (buffer, "\\u%04x", (guint) *tmp);
+			else
+				g_string_append_c (buffer, *tmp);
+			break;
+		}
+	}
+	g_string_append_c (buffer, '"');
+}
+
+static void
+gpk_log_export_csv_string (GString *buffer, const gchar *text)
+{
+	const gchar *tmp;
+
+	g_string_append_c (buffer, '"');
+	for (tmp = text != NULL ? text : ""; *tmp != '\0'; tmp++) {
+		if (*tmp == '"')
+			g_string_append_c (buffer, '"');
+		g_string_append_c (buffer, *tmp);
+	}
+	g_string_append_c (buffer, '"');
+}
+
+static void
+gpk_log_export_json (GpkLogExport *helper, GpkLogRecord *record)
+{
+	GString *buffer = helper->buffer;
+	guint i;
+
+	g_string_append (buffer, helper->count > 0 ? ",\n  {" : "\n  {");
+	g_string_append (buffer, "\"tid\": ");
+	gpk_log_export_json_string (buffer, record->tid);
+	g_string_append (buffer, ", \"timespec\": ");
+	gpk_log_export_json_string (buffer, record->timespec);
+	g_string_append (buffer, ", \"role\": ");
+	gpk_log_export_json_string (buffer, pk_role_enum_to_string (record->role));
+	g_string_append_printf (buffer, ", \"duration\": %u, \"uid\": %u, \"user\": ",
+				record->duration, record->uid);
+	gpk_log_export_json_string (buffer, gpk_log_record_get_user_name (record));
+	g_string_append (buffer, ", \"cmdline\": ");
+	gpk_log_export_json_string (buffer, record->cmdline);
+	g_string_append (buffer, ", \"packages\": [");
+	for (i = 0; i < record->packages->len; i++) {
+		GpkLogRecordPackage *package;
+		package = &g_array_index (record->packages, GpkLogRecordPackage, i);
+		g_string_append (buffer, i > 0 ? ", {\"info\": " : "{\"info\": ");
+		gpk_log_export_json_string (buffer, pk_info_enum_to_string (package->info));
+		g_string_append (buffer, ", \"package_id\": ");
+		gpk_log_export_json_string (buffer, package->package_id);
+		g_string_append_c (buffer, '}');
+	}
+	g_string_append (buffer, "]}");
+}
+
+static void
+gpk_log_export_csv (GpkLogExport *helper, GpkLogRecord *record)
+{
+	GString *buffer = helper->buffer;
+	guint i;
+
+	gpk_log_export_csv_string (buffer, record->tid);
+	g_string_append_c (buffer, ',');
+	gpk_log_export_csv_string (buffer, record->timespec);
+	g_string_append_printf (buffer, ",%s,%u,%u,",
+				pk_role_enum_to_string (record->role),
+				record->duration, record->uid);
+	gpk_log_export_csv_string (buffer, gpk_log_record_get_user_name (record));
+	g_string_append_c (buffer, ',');
+	gpk_log_export_csv_string (buffer, record->cmdline);
+
+	/* packages are space separated as "info:package_id" */
+	g_string_append (buffer, ",\"");
+	for (i = 0; i < record->packages->len; i++) {
+		GpkLogRecordPackage *package;
+		package = &g_array_index (record->packages, GpkLogRecordPackage, i);
+		if (i > 0)
+			g_string_append_c (buffer, ' ');
+		g_string_append_printf (buffer, "%s:%s",
+					pk_info_enum_to_string (package->info),
+					package->package_id);
+	}
+	g_string_append (buffer, "\"\n");
+}
+
+static void
+gpk_log_export_record (GpkLogExport *helper, GpkLogRecord *record)
+{
+	/* use exactly the same rules as the treeview */
+	if (!gpk_log_record_match (record, filter))
+		return;
+	if (helper->since != NULL) {
+		g_autoptr(GDateTime) date_time = NULL;
+		date_time = g_date_time_new_from_iso8601 (record->timespec, NULL);
+		if (date_time == NULL || g_date_time_compare (date_time, helper->since) < 0)
+			return;
+	}
+
+	/* write each record as it arrives */
+	if (helper->json)
+		gpk_log_export_json (helper, record);
+	else
+		gpk_log_export_csv (helper, record);
+	fwrite (helper->buffer->str, 1, helper->buffer->len, stdout);
+	g_string_truncate (helper->buffer, 0);
+	helper->count++;
+}
+
+static void
+gpk_log_export_signal_cb (GDBusConnection *connection,
+			  const gchar *sender_name,
+			  const gchar *object_path,
+			  const gchar *interface_name,
+			  const gchar *signal_name,
+			  GVariant *parameters,
+			  gpointer user_data)
+{
+	GpkLogExport *helper = (GpkLogExport *) user_data;
+
+	if (g_strcmp0 (signal_name, "Transaction") == 0) {
+		g_autoptr(GpkLogRecord) record = NULL;
+		const gchar *tid;
+		const gchar *timespec;
+		const gchar *data;
+		const gchar *cmdline;
+		gboolean succeeded;
+		guint role;
+		guint duration;
+		guint uid;
+
+		g_variant_get (parameters, "(&o&sbuu&su&s)",
+			       &tid, &timespec, &succeeded, &role,
+			       &duration, &data, &uid, &cmdline);
+		record = gpk_log_record_new (tid, timespec, succeeded, role,
+					     duration, data, uid, cmdline);
+		gpk_log_export_record (helper, record);
+		return;
+	}
+	if (g_strcmp0 (signal_name, "ErrorCode") == 0) {
+		const gchar *details;
+		guint code;
+		g_variant_get (parameters, "(u&s)", &code, &details);
+		g_printerr ("failed to get old transactions: %s, %s\n",
+			    pk_error_enum_to_string (code), details);
+		helper->ret = FALSE;
+		return;
+	}
+	if (g_strcmp0 (signal_name, "Finished") == 0 ||
+	    g_strcmp0 (signal_name, "Destroy") == 0) {
+		g_main_loop_quit (helper->loop);
+		return;
+	}
+}
+
+static GDateTime *
+gpk_log_export_parse_date (const gchar *text)
+{
+	g_autoptr(GTimeZone) tz = g_time_zone_new_local ();
+	g_autofree gchar *tmp = NULL;
+
+	/* allow just a date, which means midnight local time */
+	if (strchr (text, 'T') == NULL) {
+		tmp = g_strdup_printf ("%sT00:00:00", text);
+		return g_date_time_new_from_iso8601 (tmp, tz);
+	}
+	return g_date_time_new_from_iso8601 (text, tz);
+}
+
+static gboolean
+gpk_log_export (const gchar *format, const gchar *since)
+{
+	GpkLogExport helper = { NULL, NULL, FALSE, NULL, 0, TRUE };
+	g_autoptr(GDBusConnection) connection = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) value = NULL;
+	g_autoptr(GVariant) result = NULL;
+	const gchar *tid;
+	guint subscription_id;
+
+	if (g_strcmp0 (format, "json") == 0) {
+		helper.json = TRUE;
+	} else if (g_strcmp0 (format, "csv") != 0) {
+		g_printerr ("export format %s not supported, expected json or csv\n", format);
+		return FALSE;
+	}
+	if (since != NULL) {
+		helper.since = gpk_log_export_parse_date (since);
+		if (helper.since == NULL) {
+			g_printerr ("failed to parse date %s\n", since);
+			return FALSE;
+		}
+	}
+
+	/* we talk to the daemon directly so that each transaction can be
+	 * written out as it arrives rather than when all have been received */
+	connection = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
+	if (connection == NULL) {
+		g_printerr ("failed to connect to the system bus: %s\n", error->message);
+		goto out;
+	}
+	value = g_dbus_connection_call_sync (connection,
+					     PK_DBUS_SERVICE,
+					     PK_DBUS_PATH,
+					     PK_DBUS_INTERFACE,
+					     "CreateTransaction",
+					     NULL,
+					     G_VARIANT_TYPE ("(o)"),
+					     G_DBUS_CALL_FLAGS_NONE,
+					     -1, NULL, &error);
+	if (value == NULL) {
+		g_printerr ("failed to create transaction: %s\n", error->message);
+		goto out;
+	}
+	g_variant_get (value, "(&o)", &tid);
+	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.buffer = g_string_sized_new (4096);
+	subscription_id = g_dbus_connection_signal_subscribe (connection,
+							      PK_DBUS_SERVICE,
+							      PK_DBUS_INTERFACE_TRANSACTION,
+							      NULL,
+							      tid,
+							      NULL,
+							      G_DBUS_SIGNAL_FLAGS_NONE,
+							      gpk_log_export_signal_cb,
+							      &helper, NULL);
+
+	/* zero means the whole history */
+	result = g_dbus_connection_call_sync (connection,
+					      PK_DBUS_SERVICE,
+					      tid,
+					      PK_DBUS_INTERFACE_TRANSACTION,
+					      "GetOldTransactions",
+					      g_variant_new ("(u)", 0),
+					      NULL,
+					      G_DBUS_CALL_FLAGS_NONE,
+					      -1, NULL, &error);
+	if (result == NULL) {
+		g_printerr ("failed to get old transactions: %s\n", error->message);
+		g_dbus_connection_signal_unsubscribe (connection, subscription_id);
+		helper.ret = FALSE;
+		goto out;
+	}
+
+	if (helper.json)
+		fputs ("[", stdout);
+	else
+		fputs ("tid,timespec,role,duration,uid,user,cmdline,packages\n", stdout);
+	g_main_loop_run (helper.loop);
+	if (helper.json)
+		fputs (helper.count > 0 ? "\n]\n" : "]\n", stdout);
+	g_dbus_connection_signal_unsubscribe (connection, subscription_id);
+	g_debug ("exported %u transactions", helper.count);
 out:
-	g_object_unref (list_store);
-	g_object_unref (client);
-	g_free (transaction_id);
-	g_free (filter);
-	if (transactions != NULL)
-		g_ptr_array_unref (transactions);
+	if (helper.loop != NULL)
+		g_main_loop_unref (helper.loop);
+	if (helper.buffer != NULL)
+		g_string_free (helper.buffer, TRUE);
+	if (helper.since != NULL)
+		g_date_time_unref (helper.since);
+	return connection != NULL && value != NULL && helper.ret;
 }
 
 int
@@ -665,7 +1044,10 @@ main (int argc, char *argv[])
 	gboolean ret;
 	gint status = 1;
 	GOptionContext *context;
+	g_autoptr(GError) error = NULL;
 	g_autoptr(GtkApplication) application = NULL;
+	g_autofree gchar *export_format = NULL;
+	g_autofree gchar *since = NULL;
 
 	const GOptionEntry options[] = {
 		{ "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
@@ -674,6 +1056,12 @@ main (int argc, char *argv[])
 		{ "parent-window", 'p', 0, G_OPTION_ARG_INT, &xid,
 		  /* TRANSLATORS: we can make this modal (stay on top of) another window */
 		  _("Set the parent window to make this modal"), NULL },
+		{ "export", '\0', 0, G_OPTION_ARG_STRING, &export_format,
+		  /* TRANSLATORS: write the log to the terminal rather than showing a window */
+		  N_("Export the log to standard output as “json” or “csv”"), NULL },
+		{ "since", '\0', 0, G_OPTION_ARG_STRING, &since,
+		  /* TRANSLATORS: only export transactions newer than this, e.g. 2020-01-31 */
+		  N_("Only export transactions since this date"), NULL },
 		{ NULL}
 	};
 
@@ -683,15 +1071,44 @@ main (int argc, char *argv[])
 	bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
 	textdomain (GETTEXT_PACKAGE);
 
-	gtk_init (&argc, &argv);
+	/* exporting is done from scripts, and so should not need a display,
+	 * so find out if we are before GTK gets to see the arguments */
+	context = g_option_context_new (NULL);
+	g_option_context_add_main_entries (context, options, NULL);
+	g_option_context_set_ignore_unknown_options (context, TRUE);
+	g_option_context_set_help_enabled (context, FALSE);
+	ret = g_option_context_parse (context, &argc, &argv, &error);
+	g_option_context_free (context);
+	if (!ret) {
+		g_printerr ("%s\n", error->message);
+		goto out;
+	}
+	if (export_format == NULL)
+		gtk_init (&argc, &argv);
 
+	/* everything else, which now has to be known */
 	context = g_option_context_new (NULL);
 	g_option_context_set_summary (context, _("Software Log Viewer"));
 	g_option_context_add_main_entries (context, options, NULL);
 	g_option_context_add_group (context, gpk_debug_get_option_group ());
-	g_option_context_add_group (context, gtk_get_option_group (TRUE));
-	g_option_context_parse (context, &argc, &argv, NULL);
+	if (export_format == NULL)
+		g_option_context_add_group (context, gtk_get_option_group (TRUE));
+	ret = g_option_context_parse (context, &argc, &argv, &error);
 	g_option_context_free (context);
+	if (!ret) {
+		g_printerr ("%s\n", error->message);
+		goto out;
+	}
+
+	/* an empty filter matches everything */
+	if (filter != NULL && filter[0] == '\0')
+		g_clear_pointer (&filter, g_free);
+
+	/* just write the history to stdout */
+	if (export_format != NULL) {
+		status = gpk_log_export (export_format, since) ? 0 : 1;
+		goto out;
+	}
 
 	/* are we running privileged */
 	ret = gpk_check_privileged_user (_("Log viewer"), TRUE);
@@ -704,6 +1121,7 @@ main (int argc, char *argv[])
 
 	/* are we already activated? */
 	application = gtk_application_new ("org.freedesktop.PackageKit.LogViewer", 0);
+	gpk_debug_add_dump_action (G_ACTION_MAP (application));
 	g_signal_connect (application, "startup",
 			  G_CALLBACK (gpk_log_startup_cb), NULL);
 	g_signal_connect (application, "activate",
@@ -714,5 +1132,26 @@ main (int argc, char *argv[])
 out:
 	if (builder != NULL)
 		g_object_unref (builder);
+	if (filter_model != NULL)
+		g_object_unref (filter_model);
+	if (list_store != NULL)
+		g_object_unref (list_store);
+	if (client != NULL)
+		g_object_unref (client);
+	if (transactions != NULL)
+		g_ptr_array_unref (transactions);
+	if (transaction_ids != NULL)
+		g_hash_table_unref (transaction_ids);
+	if (cancellable != NULL)
+		g_object_unref (cancellable);
+	if (settings != NULL)
+		g_object_unref (settings);
+	g_queue_foreach (&pending_rows, (GFunc) gpk_log_row_free, NULL);
+	g_queue_clear (&pending_rows);
+	g_free (filter_bitmap.data);
+	g_free (scan_bitmap.data);
+	g_free (scan_filter);
+	g_free (transaction_id);
+	g_free (filter);
 	return status;
 }
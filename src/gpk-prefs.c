@@ -32,16 +32,26 @@
 #include "gpk-error.h"
 
 typedef struct {
-	const gchar		*id_tmp;
+	gchar			*repo_id;
+	gboolean		 enabled;
+	GpkTraceRequest		*trace;
+} GpkPrefsRepoChange;
+
+typedef struct {
 	GCancellable		*cancellable;
+	GHashTable		*repos;
+	GQueue			*repo_changes;
+	GpkPrefsRepoChange	*repo_change;
+	GString			*repo_change_errors;
 	GSettings		*settings_gpk;
 	GtkApplication		*application;
 	GtkBuilder		*builder;
 	GtkListStore		*list_store;
-	GtkTreePath		*path_tmp;
+	gboolean		 repo_list_pending;	/* the refresh after a batch */
 	guint			 status_id;
 	PkBitfield		 roles;
 	PkClient		*client;
+	PkControl		*control;
 	PkStatusEnum		 status;
 } GpkPrefsPrivate;
 
@@ -49,82 +59,10 @@ enum {
 	GPK_COLUMN_ENABLED,
 	GPK_COLUMN_TEXT,
 	GPK_COLUMN_ID,
-	GPK_COLUMN_ACTIVE,
 	GPK_COLUMN_SENSITIVE,
 	GPK_COLUMN_LAST
 };
 
-static gboolean
-gpk_prefs_find_iter_model_cb (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, GpkPrefsPrivate *priv)
-{
-	gchar *repo_id_tmp = NULL;
-	gtk_tree_model_get (model, iter,
-			    GPK_COLUMN_ID, &repo_id_tmp,
-			    -1);
-	if (strcmp (repo_id_tmp, priv->id_tmp) == 0) {
-		priv->path_tmp = gtk_tree_path_copy (path);
-		return TRUE;
-	}
-	return FALSE;
-}
-
-static gboolean
-gpk_prefs_mark_nonactive_cb (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, GpkPrefsPrivate *priv)
-{
-	gtk_list_store_set (GTK_LIST_STORE(model), iter,
-			    GPK_COLUMN_ACTIVE, FALSE,
-			    -1);
-	return FALSE;
-}
-
-static void
-gpk_prefs_mark_nonactive (GpkPrefsPrivate *priv, GtkTreeModel *model)
-{
-	gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) gpk_prefs_mark_nonactive_cb, priv);
-}
-
-static gboolean
-gpk_prefs_model_get_iter (GpkPrefsPrivate *priv, GtkTreeModel *model, GtkTreeIter *iter, const gchar *id)
-{
-	gboolean ret = TRUE;
-	priv->id_tmp = id;
-	priv->path_tmp = NULL;
-	gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) gpk_prefs_find_iter_model_cb, priv);
-	if (priv->path_tmp == NULL) {
-		gtk_list_store_append (GTK_LIST_STORE(model), iter);
-	} else {
-		ret = gtk_tree_model_get_iter (model, iter, priv->path_tmp);
-		gtk_tree_path_free (priv->path_tmp);
-	}
-	return ret;
-}
-
-static gboolean
-gpk_prefs_remove_nonactive_cb (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, gboolean *ret)
-{
-	gboolean active;
-	gtk_tree_model_get (model, iter,
-			    GPK_COLUMN_ACTIVE, &active,
-			    -1);
-	if (!active) {
-		*ret = TRUE;
-		gtk_list_store_remove (GTK_LIST_STORE(model), iter);
-		return TRUE;
-	}
-	return FALSE;
-}
-
-static void
-gpk_prefs_remove_nonactive (GtkTreeModel *model)
-{
-	gboolean ret;
-	/* do this again and again as removing in gtk_tree_model_foreach causes errors */
-	do {
-		ret = FALSE;
-		gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) gpk_prefs_remove_nonactive_cb, &ret);
-	} while (ret);
-}
-
 static gboolean
 gpk_prefs_status_changed_timeout_cb (GpkPrefsPrivate *priv)
 {
@@ -142,10 +80,12 @@ gpk_prefs_status_changed_timeout_cb (GpkPrefsPrivate *priv)
 }
 
 static void
-gpk_prefs_progress_cb (PkProgress *progress, PkProgressType type, GpkPrefsPrivate *priv)
+gpk_prefs_progress_cb (PkProgress *progress, PkProgressType type, GpkTraceRequest *request)
 {
+	GpkPrefsPrivate *priv = (GpkPrefsPrivate *) request->user_data;
 	GtkWidget *widget;
 
+	gpk_trace_progress (request->token, type);
 	if (type != PK_PROGRESS_TYPE_STATUS)
 		return;
 
@@ -177,31 +117,127 @@ gpk_prefs_progress_cb (PkProgress *progress, PkProgressType type, GpkPrefsPrivat
 	g_source_set_name_by_id (priv->status_id, "[GpkRepo] status");
 }
 
+static void
+gpk_prefs_repo_change_free (GpkPrefsRepoChange *change)
+{
+	g_free (change->repo_id);
+	if (change->trace != NULL)
+		gpk_trace_request_free (change->trace);
+	g_free (change);
+}
+
+static gboolean
+gpk_prefs_repo_change_pending (GpkPrefsPrivate *priv, const gchar *repo_id)
+{
+	GList *l;
+
+	if (priv->repo_change != NULL &&
+	    g_strcmp0 (priv->repo_change->repo_id, repo_id) == 0)
+		return TRUE;
+	for (l = priv->repo_changes->head; l != NULL; l = l->next) {
+		GpkPrefsRepoChange *change = l->data;
+		if (g_strcmp0 (change->repo_id, repo_id) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void gpk_prefs_repo_list_refresh (GpkPrefsPrivate *priv);
+static void gpk_prefs_repo_change_next (GpkPrefsPrivate *priv);
+
+static void
+gpk_prefs_repo_change_failed (GpkPrefsPrivate *priv, const gchar *message)
+{
+	GpkPrefsRepoChange *change = priv->repo_change;
+	GtkTreeIter *iter;
+
+	g_warning ("failed to set repo %s: %s", change->repo_id, message);
+	g_string_append_printf (priv->repo_change_errors, "%s: %s\n",
+				change->repo_id, message);
+
+	/* roll back just this repo */
+	iter = g_hash_table_lookup (priv->repos, change->repo_id);
+	if (iter != NULL) {
+		gtk_list_store_set (priv->list_store, iter,
+				    GPK_COLUMN_ENABLED, !change->enabled,
+				    -1);
+	}
+}
+
 static void
 gpk_prefs_repo_enable_cb (GObject *object, GAsyncResult *res, GpkPrefsPrivate *priv)
 {
 	g_autoptr(GError) error = NULL;
-	GtkWindow *window;
 	PkClient *client = PK_CLIENT (object);
 	g_autoptr(PkError) error_code = NULL;
-	PkResults *results = NULL;
+	g_autoptr(PkResults) results = NULL;
+	GtkTreeIter *iter;
 
 	/* get the results */
 	results = pk_client_generic_finish (client, res, &error);
 	if (results == NULL) {
-		g_warning ("failed to get set repo: %s", error->message);
-		return;
+		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			return;
+		gpk_prefs_repo_change_failed (priv, error->message);
+		goto out;
 	}
+	gpk_trace_end (priv->repo_change->trace->token, NULL);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
 	if (error_code != NULL) {
-		g_warning ("failed to set repo: %s, %s", pk_error_enum_to_string (pk_error_get_code (error_code)), pk_error_get_details (error_code));
+		gpk_prefs_repo_change_failed (priv, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)));
+		goto out;
+	}
+out:
+	/* the user can change this one again */
+	iter = g_hash_table_lookup (priv->repos, priv->repo_change->repo_id);
+	if (iter != NULL) {
+		gtk_list_store_set (priv->list_store, iter,
+				    GPK_COLUMN_SENSITIVE, TRUE,
+				    -1);
+	}
+	g_clear_pointer (&priv->repo_change, gpk_prefs_repo_change_free);
+	gpk_prefs_repo_change_next (priv);
+}
+
+static void
+gpk_prefs_repo_change_next (GpkPrefsPrivate *priv)
+{
+	GtkWindow *window;
+
+	/* already running */
+	if (priv->repo_change != NULL)
+		return;
+
+	/* send the next one straight away */
+	priv->repo_change = g_queue_pop_head (priv->repo_changes);
+	if (priv->repo_change != NULL) {
+		g_debug ("setting %s to %i", priv->repo_change->repo_id, priv->repo_change->enabled);
+		priv->repo_change->trace = gpk_trace_request_new (PK_ROLE_ENUM_REPO_ENABLE, priv);
+		pk_client_repo_enable_async (priv->client,
+					     priv->repo_change->repo_id,
+					     priv->repo_change->enabled,
+					     priv->cancellable,
+					     (PkProgressCallback) gpk_prefs_progress_cb, priv->repo_change->trace,
+					     (GAsyncReadyCallback) gpk_prefs_repo_enable_cb, priv);
+		return;
+	}
+
+	/* the batch is done, so get the real state just once */
+	priv->repo_list_pending = TRUE;
+	gpk_prefs_repo_list_refresh (priv);
+
+	/* show all the failures together */
+	if (priv->repo_change_errors->len > 0) {
+		g_string_truncate (priv->repo_change_errors, priv->repo_change_errors->len - 1);
 		window = GTK_WINDOW (gtk_builder_get_object (priv->builder, "dialog_prefs"));
 		/* TRANSLATORS: for one reason or another, we could not enable or disable a package source */
 		gpk_error_dialog_modal (window, _("Failed to change status"),
-					gpk_error_enum_to_localised_text (pk_error_get_code (error_code)), pk_error_get_details (error_code));
-		return;
+					/* TRANSLATORS: the details say which sources failed and why */
+					_("Some package sources could not be enabled or disabled."),
+					priv->repo_change_errors->str);
+		g_string_truncate (priv->repo_change_errors, 0);
 	}
 }
 
@@ -210,6 +246,7 @@ gpk_misc_enabled_toggled (GtkCellRendererToggle *cell, gchar *path_str, GpkPrefs
 {
 	gboolean enabled;
 	g_autofree gchar *repo_id = NULL;
+	GpkPrefsRepoChange *change;
 	GtkTreeIter iter;
 	GtkTreeModel *model;
 	GtkTreePath *path = gtk_tree_path_new_from_string (path_str);
@@ -218,6 +255,7 @@ gpk_misc_enabled_toggled (GtkCellRendererToggle *cell, gchar *path_str, GpkPrefs
 	/* do we have the capability? */
 	if (pk_bitfield_contain (priv->roles, PK_ROLE_ENUM_REPO_ENABLE) == FALSE) {
 		g_debug ("can't change state");
+		gtk_tree_path_free (path);
 		return;
 	}
 
@@ -233,18 +271,19 @@ gpk_misc_enabled_toggled (GtkCellRendererToggle *cell, gchar *path_str, GpkPrefs
 	/* do something with the value */
 	enabled ^= 1;
 
-	/* set new value */
+	/* show the new value now, and roll back if it fails; the row
+	 * stays insensitive until its change has been done */
 	gtk_list_store_set (GTK_LIST_STORE (model), &iter,
+			    GPK_COLUMN_ENABLED, enabled,
 			    GPK_COLUMN_SENSITIVE, FALSE,
 			    -1);
 
-	/* set the repo */
-	g_debug ("setting %s to %i", repo_id, enabled);
-	pk_client_repo_enable_async (priv->client, repo_id, enabled,
-				     priv->cancellable,
-				     (PkProgressCallback) gpk_prefs_progress_cb, priv,
-				     (GAsyncReadyCallback) gpk_prefs_repo_enable_cb, priv);
-
+	/* add to the batch */
+	change = g_new0 (GpkPrefsRepoChange, 1);
+	change->repo_id = g_steal_pointer (&repo_id);
+	change->enabled = enabled;
+	g_queue_push_tail (priv->repo_changes, change);
+	gpk_prefs_repo_change_next (priv);
 }
 
 static void
@@ -292,20 +331,34 @@ gpk_repos_treeview_clicked_cb (GtkTreeSelection *selection, GpkPrefsPrivate *pri
 }
 
 static void
-gpk_prefs_get_repo_list_cb (GObject *object, GAsyncResult *res, GpkPrefsPrivate *priv)
+gpk_prefs_get_repo_list_cb (GObject *object, GAsyncResult *res, gpointer user_data)
 {
+	g_autoptr(GpkTraceRequest) request = (GpkTraceRequest *) user_data;
+	GpkPrefsPrivate *priv = (GpkPrefsPrivate *) request->user_data;
 	gboolean enabled;
+	gboolean enabled_old;
+	gboolean sensitive_old;
+	const gchar *description;
+	const gchar *repo_id;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) present = NULL;
 	g_autoptr(GPtrArray) array = NULL;
+	GHashTableIter hash_iter;
 	GtkTreeIter iter;
-	GtkTreeModel *model;
-	GtkTreeView *treeview;
+	GtkTreeIter *iter_tmp;
+	GtkTreeModel *model = GTK_TREE_MODEL (priv->list_store);
 	GtkWindow *window;
+	gpointer key;
+	gpointer value;
 	guint i;
+	guint changed = 0;
 	PkClient *client = PK_CLIENT (object);
 	g_autoptr(PkError) error_code = NULL;
 	PkRepoDetail *item;
-	PkResults *results = NULL;
+	g_autoptr(PkResults) results = NULL;
+
+	/* any repo-list-changed from now on is not for the batch */
+	priv->repo_list_pending = FALSE;
 
 	/* get the results */
 	results = pk_client_generic_finish (client, res, &error);
@@ -313,6 +366,7 @@ gpk_prefs_get_repo_list_cb (GObject *object, GAsyncResult *res, GpkPrefsPrivate
 		g_warning ("failed to get repo list: %s", error->message);
 		return;
 	}
+	gpk_trace_mark (request->token, GPK_TRACE_MARK_FINISHED);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -325,51 +379,82 @@ gpk_prefs_get_repo_list_cb (GObject *object, GAsyncResult *res, GpkPrefsPrivate
 		return;
 	}
 
-	/* add repos */
-	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_repo"));
-	model = gtk_tree_view_get_model (treeview);
+	/* don't resort after every change, just once at the end */
+	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (priv->list_store),
+					      GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID,
+					      GTK_SORT_ASCENDING);
+
+	/* add new repos and update the ones that have changed */
+	present = g_hash_table_new (g_str_hash, g_str_equal);
 	array = pk_results_get_repo_detail_array (results);
 	for (i = 0; i < array->len; i++) {
-		g_autofree gchar *description = NULL;
-		g_autofree gchar *repo_id = NULL;
+		g_autofree gchar *description_old = NULL;
 		item = g_ptr_array_index (array, i);
-		g_object_get (item,
-			      "repo-id", &repo_id,
-			      "description", &description,
-			      "enabled", &enabled,
-			      NULL);
+		repo_id = pk_repo_detail_get_id (item);
+		description = pk_repo_detail_get_description (item);
+		enabled = pk_repo_detail_get_enabled (item);
 		g_debug ("repo = %s:%s:%i", repo_id, description, enabled);
-		gpk_prefs_model_get_iter (priv, model, &iter, repo_id);
-		gtk_list_store_set (priv->list_store, &iter,
+		g_hash_table_add (present, (gpointer) repo_id);
+
+		iter_tmp = g_hash_table_lookup (priv->repos, repo_id);
+		if (iter_tmp == NULL) {
+			gtk_list_store_insert_with_values (priv->list_store, &iter, -1,
+							   GPK_COLUMN_ENABLED, enabled,
+							   GPK_COLUMN_TEXT, description,
+							   GPK_COLUMN_ID, repo_id,
+							   GPK_COLUMN_SENSITIVE, TRUE,
+							   -1);
+			g_hash_table_insert (priv->repos, g_strdup (repo_id),
+					     gtk_tree_iter_copy (&iter));
+			changed++;
+			continue;
+		}
+
+		/* keep showing what the user asked for until it is done */
+		if (gpk_prefs_repo_change_pending (priv, repo_id))
+			continue;
+		gtk_tree_model_get (model, iter_tmp,
+				    GPK_COLUMN_ENABLED, &enabled_old,
+				    GPK_COLUMN_TEXT, &description_old,
+				    GPK_COLUMN_SENSITIVE, &sensitive_old,
+				    -1);
+		if (enabled == enabled_old &&
+		    sensitive_old &&
+		    g_strcmp0 (description, description_old) == 0)
+			continue;
+		gtk_list_store_set (priv->list_store, iter_tmp,
 				    GPK_COLUMN_ENABLED, enabled,
 				    GPK_COLUMN_TEXT, description,
-				    GPK_COLUMN_ID, repo_id,
-				    GPK_COLUMN_ACTIVE, TRUE,
 				    GPK_COLUMN_SENSITIVE, TRUE,
 				    -1);
+		changed++;
 	}
 
 	/* remove the items that are not now present */
-	gpk_prefs_remove_nonactive (model);
+	g_hash_table_iter_init (&hash_iter, priv->repos);
+	while (g_hash_table_iter_next (&hash_iter, &key, &value)) {
+		if (g_hash_table_contains (present, key))
+			continue;
+		gtk_list_store_remove (priv->list_store, (GtkTreeIter *) value);
+		g_hash_table_iter_remove (&hash_iter);
+		changed++;
+	}
+	g_debug ("%u of %u repos changed", changed, g_hash_table_size (priv->repos));
 
 	/* sort */
 	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE(priv->list_store), GPK_COLUMN_TEXT, GTK_SORT_ASCENDING);
+	gpk_trace_end (request->token,
+		       GTK_WIDGET (gtk_builder_get_object (priv->builder, "treeview_repo")));
 }
 
 static void
 gpk_prefs_repo_list_refresh (GpkPrefsPrivate *priv)
 {
 	gboolean show_details;
-	GtkTreeModel *model;
-	GtkTreeView *treeview;
 	GtkWidget *widget;
+	GpkTraceRequest *request;
 	PkBitfield filters;
 
-	/* mark the items as not used */
-	treeview = GTK_TREE_VIEW (gtk_builder_get_object (priv->builder, "treeview_repo"));
-	model = gtk_tree_view_get_model (treeview);
-	gpk_prefs_mark_nonactive (priv, model);
-
 	g_debug ("refreshing list");
 	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "checkbutton_detail"));
 	show_details = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (widget));
@@ -377,15 +462,21 @@ gpk_prefs_repo_list_refresh (GpkPrefsPrivate *priv)
 		filters = pk_bitfield_value (PK_FILTER_ENUM_NOT_DEVELOPMENT);
 	else
 		filters = pk_bitfield_value (PK_FILTER_ENUM_NONE);
+	request = gpk_trace_request_new (PK_ROLE_ENUM_GET_REPO_LIST, priv);
 	pk_client_get_repo_list_async (priv->client, filters,
 				       priv->cancellable,
-				       (PkProgressCallback) gpk_prefs_progress_cb, priv,
-				       (GAsyncReadyCallback) gpk_prefs_get_repo_list_cb, priv);
+				       (PkProgressCallback) gpk_prefs_progress_cb, request,
+				       gpk_prefs_get_repo_list_cb, request);
 }
 
 static void
 gpk_prefs_repo_list_changed_cb (PkControl *control, GpkPrefsPrivate *priv)
 {
+	/* we refresh once when the batch of changes is done */
+	if (priv->repo_change != NULL || priv->repo_list_pending) {
+		g_debug ("ignoring repo-list-changed during batch");
+		return;
+	}
 	gpk_prefs_repo_list_refresh (priv);
 }
 
@@ -428,7 +519,6 @@ gpk_prefs_get_properties_cb (GObject *object, GAsyncResult *res, GpkPrefsPrivate
 		gtk_list_store_set (priv->list_store, &iter,
 				    GPK_COLUMN_ENABLED, FALSE,
 				    GPK_COLUMN_TEXT, _("Getting package source list not supported by backend"),
-				    GPK_COLUMN_ACTIVE, FALSE,
 				    GPK_COLUMN_SENSITIVE, FALSE,
 				    -1);
 
@@ -447,15 +537,13 @@ gpk_pack_startup_cb (GtkApplication *application, GpkPrefsPrivate *priv)
 	GtkWidget *main_window;
 	GtkWidget *widget;
 	guint retval;
-	g_autoptr(PkControl) control = NULL;
 
 	/* add application specific icons to search path */
 	gtk_icon_theme_append_search_path (gtk_icon_theme_get_default (),
 					   PKGDATADIR G_DIR_SEPARATOR_S "icons");
 
 	/* get actions */
-	control = pk_control_new ();
-	g_signal_connect (control, "repo-list-changed",
+	g_signal_connect (priv->control, "repo-list-changed",
 			  G_CALLBACK (gpk_prefs_repo_list_changed_cb), priv);
 
 	/* get UI */
@@ -494,7 +582,7 @@ gpk_pack_startup_cb (GtkApplication *application, GpkPrefsPrivate *priv)
 	gtk_widget_show (main_window);
 
 	/* get some data */
-	pk_control_get_properties_async (control, NULL, (GAsyncReadyCallback) gpk_prefs_get_properties_cb, priv);
+	pk_control_get_properties_async (priv->control, NULL, (GAsyncReadyCallback) gpk_prefs_get_properties_cb, priv);
 }
 
 
@@ -559,7 +647,12 @@ main (int argc, char *argv[])
 	priv->settings_gpk = g_settings_new (GPK_SETTINGS_SCHEMA);
 	priv->list_store = gtk_list_store_new (GPK_COLUMN_LAST, G_TYPE_BOOLEAN,
 					       G_TYPE_STRING, G_TYPE_STRING,
-					       G_TYPE_BOOLEAN, G_TYPE_BOOLEAN);
+					       G_TYPE_BOOLEAN);
+	priv->repos = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					     (GDestroyNotify) gtk_tree_iter_free);
+	priv->repo_changes = g_queue_new ();
+	priv->repo_change_errors = g_string_new (NULL);
+	priv->control = pk_control_new ();
 	priv->client = pk_client_new ();
 	g_object_set (priv->client,
 		      "background", FALSE,
@@ -568,6 +661,7 @@ main (int argc, char *argv[])
 	/* are we already activated? */
 	priv->application = gtk_application_new ("org.freedesktop.PackageKit.Prefs",
 						 G_APPLICATION_HANDLES_COMMAND_LINE);
+	gpk_debug_add_dump_action (G_ACTION_MAP (priv->application));
 	g_signal_connect (priv->application, "startup",
 			  G_CALLBACK (gpk_pack_startup_cb), priv);
 	g_signal_connect (priv->application, "command-line",
@@ -582,7 +676,13 @@ main (int argc, char *argv[])
 		g_object_unref (priv->builder);
 		g_object_unref (priv->settings_gpk);
 		g_object_unref (priv->list_store);
+		g_hash_table_unref (priv->repos);
+		g_queue_free_full (priv->repo_changes, (GDestroyNotify) gpk_prefs_repo_change_free);
+		if (priv->repo_change != NULL)
+			gpk_prefs_repo_change_free (priv->repo_change);
+		g_string_free (priv->repo_change_errors, TRUE);
 		g_object_unref (priv->client);
+		g_object_unref (priv->control);
 		g_free (priv);
 	}
 	return status;
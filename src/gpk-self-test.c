@@ -24,7 +24,10 @@
 
 #include "gpk-common.h"
 #include "gpk-enum.h"
+#include "gpk-enum-icons.h"
+#include "gpk-enum-private.h"
 #include "gpk-error.h"
+#include "gpk-file-list.h"
 #include "gpk-task.h"
 
 static void
@@ -32,6 +35,8 @@ gpk_test_enum_func (void)
 {
 	guint i;
 	const gchar *string;
+	gint generation;
+	guint rebuilds;
 
 	/* check we convert all the localized past role enums */
 	for (i = 0; i < PK_ROLE_ENUM_LAST; i++) {
@@ -141,6 +146,41 @@ gpk_test_enum_func (void)
 		}
 	}
 
+	/* the localised tables are rebuilt after a locale change */
+	string = gpk_status_enum_to_localised_text (PK_STATUS_ENUM_DOWNLOAD);
+	generation = gpk_enum_localised_get_generation ();
+	rebuilds = gpk_enum_localised_get_rebuilds ();
+	g_assert_true (string == gpk_status_enum_to_localised_text (PK_STATUS_ENUM_DOWNLOAD));
+	g_assert_cmpuint (gpk_enum_localised_get_rebuilds (), ==, rebuilds);
+	gpk_enum_localised_invalidate ();
+	g_assert_cmpint (gpk_enum_localised_get_generation (), !=, generation);
+	g_assert_cmpstr (gpk_status_enum_to_localised_text (PK_STATUS_ENUM_DOWNLOAD), ==, string);
+	g_assert_cmpuint (gpk_enum_localised_get_rebuilds (), ==, rebuilds + 1);
+	g_assert_cmpstr (gpk_status_enum_to_localised_text (PK_STATUS_ENUM_WAIT), !=, NULL);
+	g_assert_cmpuint (gpk_enum_localised_get_rebuilds (), ==, rebuilds + 1);
+}
+
+static void
+gpk_test_enum_icons_func (void)
+{
+	guint i;
+
+	/* the generated tables have an entry for every value */
+	for (i = 0; i < PK_INFO_ENUM_LAST; i++)
+		g_assert_nonnull (enum_info_icon_name[i]);
+	for (i = 0; i < PK_STATUS_ENUM_LAST; i++)
+		g_assert_nonnull (enum_status_icon_name[i]);
+	for (i = 0; i < PK_ROLE_ENUM_LAST; i++)
+		g_assert_nonnull (enum_role_icon_name[i]);
+	for (i = 0; i < PK_GROUP_ENUM_LAST; i++)
+		g_assert_nonnull (enum_group_icon_name[i]);
+	for (i = 0; i < PK_RESTART_ENUM_LAST; i++)
+		g_assert_nonnull (enum_restart_icon_name[i]);
+
+	/* out of range values use the fallback */
+	g_assert_cmpstr (gpk_info_enum_to_icon_name (PK_INFO_ENUM_LAST), ==, "help-browser");
+	g_assert_cmpstr (gpk_status_enum_to_icon_name (PK_STATUS_ENUM_LAST), ==, "help-browser");
+	g_assert_null (gpk_restart_enum_to_icon_name (PK_RESTART_ENUM_NONE));
 }
 
 static void
@@ -169,6 +209,147 @@ gpk_test_common_func (void)
 	g_free (text);
 }
 
+static gboolean
+gpk_test_category_tree_check_cb (GNode *node, gpointer user_data)
+{
+	guint *count = (guint *) user_data;
+	PkCategory *item = node->data;
+	PkCategory *parent;
+
+	if (G_NODE_IS_ROOT (node))
+		return FALSE;
+	(*count)++;
+
+	/* top level */
+	parent = node->parent->data;
+	if (parent == NULL) {
+		g_assert_cmpstr (pk_category_get_parent_id (item), ==, "");
+		return FALSE;
+	}
+	g_assert_cmpstr (pk_category_get_parent_id (item), ==, pk_category_get_id (parent));
+	return FALSE;
+}
+
+static void
+gpk_test_category_tree_func (void)
+{
+	GNode *tree;
+	GNode *node;
+	guint count = 0;
+	guint i;
+	g_autoptr(GPtrArray) array = NULL;
+
+	/* each category has four children, added children first */
+	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 5000; i > 0; i--) {
+		PkCategory *item = pk_category_new ();
+		g_autofree gchar *cat_id = g_strdup_printf ("cat-%u", i - 1);
+		g_autofree gchar *parent_id = NULL;
+
+		if (i > 1)
+			parent_id = g_strdup_printf ("cat-%u", (i - 2) / 4);
+		pk_category_set_id (item, cat_id);
+		pk_category_set_parent_id (item, parent_id != NULL ? parent_id : "");
+		pk_category_set_name (item, cat_id);
+		g_ptr_array_add (array, item);
+	}
+	tree = gpk_category_array_to_tree (array);
+
+	/* everything is in the tree with the right parent */
+	g_node_traverse (tree, G_PRE_ORDER, G_TRAVERSE_ALL, -1,
+			 gpk_test_category_tree_check_cb, &count);
+	g_assert_cmpint (count, ==, 5000);
+	g_assert_cmpint (g_node_n_children (tree), ==, 1);
+	g_assert_cmpint (g_node_max_height (tree), ==, 8);
+
+	/* children keep the order they were in the array */
+	node = g_node_first_child (tree);
+	g_assert_cmpint (g_node_n_children (node), ==, 4);
+	g_assert_cmpstr (pk_category_get_id (g_node_first_child (node)->data), ==, "cat-4");
+	g_assert_cmpstr (pk_category_get_id (g_node_last_child (node)->data), ==, "cat-1");
+	g_node_destroy (tree);
+
+	/* an unknown parent puts the category at the top level */
+	g_ptr_array_set_size (array, 0);
+	for (i = 0; i < 2; i++) {
+		PkCategory *item = pk_category_new ();
+		g_autofree gchar *cat_id = g_strdup_printf ("orphan-%u", i);
+
+		pk_category_set_id (item, cat_id);
+		pk_category_set_parent_id (item, "missing");
+		g_ptr_array_add (array, item);
+	}
+	tree = gpk_category_array_to_tree (array);
+	g_assert_cmpint (g_node_n_children (tree), ==, 2);
+	g_assert_cmpint (g_node_n_nodes (tree, G_TRAVERSE_ALL), ==, 3);
+	g_node_destroy (tree);
+}
+
+static gchar *
+gpk_test_file_list_get_text (GtkTreeModel *model, const gchar *path_str)
+{
+	GtkTreeIter iter;
+	gchar *text = NULL;
+
+	if (!gtk_tree_model_get_iter_from_string (model, &iter, path_str))
+		return NULL;
+	gtk_tree_model_get (model, &iter, GPK_FILE_LIST_COLUMN_TEXT, &text, -1);
+	return text;
+}
+
+static void
+gpk_test_file_list_func (void)
+{
+	GtkTreeIter iter;
+	g_autoptr(GPtrArray) files = NULL;
+	g_autoptr(GpkFileList) list = NULL;
+	g_autofree gchar *text = NULL;
+	const gchar *data[] = { "/usr/share/foo-bar",
+				"/usr/share/foo/a",
+				"/etc/foo.conf",
+				"/usr/share/foo",
+				"/usr/bin/foo",
+				NULL };
+
+	/* directories are followed by their contents */
+	files = pk_strv_to_ptr_array ((gchar **) data);
+	gpk_file_list_sort (files);
+	g_assert_cmpstr (g_ptr_array_index (files, 2), ==, "/usr/share/foo");
+	g_assert_cmpstr (g_ptr_array_index (files, 3), ==, "/usr/share/foo/a");
+	g_assert_cmpstr (g_ptr_array_index (files, 4), ==, "/usr/share/foo-bar");
+
+	/* flat */
+	list = gpk_file_list_new (files, FALSE, NULL);
+	g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (list), NULL), ==, 5);
+	text = gpk_test_file_list_get_text (GTK_TREE_MODEL (list), "4");
+	g_assert_cmpstr (text, ==, "/usr/share/foo-bar");
+	g_clear_pointer (&text, g_free);
+	g_assert_null (gpk_test_file_list_get_text (GTK_TREE_MODEL (list), "5"));
+	g_clear_object (&list);
+
+	/* filtered */
+	list = gpk_file_list_new (files, FALSE, "foo/");
+	g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (list), NULL), ==, 1);
+	g_clear_object (&list);
+
+	/* tree */
+	list = gpk_file_list_new (files, TRUE, NULL);
+	g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (list), NULL), ==, 2);
+	text = gpk_test_file_list_get_text (GTK_TREE_MODEL (list), "1");
+	g_assert_cmpstr (text, ==, "/usr");
+	g_clear_pointer (&text, g_free);
+	text = gpk_test_file_list_get_text (GTK_TREE_MODEL (list), "1:1:1");
+	g_assert_cmpstr (text, ==, "foo-bar");
+	g_clear_pointer (&text, g_free);
+	text = gpk_test_file_list_get_text (GTK_TREE_MODEL (list), "1:1:0:0");
+	g_assert_cmpstr (text, ==, "a");
+	g_clear_pointer (&text, g_free);
+	g_assert_true (gtk_tree_model_get_iter_from_string (GTK_TREE_MODEL (list), &iter, "1:1:1"));
+	g_assert_false (gtk_tree_model_iter_has_child (GTK_TREE_MODEL (list), &iter));
+	g_assert_true (gtk_tree_model_get_iter_from_string (GTK_TREE_MODEL (list), &iter, "1:1:0"));
+	g_assert_true (gtk_tree_model_iter_has_child (GTK_TREE_MODEL (list), &iter));
+}
+
 int
 main (int argc, char **argv)
 {
@@ -176,7 +357,10 @@ main (int argc, char **argv)
 	g_test_init (&argc, &argv, NULL);
 
 	g_test_add_func ("/gnome-packagekit/enum", gpk_test_enum_func);
+	g_test_add_func ("/gnome-packagekit/enum-icons", gpk_test_enum_icons_func);
 	g_test_add_func ("/gnome-packagekit/common", gpk_test_common_func);
+	g_test_add_func ("/gnome-packagekit/category-tree", gpk_test_category_tree_func);
+	g_test_add_func ("/gnome-packagekit/file-list", gpk_test_file_list_func);
 
 	return g_test_run ();
 }
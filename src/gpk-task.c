@@ -30,6 +30,9 @@
 #include "gpk-dialog.h"
 
 static void     gpk_task_finalize	(GObject     *object);
+static void     gpk_task_setup_dialog_untrusted	(GpkTask *task);
+static void     gpk_task_setup_dialog_signature	(GpkTask *task);
+static void     gpk_task_setup_dialog_eula	(GpkTask *task);
 
 struct _GpkTaskPrivate
 {
@@ -96,6 +99,10 @@ gpk_task_untrusted_question (PkTask *task, guint request, PkResults *results)
 	/* save the current request */
 	priv->request = request;
 
+	/* most transactions never need this */
+	if (priv->builder_untrusted == NULL)
+		gpk_task_setup_dialog_untrusted (GPK_TASK (task));
+
 	/* title */
 	widget = GTK_WIDGET(gtk_builder_get_object (priv->builder_untrusted, "label_title"));
 	gtk_widget_hide (widget);
@@ -172,6 +179,10 @@ gpk_task_key_question (PkTask *task, guint request, PkResults *results)
 		      "key-id", &key_id,
 		      NULL);
 
+	/* most transactions never need this */
+	if (priv->builder_signature == NULL)
+		gpk_task_setup_dialog_signature (GPK_TASK (task));
+
 	/* show correct text */
 	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder_signature, "label_name"));
 	gtk_label_set_label (GTK_LABEL (widget), repository_name);
@@ -230,6 +241,10 @@ gpk_task_eula_question (PkTask *task, guint request, PkResults *results)
 		      "license-agreement", &license_agreement,
 		      NULL);
 
+	/* most transactions never need this */
+	if (priv->builder_eula == NULL)
+		gpk_task_setup_dialog_eula (GPK_TASK (task));
+
 	/* title */
 	widget = GTK_WIDGET (gtk_builder_get_object (priv->builder_eula, "label_title"));
 
@@ -384,40 +399,17 @@ gpk_task_add_dialog_deps_section (PkTask *task,
 	gtk_notebook_append_page (tabbed_widget, tab_page, tab_label);
 }
 
-static void
-gpk_task_simulate_question (PkTask *task, guint request, PkResults *results)
+static GtkWidget *
+gpk_task_simulate_dialog_new (GpkTask *task,
+			      PkRoleEnum role,
+			      guint inputs,
+			      PkPackageSack *sack)
 {
-	gboolean ret;
-	g_autoptr(GPtrArray) array = NULL;
-	GpkTaskPrivate *priv = GET_PRIVATE (GPK_TASK(task));
-	PkRoleEnum role;
-	g_autoptr(PkPackageSack) sack = NULL;
-	guint inputs;
+	GpkTaskPrivate *priv = GET_PRIVATE (task);
 	const gchar *title;
 	const gchar *message = NULL;
+	GtkWidget *dialog;
 	GtkNotebook *tabbed_widget = NULL;
-	PkBitfield transaction_flags = 0;
-
-	/* save the current request */
-	priv->request = request;
-
-	/* get data about the transaction */
-	g_object_get (results,
-		      "role", &role,
-		      "inputs", &inputs,
-		      "transaction-flags", &transaction_flags,
-		      NULL);
-
-	/* allow skipping of deps except when we remove other packages */
-	if (role != PK_ROLE_ENUM_REMOVE_PACKAGES) {
-		/* have we previously said we don't want to be shown the confirmation */
-		ret = g_settings_get_boolean (priv->settings, GPK_SETTINGS_SHOW_DEPENDS);
-		if (!ret) {
-			g_debug ("we've said we don't want the dep dialog");
-			pk_task_user_accepted (PK_TASK(task), priv->request);
-			return;
-		}
-	}
 
 	/* TRANSLATORS: title of a dependency dialog */
 	title = _("Additional confirmation required");
@@ -449,53 +441,115 @@ gpk_task_simulate_question (PkTask *task, guint request, PkResults *results)
 		message = _("To process this transaction, additional software also has to be modified.");
 	}
 
-	priv->current_window = GTK_WINDOW (gtk_message_dialog_new (priv->parent_window,
-								   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-								   GTK_MESSAGE_INFO, GTK_BUTTONS_CANCEL, "%s", title));
-	gtk_message_dialog_format_secondary_markup (GTK_MESSAGE_DIALOG (priv->current_window), "%s", message);
+	dialog = gtk_message_dialog_new (priv->parent_window,
+					 GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+					 GTK_MESSAGE_INFO, GTK_BUTTONS_CANCEL, "%s", title);
+	gtk_message_dialog_format_secondary_markup (GTK_MESSAGE_DIALOG (dialog), "%s", message);
 
 	tabbed_widget = GTK_NOTEBOOK (gtk_notebook_new ());
 
 	/* get the details for all the packages */
-	sack = pk_results_get_package_sack (results);
-
-	gpk_task_add_dialog_deps_section (task, tabbed_widget, sack,
+	gpk_task_add_dialog_deps_section (PK_TASK (task), tabbed_widget, sack,
 					  PK_INFO_ENUM_INSTALLING);
-
-	/* TRANSLATORS: additional message text for the deps dialog */
-	gpk_task_add_dialog_deps_section (task, tabbed_widget, sack,
+	gpk_task_add_dialog_deps_section (PK_TASK (task), tabbed_widget, sack,
 					  PK_INFO_ENUM_REMOVING);
-
-	/* TRANSLATORS: additional message text for the deps dialog */
-	gpk_task_add_dialog_deps_section (task, tabbed_widget, sack,
+	gpk_task_add_dialog_deps_section (PK_TASK (task), tabbed_widget, sack,
 					  PK_INFO_ENUM_UPDATING);
-
-	/* TRANSLATORS: additional message text for the deps dialog */
-	gpk_task_add_dialog_deps_section (task, tabbed_widget, sack,
+	gpk_task_add_dialog_deps_section (PK_TASK (task), tabbed_widget, sack,
 					  PK_INFO_ENUM_OBSOLETING);
-
-	/* TRANSLATORS: additional message text for the deps dialog */
-	gpk_task_add_dialog_deps_section (task, tabbed_widget, sack,
+	gpk_task_add_dialog_deps_section (PK_TASK (task), tabbed_widget, sack,
 					  PK_INFO_ENUM_REINSTALLING);
-
-	/* TRANSLATORS: additional message text for the deps dialog */
-	gpk_task_add_dialog_deps_section (task, tabbed_widget, sack,
+	gpk_task_add_dialog_deps_section (PK_TASK (task), tabbed_widget, sack,
 					  PK_INFO_ENUM_DOWNGRADING);
 
-	gpk_dialog_embed_tabbed_widget (GTK_DIALOG(priv->current_window),
-					tabbed_widget);
+	gpk_dialog_embed_tabbed_widget (GTK_DIALOG (dialog), tabbed_widget);
 
-	gpk_dialog_embed_do_not_show_widget (GTK_DIALOG(priv->current_window), GPK_SETTINGS_SHOW_DEPENDS);
+	gpk_dialog_embed_do_not_show_widget (GTK_DIALOG (dialog), GPK_SETTINGS_SHOW_DEPENDS);
 	/* TRANSLATORS: this is button text */
-	gtk_dialog_add_button (GTK_DIALOG(priv->current_window), _("Continue"), GTK_RESPONSE_YES);
+	gtk_dialog_add_button (GTK_DIALOG (dialog), _("Continue"), GTK_RESPONSE_YES);
 
 	/* set icon name */
-	gtk_window_set_icon_name (priv->current_window, GPK_ICON_SOFTWARE_INSTALLER);
+	gtk_window_set_icon_name (GTK_WINDOW (dialog), GPK_ICON_SOFTWARE_INSTALLER);
+	return dialog;
+}
 
+static void
+gpk_task_simulate_question (PkTask *task, guint request, PkResults *results)
+{
+	gboolean ret;
+	GpkTaskPrivate *priv = GET_PRIVATE (GPK_TASK(task));
+	PkRoleEnum role;
+	g_autoptr(PkPackageSack) sack = NULL;
+	guint inputs;
+	PkBitfield transaction_flags = 0;
+
+	/* save the current request */
+	priv->request = request;
+
+	/* get data about the transaction */
+	g_object_get (results,
+		      "role", &role,
+		      "inputs", &inputs,
+		      "transaction-flags", &transaction_flags,
+		      NULL);
+
+	/* allow skipping of deps except when we remove other packages */
+	if (role != PK_ROLE_ENUM_REMOVE_PACKAGES) {
+		/* have we previously said we don't want to be shown the confirmation */
+		ret = g_settings_get_boolean (priv->settings, GPK_SETTINGS_SHOW_DEPENDS);
+		if (!ret) {
+			g_debug ("we've said we don't want the dep dialog");
+			pk_task_user_accepted (PK_TASK(task), priv->request);
+			return;
+		}
+	}
+
+	sack = pk_results_get_package_sack (results);
+	priv->current_window = GTK_WINDOW (gpk_task_simulate_dialog_new (GPK_TASK (task), role, inputs, sack));
 	g_signal_connect (priv->current_window, "response", G_CALLBACK (gpk_task_dialog_response_cb), task);
 	gtk_widget_show_all (GTK_WIDGET(priv->current_window));
 }
 
+/**
+ * gpk_task_confirm_simulate:
+ * @sack: the packages the simulated transactions would also modify
+ *
+ * Shows the same dependency dialog as the simulate question, but for
+ * simulations the caller ran itself, e.g. when several transactions are
+ * confirmed together. Nothing is shown if @sack is empty.
+ *
+ * Return value: %TRUE if the user wants to continue
+ **/
+gboolean
+gpk_task_confirm_simulate (GpkTask *task,
+			   PkRoleEnum role,
+			   guint inputs,
+			   PkPackageSack *sack)
+{
+	GtkWidget *dialog;
+	gint response;
+	g_autoptr(PkPackageSack) sack_removing = NULL;
+
+	g_return_val_if_fail (GPK_IS_TASK (task), FALSE);
+
+	if (pk_package_sack_get_size (sack) == 0)
+		return TRUE;
+
+	/* allow skipping of deps except when we remove other packages */
+	sack_removing = pk_package_sack_filter_by_info (sack, PK_INFO_ENUM_REMOVING);
+	if (pk_package_sack_get_size (sack_removing) == 0 &&
+	    !g_settings_get_boolean (task->priv->settings, GPK_SETTINGS_SHOW_DEPENDS)) {
+		g_debug ("we've said we don't want the dep dialog");
+		return TRUE;
+	}
+
+	dialog = gpk_task_simulate_dialog_new (task, role, inputs, sack);
+	gtk_widget_show_all (dialog);
+	response = gtk_dialog_run (GTK_DIALOG (dialog));
+	gtk_widget_destroy (dialog);
+	return response == GTK_RESPONSE_YES;
+}
+
 static void
 gpk_task_setup_dialog_untrusted (GpkTask *task)
 {
@@ -617,11 +671,6 @@ gpk_task_init (GpkTask *task)
 	task->priv->parent_window = NULL;
 	task->priv->current_window = NULL;
 	task->priv->settings = g_settings_new (GPK_SETTINGS_SCHEMA);
-
-	/* setup dialogs ahead of time */
-	gpk_task_setup_dialog_untrusted (task);
-	gpk_task_setup_dialog_eula (task);
-	gpk_task_setup_dialog_signature (task);
 }
 
 static void
@@ -629,9 +678,9 @@ gpk_task_finalize (GObject *object)
 {
 	GpkTask *task = GPK_TASK (object);
 
-	g_object_unref (task->priv->builder_untrusted);
-	g_object_unref (task->priv->builder_signature);
-	g_object_unref (task->priv->builder_eula);
+	g_clear_object (&task->priv->builder_untrusted);
+	g_clear_object (&task->priv->builder_signature);
+	g_clear_object (&task->priv->builder_eula);
 	g_object_unref (task->priv->settings);
 
 	G_OBJECT_CLASS (gpk_task_parent_class)->finalize (object);
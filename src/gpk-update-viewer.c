@@ -71,27 +71,11 @@ static	GtkWidget		*info_mobile_label = NULL;
 static	GtkApplication		*application = NULL;
 static	PkBitfield		 roles = 0;
 static	gboolean		 have_available_distro_upgrades = FALSE;
-
-enum {
-	GPK_UPDATES_COLUMN_TEXT,
-	GPK_UPDATES_COLUMN_ID,
-	GPK_UPDATES_COLUMN_INFO,
-	GPK_UPDATES_COLUMN_SELECT,
-	GPK_UPDATES_COLUMN_SENSITIVE,
-	GPK_UPDATES_COLUMN_CLICKABLE,
-	GPK_UPDATES_COLUMN_RESTART,
-	GPK_UPDATES_COLUMN_SIZE,
-	GPK_UPDATES_COLUMN_SIZE_DISPLAY,
-	GPK_UPDATES_COLUMN_PERCENTAGE,
-	GPK_UPDATES_COLUMN_STATUS,
-	GPK_UPDATES_COLUMN_DETAILS_OBJ,
-	GPK_UPDATES_COLUMN_UPDATE_DETAIL_OBJ,
-	GPK_UPDATES_COLUMN_PULSE,
-	GPK_UPDATES_COLUMN_VISIBLE,
-	GPK_UPDATES_COLUMN_LAST
-};
+static	gboolean		 is_service = FALSE;
+static	gboolean		 updates_installed = FALSE;
 
 static void gpk_update_viewer_get_new_update_array (void);
+static void gpk_update_viewer_packages_set_sensitive (gboolean sensitive);
 
 static gboolean
 _g_strzero (const gchar *text)
@@ -103,14 +87,60 @@ _g_strzero (const gchar *text)
 	return FALSE;
 }
 
+static void
+gpk_update_viewer_hide (void)
+{
+	GtkWindow *window;
+
+	/* stop holding the application so the idle timeout can start */
+	window = GTK_WINDOW (gtk_builder_get_object (builder, "dialog_updates"));
+	gtk_widget_hide (GTK_WIDGET (window));
+	if (gtk_window_get_application (window) != NULL)
+		gtk_application_remove_window (application, window);
+}
+
+static void
+gpk_update_viewer_reload (void)
+{
+	GtkWidget *widget;
+
+	/* the updates-changed signal was ignored while updating */
+	ignore_updates_changed = FALSE;
+	updates_installed = FALSE;
+	gpk_update_viewer_packages_set_sensitive (TRUE);
+
+	/* enabled again when the new list has arrived */
+	widget = GTK_WIDGET(gtk_builder_get_object (builder, "button_install"));
+	gtk_widget_set_sensitive (widget, FALSE);
+
+	/* this also resets the header */
+	gpk_update_viewer_get_new_update_array ();
+}
+
 static void
 gpk_update_viewer_quit (void)
 {
+	/* keep the window for the next activation, but not what was
+	 * installed; otherwise updates-changed keeps the list current */
+	if (is_service) {
+		if (updates_installed)
+			gpk_update_viewer_reload ();
+		gpk_update_viewer_hide ();
+		return;
+	}
+
 	/* are we in a transaction */
 	g_cancellable_cancel (cancellable);
 	g_application_release (G_APPLICATION (application));
 }
 
+static gboolean
+gpk_update_viewer_delete_event_cb (GtkWidget *widget, GdkEvent *event, gpointer user_data)
+{
+	gpk_update_viewer_hide ();
+	return TRUE;
+}
+
 static void
 gpk_update_viewer_packages_set_sensitive (gboolean sensitive)
 {
@@ -392,6 +422,12 @@ gpk_update_viewer_update_packages_cb (PkTask *_task, GAsyncResult *res, gpointer
 			gpk_update_viewer_error_dialog (_("Could not update packages"), NULL, error->message);
 		}
 
+		/* some updates may have been installed before the failure */
+		if (is_service) {
+			gpk_update_viewer_reload ();
+			goto out;
+		}
+
 		/* re-enable the package list */
 		gpk_update_viewer_packages_set_sensitive (TRUE);
 
@@ -401,6 +437,7 @@ gpk_update_viewer_update_packages_cb (PkTask *_task, GAsyncResult *res, gpointer
 
 		goto out;
 	}
+	gpk_trace_end (GPOINTER_TO_UINT (user_data), NULL);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -413,6 +450,12 @@ gpk_update_viewer_update_packages_cb (PkTask *_task, GAsyncResult *res, gpointer
 		gpk_error_dialog_modal (window, gpk_error_enum_to_localised_text (pk_error_get_code (error_code)),
 					gpk_error_enum_to_localised_message (pk_error_get_code (error_code)), pk_error_get_details (error_code));
 
+		/* some updates may have been installed before the failure */
+		if (is_service) {
+			gpk_update_viewer_reload ();
+			goto out;
+		}
+
 		/* re-enable the package list */
 		gpk_update_viewer_packages_set_sensitive (TRUE);
 
@@ -424,6 +467,7 @@ gpk_update_viewer_update_packages_cb (PkTask *_task, GAsyncResult *res, gpointer
 	}
 
 	gpk_update_viewer_packages_set_sensitive (TRUE);
+	updates_installed = TRUE;
 
 	/* get the worst restart case */
 	restart = pk_results_get_require_restart_worst (results);
@@ -634,112 +678,6 @@ gpk_update_viewer_model_get_path (GtkTreeModel *model, const gchar *package_id)
 	return path;
 }
 
-static const gchar *
-gpk_update_view_get_info_headers (PkInfoEnum info)
-{
-	const gchar *text = NULL;
-	switch (info) {
-	case PK_INFO_ENUM_LOW:
-		/* TRANSLATORS: The type of update */
-		text = _("Trivial updates");
-		break;
-	case PK_INFO_ENUM_IMPORTANT:
-		/* TRANSLATORS: The type of update */
-		text = _("Important updates");
-		break;
-	case PK_INFO_ENUM_SECURITY:
-		/* TRANSLATORS: The type of update */
-		text = _("Security updates");
-		break;
-	case PK_INFO_ENUM_BUGFIX:
-		/* TRANSLATORS: The type of update */
-		text = _("Bug fix updates");
-		break;
-	case PK_INFO_ENUM_ENHANCEMENT:
-		/* TRANSLATORS: The type of update */
-		text = _("Enhancement updates");
-		break;
-	case PK_INFO_ENUM_BLOCKED:
-		/* TRANSLATORS: The type of update */
-		text = _("Blocked updates");
-		break;
-	default:
-		/* TRANSLATORS: The type of update, i.e. unspecified */
-		text = _("Other updates");
-	}
-	return text;
-}
-
-static void
-gpk_update_viewer_get_parent_for_info (PkInfoEnum info, GtkTreeIter *parent)
-{
-	gboolean is_package;
-	gboolean ret = FALSE;
-	gboolean valid;
-	g_autofree gchar *title = NULL;
-	GtkTreeIter iter;
-	GtkTreeModel *model;
-	GtkTreeView *treeview;
-	PkInfoEnum info_tmp;
-
-	treeview = GTK_TREE_VIEW(gtk_builder_get_object (builder, "treeview_updates"));
-	model = gtk_tree_view_get_model (treeview);
-
-	/* get the first iter in the array */
-	valid = gtk_tree_model_get_iter_first (model, &iter);
-
-	/* smush some update states together */
-	switch (info) {
-	case PK_INFO_ENUM_ENHANCEMENT:
-	case PK_INFO_ENUM_LOW:
-		info = PK_INFO_ENUM_NORMAL;
-		break;
-	default:
-		break;
-	}
-
-	/* find out how many we should update */
-	while (valid) {
-		g_autofree gchar *package_id_tmp = NULL;
-		gtk_tree_model_get (model, &iter,
-				    GPK_UPDATES_COLUMN_INFO, &info_tmp,
-				    GPK_UPDATES_COLUMN_ID, &package_id_tmp,
-				    -1);
-		is_package = package_id_tmp != NULL;
-
-		/* right section? */
-		if (!is_package && info_tmp == info) {
-			*parent = iter;
-			ret = TRUE;
-			break;
-		}
-
-		valid = gtk_tree_model_iter_next (model, &iter);
-	}
-
-	/* create */
-	if (!ret) {
-		title = g_strdup_printf ("<b>%s</b>",
-					 gpk_update_view_get_info_headers (info));
-		gtk_tree_store_append (array_store_updates, &iter, NULL);
-		gtk_tree_store_set (array_store_updates, &iter,
-				    GPK_UPDATES_COLUMN_TEXT, title,
-				    GPK_UPDATES_COLUMN_ID, NULL,
-				    GPK_UPDATES_COLUMN_INFO, info,
-				    GPK_UPDATES_COLUMN_SELECT, TRUE,
-				    GPK_UPDATES_COLUMN_VISIBLE, FALSE,
-				    GPK_UPDATES_COLUMN_CLICKABLE, FALSE,
-				    GPK_UPDATES_COLUMN_RESTART, PK_RESTART_ENUM_NONE,
-				    GPK_UPDATES_COLUMN_STATUS, PK_INFO_ENUM_UNKNOWN,
-				    GPK_UPDATES_COLUMN_SIZE, 0,
-				    GPK_UPDATES_COLUMN_SIZE_DISPLAY, 0,
-				    GPK_UPDATES_COLUMN_PERCENTAGE, 0,
-				    GPK_UPDATES_COLUMN_PULSE, -1,
-				    -1);
-		*parent = iter;
-	}
-}
-
 static void
 gpk_update_viewer_progress_cb (PkProgress *progress,
 			       PkProgressType type,
@@ -756,6 +694,7 @@ gpk_update_viewer_progress_cb (PkProgress *progress,
 	g_autofree gchar *package_id = NULL;
 	g_autofree gchar *summary = NULL;
 
+	gpk_trace_progress (GPOINTER_TO_UINT (user_data), type);
 	g_object_get (progress,
 		      "role", &role,
 		      "status", &status,
@@ -1077,6 +1016,7 @@ gpk_update_viewer_button_install_cb (GtkWidget *widget, gpointer user_data)
 	g_autoptr(GPtrArray) array = NULL;
 	GtkTreeView *treeview;
 	g_auto(GStrv) package_ids = NULL;
+	guint trace;
 
 	/* hide the upgrade viewbox from now on */
 	widget = GTK_WIDGET(gtk_builder_get_object (builder, "viewport_upgrade"));
@@ -1104,9 +1044,10 @@ gpk_update_viewer_button_install_cb (GtkWidget *widget, gpointer user_data)
 	package_ids = pk_ptr_array_to_strv (array);
 
 	/* the backend is able to do UpdatePackages */
+	trace = gpk_trace_begin (PK_ROLE_ENUM_UPDATE_PACKAGES);
 	pk_task_update_packages_async (task, package_ids, cancellable,
-				       (PkProgressCallback) gpk_update_viewer_progress_cb, NULL,
-				       (GAsyncReadyCallback) gpk_update_viewer_update_packages_cb, NULL);
+				       (PkProgressCallback) gpk_update_viewer_progress_cb, GUINT_TO_POINTER (trace),
+				       (GAsyncReadyCallback) gpk_update_viewer_update_packages_cb, GUINT_TO_POINTER (trace));
 
 	/* from now on ignore updates-changed signals */
 	ignore_updates_changed = TRUE;
@@ -1225,8 +1166,12 @@ gpk_update_viewer_modal_error_with_timeout (const gchar *title, const gchar *mes
 	text = g_strdup_printf ("<big><b>%s</b></big>", _("There are no updates available"));
 	gtk_label_set_label (GTK_LABEL(widget), text);
 
-	/* show modal dialog */
+	/* running in the background with the window closed */
 	widget = GTK_WIDGET(gtk_builder_get_object (builder, "dialog_updates"));
+	if (!gtk_widget_get_visible (widget))
+		return;
+
+	/* show modal dialog */
 	dialog = gtk_message_dialog_new (GTK_WINDOW(widget), GTK_DIALOG_MODAL,
 					 GTK_MESSAGE_INFO, GTK_BUTTONS_OK,
 					 "%s", title);
@@ -1866,6 +1811,7 @@ gpk_update_viewer_get_details_cb (PkClient *client, GAsyncResult *res, gpointer
 		gpk_update_viewer_error_dialog (_("Could not get update details"), NULL, error->message);
 		return;
 	}
+	gpk_trace_mark (GPOINTER_TO_UINT (user_data), GPK_TRACE_MARK_FINISHED);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -1924,6 +1870,7 @@ gpk_update_viewer_get_details_cb (PkClient *client, GAsyncResult *res, gpointer
 	path = gtk_tree_path_new_first ();
 	gtk_tree_selection_select_path (selection, path);
 	gtk_tree_path_free (path);
+	gpk_trace_end (GPOINTER_TO_UINT (user_data), widget);
 
 	/* set info */
 	gpk_update_viewer_reconsider_info ();
@@ -1952,6 +1899,7 @@ gpk_update_viewer_get_update_detail_cb (PkClient *client, GAsyncResult *res, gpo
 		gpk_update_viewer_error_dialog (_("Could not get update details"), NULL, error->message);
 		return;
 	}
+	gpk_trace_mark (GPOINTER_TO_UINT (user_data), GPK_TRACE_MARK_FINISHED);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -1996,6 +1944,8 @@ gpk_update_viewer_get_update_detail_cb (PkClient *client, GAsyncResult *res, gpo
 					    GPK_UPDATES_COLUMN_RESTART, restart, -1);
 		}
 	}
+	gpk_trace_end (GPOINTER_TO_UINT (user_data),
+		       GTK_WIDGET (gtk_builder_get_object (builder, "treeview_updates")));
 }
 
 static void
@@ -2274,17 +2224,14 @@ gpk_update_viewer_get_updates_cb (PkClient *client, GAsyncResult *res, gpointer
 	g_autoptr(GPtrArray) array = NULL;
 	g_autoptr(GPtrArray) array_messages = NULL;
 	PkPackage *item;
-	gboolean selected;
-	gboolean sensitive;
-	GtkTreeIter iter;
-	GtkTreeIter parent;
 	guint i;
+	guint token = GPOINTER_TO_UINT (user_data);
+	guint trace;
 	GtkTreeView *treeview;
 	GtkTreeModel *model;
 	GtkWidget *widget;
 	g_autoptr(PkError) error_code = NULL;
 	GtkWindow *window;
-	PkInfoEnum info;
 
 	/* get the results */
 	results = pk_client_generic_finish (client, res, &error);
@@ -2293,6 +2240,7 @@ gpk_update_viewer_get_updates_cb (PkClient *client, GAsyncResult *res, gpointer
 		gpk_update_viewer_error_dialog (_("Could not get updates"), NULL, error->message);
 		return;
 	}
+	gpk_trace_mark (token, GPK_TRACE_MARK_FINISHED);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -2311,53 +2259,11 @@ gpk_update_viewer_get_updates_cb (PkClient *client, GAsyncResult *res, gpointer
 	array = pk_package_sack_get_array (sack);
 	widget = GTK_WIDGET(gtk_builder_get_object (builder, "treeview_updates"));
 	for (i = 0; i < array->len; i++) {
-		g_autofree gchar *text = NULL;
-		g_autofree gchar *package_id = NULL;
-		g_autofree gchar *summary = NULL;
 		item = g_ptr_array_index (array, i);
-
-		/* get data */
-		g_object_get (item,
-			      "info", &info,
-			      "package-id", &package_id,
-			      "summary", &summary,
-			      NULL);
-
-		/* find our parent */
-		gpk_update_viewer_get_parent_for_info (info, &parent);
-
-		/* add to array store */
-		text = gpk_package_id_format_twoline (gtk_widget_get_style_context (widget),
-						      package_id,
-						      summary);
-		g_debug ("adding: id=%s, text=%s", package_id, text);
-		selected = (info != PK_INFO_ENUM_BLOCKED);
-
-		/* only make the checkbox selectable if:
-		 *  - we can do UpdatePackages rather than just UpdateSystem
-		 *  - the update is not blocked
-		 */
-		sensitive = selected;
-		if (!pk_bitfield_contain (roles, PK_ROLE_ENUM_UPDATE_PACKAGES))
-			sensitive = FALSE;
-
-		/* add to model */
-		gtk_tree_store_append (array_store_updates, &iter, &parent);
-		gtk_tree_store_set (array_store_updates, &iter,
-				    GPK_UPDATES_COLUMN_TEXT, text,
-				    GPK_UPDATES_COLUMN_ID, package_id,
-				    GPK_UPDATES_COLUMN_INFO, info,
-				    GPK_UPDATES_COLUMN_SELECT, selected,
-				    GPK_UPDATES_COLUMN_SENSITIVE, sensitive,
-				    GPK_UPDATES_COLUMN_VISIBLE, TRUE,
-				    GPK_UPDATES_COLUMN_CLICKABLE, selected,
-				    GPK_UPDATES_COLUMN_RESTART, PK_RESTART_ENUM_NONE,
-				    GPK_UPDATES_COLUMN_STATUS, PK_INFO_ENUM_UNKNOWN,
-				    GPK_UPDATES_COLUMN_SIZE, 0,
-				    GPK_UPDATES_COLUMN_SIZE_DISPLAY, 0,
-				    GPK_UPDATES_COLUMN_PERCENTAGE, 0,
-				    GPK_UPDATES_COLUMN_PULSE, -1,
-				    -1);
+		gpk_updates_store_add (array_store_updates,
+				       gtk_widget_get_style_context (widget),
+				       item,
+				       pk_bitfield_contain (roles, PK_ROLE_ENUM_UPDATE_PACKAGES));
 	}
 
 	/* get the download sizes */
@@ -2372,6 +2278,7 @@ gpk_update_viewer_get_updates_cb (PkClient *client, GAsyncResult *res, gpointer
 					      GPK_UPDATES_COLUMN_INFO,
 					      GTK_SORT_DESCENDING);
 	gtk_tree_view_expand_all (treeview);
+	gpk_trace_end (token, GTK_WIDGET (treeview));
 
 	/* get the download sizes */
 	if (update_array->len > 0) {
@@ -2379,14 +2286,16 @@ gpk_update_viewer_get_updates_cb (PkClient *client, GAsyncResult *res, gpointer
 		package_ids = gpk_update_viewer_packages_to_ids (array);
 
 		/* get the details of all the packages */
+		trace = gpk_trace_begin (PK_ROLE_ENUM_GET_UPDATE_DETAIL);
 		pk_client_get_update_detail_async (PK_CLIENT(task), package_ids, cancellable,
-						   (PkProgressCallback) gpk_update_viewer_progress_cb, NULL,
-						   (GAsyncReadyCallback) gpk_update_viewer_get_update_detail_cb, NULL);
+						   (PkProgressCallback) gpk_update_viewer_progress_cb, GUINT_TO_POINTER (trace),
+						   (GAsyncReadyCallback) gpk_update_viewer_get_update_detail_cb, GUINT_TO_POINTER (trace));
 
 		/* get the details of all the packages */
+		trace = gpk_trace_begin (PK_ROLE_ENUM_GET_DETAILS);
 		pk_client_get_details_async (PK_CLIENT(task), package_ids, cancellable,
-					     (PkProgressCallback) gpk_update_viewer_progress_cb, NULL,
-					     (GAsyncReadyCallback) gpk_update_viewer_get_details_cb, NULL);
+					     (PkProgressCallback) gpk_update_viewer_progress_cb, GUINT_TO_POINTER (trace),
+					     (GAsyncReadyCallback) gpk_update_viewer_get_details_cb, GUINT_TO_POINTER (trace));
 	}
 
 	/* are now able to do action */
@@ -2402,6 +2311,7 @@ gpk_update_viewer_get_new_update_array (void)
 {
 	GtkWidget *widget;
 	g_autofree gchar *text = NULL;
+	guint trace;
 	PkBitfield filter = PK_FILTER_ENUM_NONE;
 
 	/* clear all widgets */
@@ -2414,9 +2324,10 @@ gpk_update_viewer_get_new_update_array (void)
 	gtk_label_set_label (GTK_LABEL(widget), text);
 
 	/* get new array */
+	trace = gpk_trace_begin (PK_ROLE_ENUM_GET_UPDATES);
 	pk_client_get_updates_async (PK_CLIENT(task), filter, cancellable,
-				     (PkProgressCallback) gpk_update_viewer_progress_cb, NULL,
-				     (GAsyncReadyCallback) gpk_update_viewer_get_updates_cb, NULL);
+				     (PkProgressCallback) gpk_update_viewer_progress_cb, GUINT_TO_POINTER (trace),
+				     (GAsyncReadyCallback) gpk_update_viewer_get_updates_cb, GUINT_TO_POINTER (trace));
 }
 
 /**
@@ -2645,6 +2556,7 @@ gpk_update_viewer_get_distro_upgrades_cb (PkClient *client, GAsyncResult *res, g
 		gpk_update_viewer_error_dialog (_("Could not get list of distribution upgrades"), NULL, error->message);
 		return;
 	}
+	gpk_trace_mark (GPOINTER_TO_UINT (user_data), GPK_TRACE_MARK_FINISHED);
 
 	/* check error code */
 	error_code = pk_results_get_error_code (results);
@@ -2677,6 +2589,7 @@ gpk_update_viewer_get_distro_upgrades_cb (PkClient *client, GAsyncResult *res, g
 
 	widget = GTK_WIDGET(gtk_builder_get_object (builder, "viewport_upgrade"));
 	gtk_widget_show (widget);
+	gpk_trace_end (GPOINTER_TO_UINT (user_data), widget);
 
 	/* don't autoclose when upgrades */
 	have_available_distro_upgrades = TRUE;
@@ -2690,6 +2603,7 @@ gpk_update_viewer_get_properties_cb (PkControl *_control, GAsyncResult *res, gpo
 {
 	g_autoptr(GError) error = NULL;
 	gboolean ret;
+	guint trace;
 
 	/* get the result */
 	ret = pk_control_get_properties_finish (control, res, &error);
@@ -2707,9 +2621,10 @@ gpk_update_viewer_get_properties_cb (PkControl *_control, GAsyncResult *res, gpo
 
 	/* get the distro-upgrades if we support it */
 	if (pk_bitfield_contain (roles, PK_ROLE_ENUM_GET_DISTRO_UPGRADES)) {
+		trace = gpk_trace_begin (PK_ROLE_ENUM_GET_DISTRO_UPGRADES);
 		pk_client_get_distro_upgrades_async (PK_CLIENT(task), cancellable,
-						     (PkProgressCallback) gpk_update_viewer_progress_cb, NULL,
-						     (GAsyncReadyCallback) gpk_update_viewer_get_distro_upgrades_cb, NULL);
+						     (PkProgressCallback) gpk_update_viewer_progress_cb, GUINT_TO_POINTER (trace),
+						     (GAsyncReadyCallback) gpk_update_viewer_get_distro_upgrades_cb, GUINT_TO_POINTER (trace));
 	}
 }
 
@@ -2725,6 +2640,8 @@ gpk_update_viewer_activate_cb (GtkApplication *_application, gpointer user_data)
 {
 	GtkWindow *window;
 	window = GTK_WINDOW(gtk_builder_get_object (builder, "dialog_updates"));
+	if (gtk_window_get_application (window) == NULL)
+		gtk_application_add_window (application, window);
 	gtk_window_present (window);
 }
 
@@ -2781,13 +2698,21 @@ gpk_update_viewer_application_startup_cb (GtkApplication *_application, gpointer
 
 	main_window = GTK_WIDGET(gtk_builder_get_object (builder, "dialog_updates"));
 	gtk_window_set_icon_name (GTK_WINDOW(main_window), GPK_ICON_SOFTWARE_UPDATE);
-	gtk_application_add_window (application, GTK_WINDOW(main_window));
+
+	/* when started with --gapplication-service keep the window hidden,
+	 * and the update list current, until we are activated */
+	is_service = (g_application_get_flags (G_APPLICATION (application)) & G_APPLICATION_IS_SERVICE) > 0;
+	if (is_service) {
+		g_application_set_inactivity_timeout (G_APPLICATION (application),
+						      g_settings_get_uint (settings, GPK_SETTINGS_UPDATE_VIEWER_IDLE_TIMEOUT) * 1000);
+		g_signal_connect (main_window, "delete-event",
+				  G_CALLBACK (gpk_update_viewer_delete_event_cb), NULL);
+	} else {
+		gtk_application_add_window (application, GTK_WINDOW(main_window));
+	}
 
 	/* create array stores */
-	array_store_updates = gtk_tree_store_new (GPK_UPDATES_COLUMN_LAST, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_INT,
-						 G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN,
-						 G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT,
-						 G_TYPE_UINT, G_TYPE_POINTER, G_TYPE_POINTER, G_TYPE_INT, G_TYPE_BOOLEAN);
+	array_store_updates = gpk_updates_store_new ();
 	text_buffer = gtk_text_buffer_new (NULL);
 	gtk_text_buffer_create_tag (text_buffer, "para",
 				    "pixels_above_lines", 5,
@@ -2895,21 +2820,28 @@ gpk_update_viewer_application_startup_cb (GtkApplication *_application, gpointer
 	gtk_box_pack_start (GTK_BOX(widget), info_updates, FALSE, FALSE, 3);
 
 	/* show window */
-	gtk_widget_show (main_window);
+	if (!is_service)
+		gtk_widget_show (main_window);
 }
 
 int
 main (int argc, char *argv[])
 {
 	gboolean program_version = FALSE;
+	gboolean service = FALSE;
 	GOptionContext *context;
 	gboolean ret;
 	gint status = 0;
+	g_autoptr(GError) error = NULL;
 
 	const GOptionEntry options[] = {
 		{ "version", '\0', 0, G_OPTION_ARG_NONE, &program_version,
 		  /* TRANSLATORS: show the program version */
 		  _("Show the program version and exit"), NULL },
+		/* used by D-Bus activation, handled here so that any other
+		 * unknown option is still an error */
+		{ "gapplication-service", '\0', G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_NONE, &service,
+		  NULL, NULL },
 		{ NULL}
 	};
 
@@ -2926,8 +2858,13 @@ main (int argc, char *argv[])
 	g_option_context_add_main_entries (context, options, NULL);
 	g_option_context_add_group (context, gpk_debug_get_option_group ());
 	g_option_context_add_group (context, gtk_get_option_group (TRUE));
-	g_option_context_parse (context, &argc, &argv, NULL);
+
+	ret = g_option_context_parse (context, &argc, &argv, &error);
 	g_option_context_free (context);
+	if (!ret) {
+		g_printerr ("%s\n", error->message);
+		return 1;
+	}
 
 	if (program_version) {
 		g_print (VERSION "\n");
@@ -2946,7 +2883,9 @@ main (int argc, char *argv[])
 		return 1;
 
 	/* are we already activated? */
-	application = gtk_application_new ("org.gnome.PackageUpdater", 0);
+	application = gtk_application_new ("org.gnome.PackageUpdater",
+					   service ? G_APPLICATION_IS_SERVICE : G_APPLICATION_FLAGS_NONE);
+	gpk_debug_add_dump_action (G_ACTION_MAP (application));
 	g_signal_connect (application, "startup",
 			  G_CALLBACK (gpk_update_viewer_application_startup_cb), NULL);
 	g_signal_connect (application, "activate",
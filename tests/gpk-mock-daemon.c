@@ -0,0 +1,1152 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2007-2013 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * A stand-in for packagekitd that serves synthetic data from a scenario file,
+ * so the tools can be profiled without a distro backend, network or root.
+ * It owns org.freedesktop.PackageKit on the session bus and runs the command
+ * given after "--" with DBUS_SYSTEM_BUS_ADDRESS pointing at that bus, e.g.
+ *
+ *   dbus-run-session -- gpk-mock-daemon --scenario=updates.ini -- gpk-update-viewer
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+#include <packagekit-glib2/packagekit.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GPK_MOCK_DBUS_PATH_TRANSACTION	"/org/freedesktop/PackageKit/mock"
+
+static const gchar introspection_xml[] =
+	"<node>"
+	"  <interface name='org.freedesktop.PackageKit'>"
+	"    <property name='VersionMajor' type='u' access='read'/>"
+	"    <property name='VersionMinor' type='u' access='read'/>"
+	"    <property name='VersionMicro' type='u' access='read'/>"
+	"    <property name='BackendName' type='s' access='read'/>"
+	"    <property name='BackendDescription' type='s' access='read'/>"
+	"    <property name='BackendAuthor' type='s' access='read'/>"
+	"    <property name='Roles' type='t' access='read'/>"
+	"    <property name='Groups' type='t' access='read'/>"
+	"    <property name='Filters' type='t' access='read'/>"
+	"    <property name='MimeTypes' type='as' access='read'/>"
+	"    <property name='Locked' type='b' access='read'/>"
+	"    <property name='NetworkState' type='u' access='read'/>"
+	"    <property name='DistroId' type='s' access='read'/>"
+	"    <method name='CreateTransaction'>"
+	"      <arg type='o' name='object_path' direction='out'/>"
+	"    </method>"
+	"    <method name='GetTimeSinceAction'>"
+	"      <arg type='u' name='role' direction='in'/>"
+	"      <arg type='u' name='seconds' direction='out'/>"
+	"    </method>"
+	"    <method name='GetTransactionList'>"
+	"      <arg type='ao' name='transactions' direction='out'/>"
+	"    </method>"
+	"    <method name='StateHasChanged'>"
+	"      <arg type='s' name='reason' direction='in'/>"
+	"    </method>"
+	"    <method name='SuggestDaemonQuit'/>"
+	"    <method name='GetDaemonState'>"
+	"      <arg type='s' name='state' direction='out'/>"
+	"    </method>"
+	"    <method name='SetProxy'>"
+	"      <arg type='s' name='proxy_http' direction='in'/>"
+	"      <arg type='s' name='proxy_https' direction='in'/>"
+	"      <arg type='s' name='proxy_ftp' direction='in'/>"
+	"      <arg type='s' name='proxy_socks' direction='in'/>"
+	"      <arg type='s' name='no_proxy' direction='in'/>"
+	"      <arg type='s' name='pac' direction='in'/>"
+	"    </method>"
+	"    <method name='CanAuthorize'>"
+	"      <arg type='s' name='action_id' direction='in'/>"
+	"      <arg type='u' name='result' direction='out'/>"
+	"    </method>"
+	"    <signal name='TransactionListChanged'>"
+	"      <arg type='as' name='transactions'/>"
+	"    </signal>"
+	"    <signal name='RepoListChanged'/>"
+	"    <signal name='UpdatesChanged'/>"
+	"  </interface>"
+	"  <interface name='org.freedesktop.PackageKit.Transaction'>"
+	"    <property name='Role' type='u' access='read'/>"
+	"    <property name='Status' type='u' access='read'/>"
+	"    <property name='LastPackage' type='s' access='read'/>"
+	"    <property name='Uid' type='u' access='read'/>"
+	"    <property name='Percentage' type='u' access='read'/>"
+	"    <property name='AllowCancel' type='b' access='read'/>"
+	"    <property name='CallerActive' type='b' access='read'/>"
+	"    <property name='ElapsedTime' type='u' access='read'/>"
+	"    <property name='RemainingTime' type='u' access='read'/>"
+	"    <property name='Speed' type='u' access='read'/>"
+	"    <property name='DownloadSizeRemaining' type='t' access='read'/>"
+	"    <property name='TransactionFlags' type='t' access='read'/>"
+	"    <method name='SetHints'><arg type='as' name='hints' direction='in'/></method>"
+	"    <method name='Cancel'/>"
+	"    <method name='AcceptEula'><arg type='s' name='eula_id' direction='in'/></method>"
+	"    <method name='GetCategories'/>"
+	"    <method name='GetDistroUpgrades'/>"
+	"    <method name='GetDetails'><arg type='as' name='package_ids' direction='in'/></method>"
+	"    <method name='GetFiles'><arg type='as' name='package_ids' direction='in'/></method>"
+	"    <method name='GetUpdateDetail'><arg type='as' name='package_ids' direction='in'/></method>"
+	"    <method name='GetOldTransactions'><arg type='u' name='number' direction='in'/></method>"
+	"    <method name='GetPackages'><arg type='t' name='filter' direction='in'/></method>"
+	"    <method name='GetUpdates'><arg type='t' name='filter' direction='in'/></method>"
+	"    <method name='GetRepoList'><arg type='t' name='filter' direction='in'/></method>"
+	"    <method name='RefreshCache'><arg type='b' name='force' direction='in'/></method>"
+	"    <method name='RepoEnable'>"
+	"      <arg type='s' name='repo_id' direction='in'/>"
+	"      <arg type='b' name='enabled' direction='in'/>"
+	"    </method>"
+	"    <method name='DependsOn'>"
+	"      <arg type='t' name='filter' direction='in'/>"
+	"      <arg type='as' name='package_ids' direction='in'/>"
+	"      <arg type='b' name='recursive' direction='in'/>"
+	"    </method>"
+	"    <method name='RequiredBy'>"
+	"      <arg type='t' name='filter' direction='in'/>"
+	"      <arg type='as' name='package_ids' direction='in'/>"
+	"      <arg type='b' name='recursive' direction='in'/>"
+	"    </method>"
+	"    <method name='Resolve'>"
+	"      <arg type='t' name='filter' direction='in'/>"
+	"      <arg type='as' name='packages' direction='in'/>"
+	"    </method>"
+	"    <method name='SearchDetails'>"
+	"      <arg type='t' name='filter' direction='in'/>"
+	"      <arg type='as' name='values' direction='in'/>"
+	"    </method>"
+	"    <method name='SearchFiles'>"
+	"      <arg type='t' name='filter' direction='in'/>"
+	"      <arg type='as' name='values' direction='in'/>"
+	"    </method>"
+	"    <method name='SearchGroups'>"
+	"      <arg type='t' name='filter' direction='in'/>"
+	"      <arg type='as' name='values' direction='in'/>"
+	"    </method>"
+	"    <method name='SearchNames'>"
+	"      <arg type='t' name='filter' direction='in'/>"
+	"      <arg type='as' name='values' direction='in'/>"
+	"    </method>"
+	"    <method name='WhatProvides'>"
+	"      <arg type='t' name='filter' direction='in'/>"
+	"      <arg type='as' name='values' direction='in'/>"
+	"    </method>"
+	"    <method name='InstallPackages'>"
+	"      <arg type='t' name='transaction_flags' direction='in'/>"
+	"      <arg type='as' name='package_ids' direction='in'/>"
+	"    </method>"
+	"    <method name='UpdatePackages'>"
+	"      <arg type='t' name='transaction_flags' direction='in'/>"
+	"      <arg type='as' name='package_ids' direction='in'/>"
+	"    </method>"
+	"    <method name='RemovePackages'>"
+	"      <arg type='t' name='transaction_flags' direction='in'/>"
+	"      <arg type='as' name='package_ids' direction='in'/>"
+	"      <arg type='b' name='allow_deps' direction='in'/>"
+	"      <arg type='b' name='autoremove' direction='in'/>"
+	"    </method>"
+	"    <method name='DownloadPackages'>"
+	"      <arg type='b' name='store_in_cache' direction='in'/>"
+	"      <arg type='as' name='package_ids' direction='in'/>"
+	"    </method>"
+	"    <method name='InstallFiles'>"
+	"      <arg type='t' name='transaction_flags' direction='in'/>"
+	"      <arg type='as' name='full_paths' direction='in'/>"
+	"    </method>"
+	"    <signal name='Category'>"
+	"      <arg type='s' name='parent_id'/><arg type='s' name='cat_id'/>"
+	"      <arg type='s' name='name'/><arg type='s' name='summary'/>"
+	"      <arg type='s' name='icon'/>"
+	"    </signal>"
+	"    <signal name='Details'><arg type='a{sv}' name='data'/></signal>"
+	"    <signal name='ErrorCode'><arg type='u' name='code'/><arg type='s' name='details'/></signal>"
+	"    <signal name='Files'><arg type='s' name='package_id'/><arg type='as' name='file_list'/></signal>"
+	"    <signal name='Finished'><arg type='u' name='exit'/><arg type='u' name='runtime'/></signal>"
+	"    <signal name='ItemProgress'>"
+	"      <arg type='s' name='id'/><arg type='u' name='status'/><arg type='u' name='percentage'/>"
+	"    </signal>"
+	"    <signal name='Package'>"
+	"      <arg type='u' name='info'/><arg type='s' name='package_id'/><arg type='s' name='summary'/>"
+	"    </signal>"
+	"    <signal name='RepoDetail'>"
+	"      <arg type='s' name='repo_id'/><arg type='s' name='description'/><arg type='b' name='enabled'/>"
+	"    </signal>"
+	"    <signal name='Transaction'>"
+	"      <arg type='o' name='object_path'/><arg type='s' name='timespec'/>"
+	"      <arg type='b' name='succeeded'/><arg type='u' name='role'/>"
+	"      <arg type='u' name='duration'/><arg type='s' name='data'/>"
+	"      <arg type='u' name='uid'/><arg type='s' name='cmdline'/>"
+	"    </signal>"
+	"    <signal name='UpdateDetail'>"
+	"      <arg type='s' name='package_id'/><arg type='as' name='updates'/>"
+	"      <arg type='as' name='obsoletes'/><arg type='as' name='vendor_urls'/>"
+	"      <arg type='as' name='bugzilla_urls'/><arg type='as' name='cve_urls'/>"
+	"      <arg type='u' name='restart'/><arg type='s' name='update_text'/>"
+	"      <arg type='s' name='changelog'/><arg type='u' name='state'/>"
+	"      <arg type='s' name='issued'/><arg type='s' name='updated'/>"
+	"    </signal>"
+	"    <signal name='Destroy'/>"
+	"  </interface>"
+	"</node>";
+
+typedef struct {
+	guint		 latency;		/* ms before results are sent */
+	guint		 batch;			/* results sent per iteration */
+	guint		 interval;		/* ms between batches */
+	guint		 packages;
+	guint		 installed_ratio;	/* every Nth package is installed */
+	guint		 updates;
+	guint		 progress_steps;	/* ItemProgress signals per stage */
+	guint		 history;
+	guint		 history_packages;
+} GpkMockScenario;
+
+typedef struct {
+	GDBusConnection	*connection;
+	GDBusNodeInfo	*introspection;
+	GMainLoop	*loop;
+	GHashTable	*transactions;		/* object path -> GpkMockTransaction */
+	GpkMockScenario	 scenario;
+	gchar		**command;
+	guint		 tid_next;
+	gint		 exit_status;
+} GpkMockDaemon;
+
+typedef struct {
+	GpkMockDaemon	*mock;
+	gchar		*object_path;
+	guint		 registration_id;
+	PkRoleEnum	 role;
+	PkStatusEnum	 status;
+	guint		 percentage;
+	PkBitfield	 filters;
+	gchar		**values;
+	guint		 number;
+	guint		 idx;
+	guint		 total;
+	guint		 source_id;
+	GTimer		*timer;
+	gboolean	 finished;
+} GpkMockTransaction;
+
+static void
+gpk_mock_transaction_free (GpkMockTransaction *transaction)
+{
+	if (transaction->source_id != 0)
+		g_source_remove (transaction->source_id);
+	if (transaction->registration_id != 0)
+		g_dbus_connection_unregister_object (transaction->mock->connection,
+						     transaction->registration_id);
+	g_strfreev (transaction->values);
+	g_timer_destroy (transaction->timer);
+	g_free (transaction->object_path);
+	g_free (transaction);
+}
+
+static gchar *
+gpk_mock_package_id (guint i, gboolean update)
+{
+	if (update)
+		return g_strdup_printf ("mock-%06u;2.0.%u-1;x86_64;mock-updates", i, i % 10);
+	return g_strdup_printf ("mock-%06u;1.0.%u-1;x86_64;%s", i, i % 10,
+				i % 5 == 0 ? "installed" : "mock");
+}
+
+static gboolean
+gpk_mock_package_installed (GpkMockDaemon *mock, guint i)
+{
+	return mock->scenario.installed_ratio > 0 &&
+	       i % mock->scenario.installed_ratio == 0;
+}
+
+static void
+gpk_mock_emit (GpkMockTransaction *transaction, const gchar *name, GVariant *parameters)
+{
+	g_autoptr(GError) error = NULL;
+	if (!g_dbus_connection_emit_signal (transaction->mock->connection, NULL,
+					    transaction->object_path,
+					    PK_DBUS_INTERFACE_TRANSACTION,
+					    name, parameters, &error))
+		g_warning ("failed to emit %s: %s", name, error->message);
+}
+
+static void
+gpk_mock_emit_property (GpkMockTransaction *transaction, const gchar *name, GVariant *value)
+{
+	GVariantBuilder builder;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
+	g_variant_builder_add (&builder, "{sv}", name, value);
+	g_dbus_connection_emit_signal (transaction->mock->connection, NULL,
+				       transaction->object_path,
+				       "org.freedesktop.DBus.Properties",
+				       "PropertiesChanged",
+				       g_variant_new ("(sa{sv}as)",
+						      PK_DBUS_INTERFACE_TRANSACTION,
+						      &builder, NULL),
+				       NULL);
+}
+
+static void
+gpk_mock_set_status (GpkMockTransaction *transaction, PkStatusEnum status)
+{
+	if (transaction->status == status)
+		return;
+	transaction->status = status;
+	gpk_mock_emit_property (transaction, "Status", g_variant_new_uint32 (status));
+}
+
+static void
+gpk_mock_set_percentage (GpkMockTransaction *transaction, guint percentage)
+{
+	if (transaction->percentage == percentage)
+		return;
+	transaction->percentage = percentage;
+	gpk_mock_emit_property (transaction, "Percentage", g_variant_new_uint32 (percentage));
+}
+
+static void
+gpk_mock_emit_transaction_list (GpkMockDaemon *mock)
+{
+	GHashTableIter iter;
+	GPtrArray *array;
+	GpkMockTransaction *transaction;
+
+	array = g_ptr_array_new ();
+	g_hash_table_iter_init (&iter, mock->transactions);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &transaction)) {
+		if (!transaction->finished)
+			g_ptr_array_add (array, transaction->object_path);
+	}
+	g_ptr_array_add (array, NULL);
+	g_dbus_connection_emit_signal (mock->connection, NULL, PK_DBUS_PATH,
+				       PK_DBUS_INTERFACE, "TransactionListChanged",
+				       g_variant_new ("(^as)", (gchar **) array->pdata),
+				       NULL);
+	g_ptr_array_unref (array);
+}
+
+static gboolean
+gpk_mock_transaction_remove_cb (gpointer user_data)
+{
+	GpkMockTransaction *transaction = (GpkMockTransaction *) user_data;
+	transaction->source_id = 0;
+	g_hash_table_remove (transaction->mock->transactions, transaction->object_path);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+gpk_mock_transaction_finish (GpkMockTransaction *transaction, PkExitEnum exit_enum)
+{
+	guint runtime = g_timer_elapsed (transaction->timer, NULL) * 1000;
+
+	if (transaction->source_id != 0) {
+		g_source_remove (transaction->source_id);
+		transaction->source_id = 0;
+	}
+	transaction->finished = TRUE;
+	gpk_mock_set_percentage (transaction, 100);
+	gpk_mock_set_status (transaction, PK_STATUS_ENUM_FINISHED);
+	gpk_mock_emit (transaction, "Finished", g_variant_new ("(uu)", exit_enum, runtime));
+	gpk_mock_emit (transaction, "Destroy", NULL);
+	gpk_mock_emit_transaction_list (transaction->mock);
+
+	/* give clients time to read the properties one last time */
+	transaction->source_id = g_timeout_add_seconds (5, gpk_mock_transaction_remove_cb, transaction);
+	g_source_set_name_by_id (transaction->source_id, "[GpkMockDaemon] remove");
+}
+
+static void
+gpk_mock_transaction_error (GpkMockTransaction *transaction, PkErrorEnum code, const gchar *details)
+{
+	gpk_mock_emit (transaction, "ErrorCode", g_variant_new ("(us)", code, details));
+	gpk_mock_transaction_finish (transaction, PK_EXIT_ENUM_FAILED);
+}
+
+static gboolean
+gpk_mock_package_filtered (GpkMockTransaction *transaction, guint i)
+{
+	gboolean installed = gpk_mock_package_installed (transaction->mock, i);
+
+	if (pk_bitfield_contain (transaction->filters, PK_FILTER_ENUM_INSTALLED) && !installed)
+		return TRUE;
+	if (pk_bitfield_contain (transaction->filters, PK_FILTER_ENUM_NOT_INSTALLED) && installed)
+		return TRUE;
+	return FALSE;
+}
+
+static gboolean
+gpk_mock_package_matches (GpkMockTransaction *transaction, const gchar *package_id, const gchar *summary)
+{
+	guint i;
+
+	if (transaction->values == NULL)
+		return TRUE;
+	for (i = 0; transaction->values[i] != NULL; i++) {
+		if (strstr (package_id, transaction->values[i]) != NULL)
+			return TRUE;
+		if (transaction->role == PK_ROLE_ENUM_SEARCH_DETAILS &&
+		    strstr (summary, transaction->values[i]) != NULL)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* emits result number @idx, the meaning of which depends on the role */
+static void
+gpk_mock_transaction_emit_item (GpkMockTransaction *transaction, guint idx)
+{
+	GpkMockScenario *scenario = &transaction->mock->scenario;
+
+	switch (transaction->role) {
+	case PK_ROLE_ENUM_GET_PACKAGES:
+	case PK_ROLE_ENUM_RESOLVE:
+	case PK_ROLE_ENUM_SEARCH_NAME:
+	case PK_ROLE_ENUM_SEARCH_DETAILS:
+	case PK_ROLE_ENUM_SEARCH_FILE:
+	case PK_ROLE_ENUM_SEARCH_GROUP:
+	case PK_ROLE_ENUM_WHAT_PROVIDES:
+	{
+		g_autofree gchar *package_id = gpk_mock_package_id (idx, FALSE);
+		g_autofree gchar *summary = g_strdup_printf ("Mock package number %u", idx);
+		gboolean installed = gpk_mock_package_installed (transaction->mock, idx);
+
+		if (gpk_mock_package_filtered (transaction, idx))
+			break;
+		if (transaction->role != PK_ROLE_ENUM_GET_PACKAGES &&
+		    transaction->role != PK_ROLE_ENUM_SEARCH_GROUP &&
+		    !gpk_mock_package_matches (transaction, package_id, summary))
+			break;
+		gpk_mock_emit (transaction, "Package",
+			       g_variant_new ("(uss)",
+					      installed ? PK_INFO_ENUM_INSTALLED : PK_INFO_ENUM_AVAILABLE,
+					      package_id, summary));
+		break;
+	}
+	case PK_ROLE_ENUM_GET_UPDATES:
+	{
+		static const PkInfoEnum kinds[] = { PK_INFO_ENUM_SECURITY,
+						    PK_INFO_ENUM_BUGFIX,
+						    PK_INFO_ENUM_ENHANCEMENT,
+						    PK_INFO_ENUM_NORMAL };
+		g_autofree gchar *package_id = gpk_mock_package_id (idx, TRUE);
+		g_autofree gchar *summary = g_strdup_printf ("Mock update number %u", idx);
+
+		gpk_mock_emit (transaction, "Package",
+			       g_variant_new ("(uss)", kinds[idx % G_N_ELEMENTS (kinds)],
+					      package_id, summary));
+		break;
+	}
+	case PK_ROLE_ENUM_DEPENDS_ON:
+	case PK_ROLE_ENUM_REQUIRED_BY:
+	{
+		g_autofree gchar *package_id = gpk_mock_package_id (idx * 7 + 1, FALSE);
+		g_autofree gchar *summary = g_strdup_printf ("Mock dependency number %u", idx);
+
+		gpk_mock_emit (transaction, "Package",
+			       g_variant_new ("(uss)", PK_INFO_ENUM_AVAILABLE, package_id, summary));
+		break;
+	}
+	case PK_ROLE_ENUM_INSTALL_PACKAGES:
+	case PK_ROLE_ENUM_UPDATE_PACKAGES:
+	case PK_ROLE_ENUM_REMOVE_PACKAGES:
+	case PK_ROLE_ENUM_DOWNLOAD_PACKAGES:
+	{
+		/* per package: Package(downloading), steps of download progress,
+		 * Package(action), steps of action progress, Package(finished) */
+		guint per = scenario->progress_steps * 2 + 3;
+		guint sub = idx % per;
+		const gchar *package_id = transaction->values[idx / per];
+		PkInfoEnum info = PK_INFO_ENUM_UPDATING;
+		PkStatusEnum status = PK_STATUS_ENUM_UPDATE;
+
+		if (transaction->role == PK_ROLE_ENUM_INSTALL_PACKAGES) {
+			info = PK_INFO_ENUM_INSTALLING;
+			status = PK_STATUS_ENUM_INSTALL;
+		} else if (transaction->role == PK_ROLE_ENUM_REMOVE_PACKAGES) {
+			info = PK_INFO_ENUM_REMOVING;
+			status = PK_STATUS_ENUM_REMOVE;
+		}
+		if (sub == 0) {
+			gpk_mock_set_status (transaction, PK_STATUS_ENUM_DOWNLOAD);
+			gpk_mock_emit (transaction, "Package",
+				       g_variant_new ("(uss)", PK_INFO_ENUM_DOWNLOADING, package_id, ""));
+		} else if (sub <= scenario->progress_steps) {
+			gpk_mock_emit (transaction, "ItemProgress",
+				       g_variant_new ("(suu)", package_id, PK_STATUS_ENUM_DOWNLOAD,
+						      sub * 100 / scenario->progress_steps));
+		} else if (sub == scenario->progress_steps + 1) {
+			gpk_mock_set_status (transaction, status);
+			gpk_mock_emit (transaction, "Package",
+				       g_variant_new ("(uss)", info, package_id, ""));
+		} else if (sub < per - 1) {
+			gpk_mock_emit (transaction, "ItemProgress",
+				       g_variant_new ("(suu)", package_id, status,
+						      (sub - scenario->progress_steps - 1) * 100 /
+						      scenario->progress_steps));
+		} else {
+			gpk_mock_emit (transaction, "Package",
+				       g_variant_new ("(uss)", PK_INFO_ENUM_FINISHED, package_id, ""));
+		}
+		break;
+	}
+	case PK_ROLE_ENUM_GET_OLD_TRANSACTIONS:
+	{
+		g_autoptr(GDateTime) now = g_date_time_new_now_utc ();
+		g_autoptr(GDateTime) date = g_date_time_add_hours (now, -(gint) idx);
+		g_autofree gchar *tid = g_strdup_printf ("/%u_mockhist", idx);
+		g_autofree gchar *timespec = g_date_time_format_iso8601 (date);
+		g_autoptr(GString) data = g_string_new (NULL);
+		guint j;
+
+		for (j = 0; j < scenario->history_packages; j++) {
+			g_autofree gchar *package_id = gpk_mock_package_id (idx + j, TRUE);
+			g_string_append_printf (data, "%s\t%s\n",
+						pk_info_enum_to_string (PK_INFO_ENUM_UPDATING),
+						package_id);
+		}
+		if (data->len > 0)
+			g_string_truncate (data, data->len - 1);
+		gpk_mock_emit (transaction, "Transaction",
+			       g_variant_new ("(osbuusus)", tid, timespec, TRUE,
+					      PK_ROLE_ENUM_UPDATE_PACKAGES, 1000 + idx % 60000,
+					      data->str, 1000, "/usr/bin/gpk-update-viewer"));
+		break;
+	}
+	case PK_ROLE_ENUM_GET_DETAILS:
+	{
+		GVariantBuilder builder;
+		const gchar *package_id = transaction->values[idx];
+
+		g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+		g_variant_builder_add (&builder, "{sv}", "package-id", g_variant_new_string (package_id));
+		g_variant_builder_add (&builder, "{sv}", "summary", g_variant_new_string ("Mock package"));
+		g_variant_builder_add (&builder, "{sv}", "description",
+				       g_variant_new_string ("A package served by the mock daemon."));
+		g_variant_builder_add (&builder, "{sv}", "license", g_variant_new_string ("GPL-2.0+"));
+		g_variant_builder_add (&builder, "{sv}", "group", g_variant_new_uint32 (PK_GROUP_ENUM_SYSTEM));
+		g_variant_builder_add (&builder, "{sv}", "url", g_variant_new_string ("https://example.com/"));
+		g_variant_builder_add (&builder, "{sv}", "size", g_variant_new_uint64 (1024 * 1024));
+		gpk_mock_emit (transaction, "Details", g_variant_new ("(a{sv})", &builder));
+		break;
+	}
+	case PK_ROLE_ENUM_GET_UPDATE_DETAIL:
+	{
+		const gchar *empty[] = { NULL };
+		const gchar *package_id = transaction->values[idx];
+		g_autofree gchar *updates = g_strdup (package_id);
+		const gchar *updates_strv[] = { updates, NULL };
+
+		gpk_mock_emit (transaction, "UpdateDetail",
+			       g_variant_new ("(s^as^as^as^as^asusssuss)",
+					      package_id, updates_strv, empty, empty,
+					      empty, empty, PK_RESTART_ENUM_NONE,
+					      "This update fixes a mock problem.",
+					      "* Mock changelog entry", PK_UPDATE_STATE_ENUM_STABLE,
+					      "2023-01-01T00:00:00Z", "2023-01-02T00:00:00Z"));
+		break;
+	}
+	case PK_ROLE_ENUM_GET_FILES:
+	{
+		const gchar *package_id = transaction->values[idx];
+		g_auto(GStrv) split = pk_package_id_split (package_id);
+		g_autofree gchar *bin = NULL;
+		g_autofree gchar *doc = NULL;
+		const gchar *files[] = { NULL, NULL, NULL };
+
+		if (split == NULL)
+			break;
+		bin = g_strdup_printf ("/usr/bin/%s", split[PK_PACKAGE_ID_NAME]);
+		doc = g_strdup_printf ("/usr/share/doc/%s/README", split[PK_PACKAGE_ID_NAME]);
+		files[0] = bin;
+		files[1] = doc;
+		gpk_mock_emit (transaction, "Files", g_variant_new ("(s^as)", package_id, files));
+		break;
+	}
+	case PK_ROLE_ENUM_GET_REPO_LIST:
+	{
+		g_autofree gchar *repo_id = g_strdup_printf ("mock-repo-%u", idx);
+		g_autofree gchar *description = g_strdup_printf ("Mock repository %u", idx);
+
+		gpk_mock_emit (transaction, "RepoDetail",
+			       g_variant_new ("(ssb)", repo_id, description, idx % 3 != 2));
+		break;
+	}
+	case PK_ROLE_ENUM_GET_CATEGORIES:
+	{
+		g_autofree gchar *cat_id = g_strdup_printf ("mock-cat-%u", idx);
+		g_autofree gchar *parent_id = idx < 4 ? g_strdup ("") :
+					      g_strdup_printf ("mock-cat-%u", (idx - 4) / 4);
+
+		gpk_mock_emit (transaction, "Category",
+			       g_variant_new ("(sssss)", parent_id, cat_id, cat_id,
+					      "Mock category", "applications-other"));
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static gboolean
+gpk_mock_transaction_run_cb (gpointer user_data)
+{
+	GpkMockTransaction *transaction = (GpkMockTransaction *) user_data;
+	GpkMockScenario *scenario = &transaction->mock->scenario;
+	guint i;
+
+	gpk_mock_set_status (transaction, PK_STATUS_ENUM_RUNNING);
+	for (i = 0; i < scenario->batch && transaction->idx < transaction->total; i++)
+		gpk_mock_transaction_emit_item (transaction, transaction->idx++);
+	if (transaction->total > 0)
+		gpk_mock_set_percentage (transaction, transaction->idx * 100 / transaction->total);
+
+	/* return to the main loop between batches so clients are serviced */
+	if (transaction->idx < transaction->total)
+		return G_SOURCE_CONTINUE;
+	transaction->source_id = 0;
+	gpk_mock_transaction_finish (transaction, PK_EXIT_ENUM_SUCCESS);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gpk_mock_transaction_start_cb (gpointer user_data)
+{
+	GpkMockTransaction *transaction = (GpkMockTransaction *) user_data;
+	GpkMockScenario *scenario = &transaction->mock->scenario;
+
+	if (scenario->interval > 0)
+		transaction->source_id = g_timeout_add (scenario->interval,
+							gpk_mock_transaction_run_cb,
+							transaction);
+	else
+		transaction->source_id = g_idle_add (gpk_mock_transaction_run_cb, transaction);
+	g_source_set_name_by_id (transaction->source_id, "[GpkMockDaemon] run");
+	return G_SOURCE_REMOVE;
+}
+
+static void
+gpk_mock_transaction_start (GpkMockTransaction *transaction, PkRoleEnum role, guint total)
+{
+	transaction->role = role;
+	transaction->total = total;
+	gpk_mock_emit_property (transaction, "Role", g_variant_new_uint32 (role));
+	gpk_mock_set_status (transaction, PK_STATUS_ENUM_WAIT);
+	gpk_mock_emit_transaction_list (transaction->mock);
+
+	/* pretend to be a slow backend */
+	transaction->source_id = g_timeout_add (transaction->mock->scenario.latency,
+						gpk_mock_transaction_start_cb,
+						transaction);
+	g_source_set_name_by_id (transaction->source_id, "[GpkMockDaemon] latency");
+}
+
+static void
+gpk_mock_transaction_method_call (GDBusConnection *connection,
+				  const gchar *sender,
+				  const gchar *object_path,
+				  const gchar *interface_name,
+				  const gchar *method_name,
+				  GVariant *parameters,
+				  GDBusMethodInvocation *invocation,
+				  gpointer user_data)
+{
+	GpkMockTransaction *transaction = (GpkMockTransaction *) user_data;
+	GpkMockScenario *scenario = &transaction->mock->scenario;
+	PkRoleEnum role;
+	guint n_values = 0;
+	guint total = 0;
+	g_autofree gchar *role_name = NULL;
+
+	if (g_strcmp0 (method_name, "SetHints") == 0) {
+		g_dbus_method_invocation_return_value (invocation, NULL);
+		return;
+	}
+	if (g_strcmp0 (method_name, "Cancel") == 0) {
+		g_dbus_method_invocation_return_value (invocation, NULL);
+		if (!transaction->finished) {
+			gpk_mock_emit (transaction, "ErrorCode",
+				       g_variant_new ("(us)", PK_ERROR_ENUM_TRANSACTION_CANCELLED,
+						      "cancelled by the client"));
+			gpk_mock_transaction_finish (transaction, PK_EXIT_ENUM_CANCELLED);
+		}
+		return;
+	}
+
+	/* only one action per transaction */
+	if (transaction->role != PK_ROLE_ENUM_UNKNOWN) {
+		g_dbus_method_invocation_return_dbus_error (invocation,
+							    PK_DBUS_INTERFACE_TRANSACTION ".Error.RoleUnknown",
+							    "transaction already in use");
+		return;
+	}
+	g_dbus_method_invocation_return_value (invocation, NULL);
+
+	/* "GetPackages" -> "get-packages", apart from the singular searches */
+	if (g_strcmp0 (method_name, "SearchNames") == 0)
+		role = PK_ROLE_ENUM_SEARCH_NAME;
+	else if (g_strcmp0 (method_name, "SearchFiles") == 0)
+		role = PK_ROLE_ENUM_SEARCH_FILE;
+	else if (g_strcmp0 (method_name, "SearchGroups") == 0)
+		role = PK_ROLE_ENUM_SEARCH_GROUP;
+	else {
+		GString *str = g_string_new (NULL);
+		const gchar *tmp;
+		for (tmp = method_name; *tmp != '\0'; tmp++) {
+			if (g_ascii_isupper (*tmp) && tmp != method_name)
+				g_string_append_c (str, '-');
+			g_string_append_c (str, g_ascii_tolower (*tmp));
+		}
+		role_name = g_string_free (str, FALSE);
+		role = pk_role_enum_from_string (role_name);
+	}
+
+	/* unpack the arguments we care about */
+	if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(t)"))) {
+		g_variant_get (parameters, "(t)", &transaction->filters);
+	} else if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(tas)"))) {
+		g_variant_get (parameters, "(t^as)", &transaction->filters, &transaction->values);
+	} else if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(tasb)")) ||
+		   g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(tasbb)"))) {
+		g_variant_get_child (parameters, 0, "t", &transaction->filters);
+		g_variant_get_child (parameters, 1, "^as", &transaction->values);
+	} else if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(as)"))) {
+		g_variant_get (parameters, "(^as)", &transaction->values);
+	} else if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(bas)"))) {
+		g_variant_get_child (parameters, 1, "^as", &transaction->values);
+	} else if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(u)"))) {
+		g_variant_get (parameters, "(u)", &transaction->number);
+	}
+
+	if (transaction->values != NULL)
+		n_values = g_strv_length (transaction->values);
+
+	switch (role) {
+	case PK_ROLE_ENUM_GET_PACKAGES:
+	case PK_ROLE_ENUM_RESOLVE:
+	case PK_ROLE_ENUM_SEARCH_NAME:
+	case PK_ROLE_ENUM_SEARCH_DETAILS:
+	case PK_ROLE_ENUM_SEARCH_FILE:
+	case PK_ROLE_ENUM_SEARCH_GROUP:
+	case PK_ROLE_ENUM_WHAT_PROVIDES:
+		total = scenario->packages;
+		break;
+	case PK_ROLE_ENUM_GET_UPDATES:
+		total = scenario->updates;
+		break;
+	case PK_ROLE_ENUM_DEPENDS_ON:
+	case PK_ROLE_ENUM_REQUIRED_BY:
+		total = 3;
+		break;
+	case PK_ROLE_ENUM_INSTALL_PACKAGES:
+	case PK_ROLE_ENUM_UPDATE_PACKAGES:
+	case PK_ROLE_ENUM_REMOVE_PACKAGES:
+	case PK_ROLE_ENUM_DOWNLOAD_PACKAGES:
+		total = n_values * (scenario->progress_steps * 2 + 3);
+		break;
+	case PK_ROLE_ENUM_GET_OLD_TRANSACTIONS:
+		total = scenario->history;
+		if (transaction->number > 0 && transaction->number < total)
+			total = transaction->number;
+		break;
+	case PK_ROLE_ENUM_GET_DETAILS:
+	case PK_ROLE_ENUM_GET_UPDATE_DETAIL:
+	case PK_ROLE_ENUM_GET_FILES:
+		total = n_values;
+		break;
+	case PK_ROLE_ENUM_GET_REPO_LIST:
+		total = 6;
+		break;
+	case PK_ROLE_ENUM_GET_CATEGORIES:
+		total = 84;
+		break;
+	case PK_ROLE_ENUM_REFRESH_CACHE:
+	case PK_ROLE_ENUM_REPO_ENABLE:
+	case PK_ROLE_ENUM_GET_DISTRO_UPGRADES:
+	case PK_ROLE_ENUM_ACCEPT_EULA:
+		break;
+	default:
+		transaction->role = role;
+		gpk_mock_transaction_error (transaction, PK_ERROR_ENUM_NOT_SUPPORTED, method_name);
+		return;
+	}
+	g_debug ("%s: %s with %u results", object_path, method_name, total);
+	gpk_mock_transaction_start (transaction, role, total);
+}
+
+static GVariant *
+gpk_mock_transaction_get_property (GDBusConnection *connection,
+				   const gchar *sender,
+				   const gchar *object_path,
+				   const gchar *interface_name,
+				   const gchar *property_name,
+				   GError **error,
+				   gpointer user_data)
+{
+	GpkMockTransaction *transaction = (GpkMockTransaction *) user_data;
+
+	if (g_strcmp0 (property_name, "Role") == 0)
+		return g_variant_new_uint32 (transaction->role);
+	if (g_strcmp0 (property_name, "Status") == 0)
+		return g_variant_new_uint32 (transaction->status);
+	if (g_strcmp0 (property_name, "Percentage") == 0)
+		return g_variant_new_uint32 (transaction->percentage);
+	if (g_strcmp0 (property_name, "LastPackage") == 0)
+		return g_variant_new_string ("");
+	if (g_strcmp0 (property_name, "AllowCancel") == 0)
+		return g_variant_new_boolean (!transaction->finished);
+	if (g_strcmp0 (property_name, "CallerActive") == 0)
+		return g_variant_new_boolean (TRUE);
+	if (g_strcmp0 (property_name, "ElapsedTime") == 0)
+		return g_variant_new_uint32 (g_timer_elapsed (transaction->timer, NULL));
+	if (g_strcmp0 (property_name, "DownloadSizeRemaining") == 0 ||
+	    g_strcmp0 (property_name, "TransactionFlags") == 0)
+		return g_variant_new_uint64 (0);
+	if (g_strcmp0 (property_name, "Uid") == 0)
+		return g_variant_new_uint32 (1000);
+	return g_variant_new_uint32 (0);
+}
+
+static const GDBusInterfaceVTable transaction_vtable = {
+	gpk_mock_transaction_method_call,
+	gpk_mock_transaction_get_property,
+	NULL
+};
+
+static PkBitfield
+gpk_mock_get_roles (void)
+{
+	PkBitfield roles = 0;
+	guint i;
+	for (i = PK_ROLE_ENUM_UNKNOWN + 1; i < PK_ROLE_ENUM_LAST; i++)
+		pk_bitfield_add (roles, i);
+	return roles;
+}
+
+static void
+gpk_mock_daemon_method_call (GDBusConnection *connection,
+			     const gchar *sender,
+			     const gchar *object_path,
+			     const gchar *interface_name,
+			     const gchar *method_name,
+			     GVariant *parameters,
+			     GDBusMethodInvocation *invocation,
+			     gpointer user_data)
+{
+	GpkMockDaemon *mock = (GpkMockDaemon *) user_data;
+
+	if (g_strcmp0 (method_name, "CreateTransaction") == 0) {
+		GpkMockTransaction *transaction;
+		GDBusInterfaceInfo *info;
+		g_autoptr(GError) error = NULL;
+
+		transaction = g_new0 (GpkMockTransaction, 1);
+		transaction->mock = mock;
+		transaction->timer = g_timer_new ();
+		transaction->object_path = g_strdup_printf ("%s/%u",
+							    GPK_MOCK_DBUS_PATH_TRANSACTION,
+							    ++mock->tid_next);
+		info = g_dbus_node_info_lookup_interface (mock->introspection,
+							  PK_DBUS_INTERFACE_TRANSACTION);
+		transaction->registration_id =
+			g_dbus_connection_register_object (connection,
+							   transaction->object_path,
+							   info,
+							   &transaction_vtable,
+							   transaction,
+							   NULL,
+							   &error);
+		if (transaction->registration_id == 0) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			gpk_mock_transaction_free (transaction);
+			return;
+		}
+		g_hash_table_insert (mock->transactions, transaction->object_path, transaction);
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new ("(o)", transaction->object_path));
+		return;
+	}
+	if (g_strcmp0 (method_name, "GetTimeSinceAction") == 0) {
+		g_dbus_method_invocation_return_value (invocation, g_variant_new ("(u)", 60));
+		return;
+	}
+	if (g_strcmp0 (method_name, "GetDaemonState") == 0) {
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new ("(s)", "mock daemon"));
+		return;
+	}
+	if (g_strcmp0 (method_name, "CanAuthorize") == 0) {
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new ("(u)", PK_AUTHORIZE_ENUM_YES));
+		return;
+	}
+	if (g_strcmp0 (method_name, "GetTransactionList") == 0) {
+		GVariantBuilder builder;
+		GHashTableIter iter;
+		GpkMockTransaction *transaction;
+
+		g_variant_builder_init (&builder, G_VARIANT_TYPE ("ao"));
+		g_hash_table_iter_init (&iter, mock->transactions);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &transaction)) {
+			if (!transaction->finished)
+				g_variant_builder_add (&builder, "o", transaction->object_path);
+		}
+		g_dbus_method_invocation_return_value (invocation, g_variant_new ("(ao)", &builder));
+		return;
+	}
+
+	/* StateHasChanged, SuggestDaemonQuit, SetProxy */
+	g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+static GVariant *
+gpk_mock_daemon_get_property (GDBusConnection *connection,
+			      const gchar *sender,
+			      const gchar *object_path,
+			      const gchar *interface_name,
+			      const gchar *property_name,
+			      GError **error,
+			      gpointer user_data)
+{
+	if (g_strcmp0 (property_name, "VersionMajor") == 0)
+		return g_variant_new_uint32 (PK_MAJOR_VERSION);
+	if (g_strcmp0 (property_name, "VersionMinor") == 0)
+		return g_variant_new_uint32 (PK_MINOR_VERSION);
+	if (g_strcmp0 (property_name, "VersionMicro") == 0)
+		return g_variant_new_uint32 (PK_MICRO_VERSION);
+	if (g_strcmp0 (property_name, "BackendName") == 0)
+		return g_variant_new_string ("mock");
+	if (g_strcmp0 (property_name, "BackendDescription") == 0)
+		return g_variant_new_string ("Scripted scenarios for load testing");
+	if (g_strcmp0 (property_name, "BackendAuthor") == 0)
+		return g_variant_new_string ("GNOME PackageKit");
+	if (g_strcmp0 (property_name, "Roles") == 0)
+		return g_variant_new_uint64 (gpk_mock_get_roles ());
+	if (g_strcmp0 (property_name, "Groups") == 0)
+		return g_variant_new_uint64 (pk_bitfield_from_enums (PK_GROUP_ENUM_SYSTEM,
+								     PK_GROUP_ENUM_GAMES,
+								     PK_GROUP_ENUM_OFFICE,
+								     PK_GROUP_ENUM_PROGRAMMING,
+								     -1));
+	if (g_strcmp0 (property_name, "Filters") == 0)
+		return g_variant_new_uint64 (pk_bitfield_from_enums (PK_FILTER_ENUM_INSTALLED,
+								     PK_FILTER_ENUM_NOT_INSTALLED,
+								     PK_FILTER_ENUM_NEWEST,
+								     PK_FILTER_ENUM_ARCH,
+								     -1));
+	if (g_strcmp0 (property_name, "MimeTypes") == 0)
+		return g_variant_new_strv (NULL, 0);
+	if (g_strcmp0 (property_name, "Locked") == 0)
+		return g_variant_new_boolean (FALSE);
+	if (g_strcmp0 (property_name, "NetworkState") == 0)
+		return g_variant_new_uint32 (PK_NETWORK_ENUM_ONLINE);
+	if (g_strcmp0 (property_name, "DistroId") == 0)
+		return g_variant_new_string ("mock;1;x86_64");
+	g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_PROPERTY,
+		     "unknown property %s", property_name);
+	return NULL;
+}
+
+static const GDBusInterfaceVTable daemon_vtable = {
+	gpk_mock_daemon_method_call,
+	gpk_mock_daemon_get_property,
+	NULL
+};
+
+static void
+gpk_mock_child_watch_cb (GPid pid, gint status, gpointer user_data)
+{
+	GpkMockDaemon *mock = (GpkMockDaemon *) user_data;
+	g_autoptr(GError) error = NULL;
+	gboolean ret;
+
+#if GLIB_CHECK_VERSION(2, 70, 0)
+	ret = g_spawn_check_wait_status (status, &error);
+#else
+	ret = g_spawn_check_exit_status (status, &error);
+#endif
+	if (!ret) {
+		g_warning ("%s", error->message);
+		mock->exit_status = EXIT_FAILURE;
+	}
+	g_spawn_close_pid (pid);
+	g_main_loop_quit (mock->loop);
+}
+
+static void
+gpk_mock_name_acquired_cb (GDBusConnection *connection, const gchar *name, gpointer user_data)
+{
+	GpkMockDaemon *mock = (GpkMockDaemon *) user_data;
+	GPid pid;
+	g_autofree gchar *address = NULL;
+	g_auto(GStrv) envp = NULL;
+	g_autoptr(GError) error = NULL;
+
+	g_debug ("acquired %s", name);
+	if (mock->command == NULL)
+		return;
+
+	/* the client libraries talk to the system bus */
+	address = g_dbus_address_get_for_bus_sync (G_BUS_TYPE_SESSION, NULL, &error);
+	if (address == NULL) {
+		g_warning ("failed to get bus address: %s", error->message);
+		mock->exit_status = EXIT_FAILURE;
+		g_main_loop_quit (mock->loop);
+		return;
+	}
+	envp = g_get_environ ();
+	envp = g_environ_setenv (envp, "DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+	if (!g_spawn_async (NULL, mock->command, envp,
+			    G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
+			    NULL, NULL, &pid, &error)) {
+		g_warning ("failed to run %s: %s", mock->command[0], error->message);
+		mock->exit_status = EXIT_FAILURE;
+		g_main_loop_quit (mock->loop);
+		return;
+	}
+	g_child_watch_add (pid, gpk_mock_child_watch_cb, mock);
+}
+
+static void
+gpk_mock_name_lost_cb (GDBusConnection *connection, const gchar *name, gpointer user_data)
+{
+	GpkMockDaemon *mock = (GpkMockDaemon *) user_data;
+	g_warning ("lost or could not acquire %s", name);
+	mock->exit_status = EXIT_FAILURE;
+	g_main_loop_quit (mock->loop);
+}
+
+static guint
+gpk_mock_scenario_get (GKeyFile *keyfile, const gchar *group, const gchar *key, guint value)
+{
+	g_autoptr(GError) error = NULL;
+	gint tmp;
+
+	if (keyfile == NULL)
+		return value;
+	tmp = g_key_file_get_integer (keyfile, group, key, &error);
+	if (error != NULL)
+		return value;
+	return MAX (tmp, 0);
+}
+
+static gboolean
+gpk_mock_scenario_load (GpkMockScenario *scenario, const gchar *filename, GError **error)
+{
+	g_autoptr(GKeyFile) keyfile = NULL;
+
+	if (filename != NULL) {
+		keyfile = g_key_file_new ();
+		if (!g_key_file_load_from_file (keyfile, filename, G_KEY_FILE_NONE, error))
+			return FALSE;
+	}
+	scenario->latency = gpk_mock_scenario_get (keyfile, "daemon", "latency", 0);
+	scenario->batch = MAX (gpk_mock_scenario_get (keyfile, "daemon", "batch", 500), 1);
+	scenario->interval = gpk_mock_scenario_get (keyfile, "daemon", "interval", 0);
+	scenario->packages = gpk_mock_scenario_get (keyfile, "packages", "count", 1000);
+	scenario->installed_ratio = gpk_mock_scenario_get (keyfile, "packages", "installed-ratio", 5);
+	scenario->updates = gpk_mock_scenario_get (keyfile, "updates", "count", 50);
+	scenario->progress_steps = MAX (gpk_mock_scenario_get (keyfile, "updates", "progress-steps", 5), 1);
+	scenario->history = gpk_mock_scenario_get (keyfile, "history", "count", 100);
+	scenario->history_packages = gpk_mock_scenario_get (keyfile, "history", "packages", 5);
+	return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+	GpkMockDaemon mock = { 0 };
+	gboolean verbose = FALSE;
+	guint owner_id;
+	guint registration_id;
+	g_autofree gchar *scenario = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GOptionContext) context = NULL;
+
+	const GOptionEntry options[] = {
+		{ "scenario", 's', 0, G_OPTION_ARG_FILENAME, &scenario,
+		  "Scenario file describing the data to serve", "FILE" },
+		{ "verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose,
+		  "Show extra debugging information", NULL },
+		{ G_OPTION_REMAINING, '\0', 0, G_OPTION_ARG_STRING_ARRAY, &mock.command,
+		  "Command to run against the daemon", "-- COMMAND" },
+		{ NULL}
+	};
+
+	context = g_option_context_new (NULL);
+	g_option_context_set_summary (context, "Mock PackageKit daemon for load testing");
+	g_option_context_add_main_entries (context, options, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	if (verbose)
+		g_setenv ("G_MESSAGES_DEBUG", "all", FALSE);
+	if (!gpk_mock_scenario_load (&mock.scenario, scenario, &error)) {
+		g_printerr ("failed to load %s: %s\n", scenario, error->message);
+		return EXIT_FAILURE;
+	}
+
+	/* never touch the real system bus */
+	mock.connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+	if (mock.connection == NULL) {
+		g_printerr ("failed to connect to the session bus: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	mock.introspection = g_dbus_node_info_new_for_xml (introspection_xml, &error);
+	g_assert_no_error (error);
+	mock.transactions = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+						   (GDestroyNotify) gpk_mock_transaction_free);
+	registration_id = g_dbus_connection_register_object (mock.connection,
+							     PK_DBUS_PATH,
+							     g_dbus_node_info_lookup_interface (mock.introspection,
+												PK_DBUS_INTERFACE),
+							     &daemon_vtable,
+							     &mock,
+							     NULL,
+							     &error);
+	if (registration_id == 0) {
+		g_printerr ("failed to register: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+
+	mock.loop = g_main_loop_new (NULL, FALSE);
+	owner_id = g_bus_own_name_on_connection (mock.connection,
+						 PK_DBUS_SERVICE,
+						 G_BUS_NAME_OWNER_FLAGS_NONE,
+						 gpk_mock_name_acquired_cb,
+						 gpk_mock_name_lost_cb,
+						 &mock,
+						 NULL);
+	g_main_loop_run (mock.loop);
+
+	g_bus_unown_name (owner_id);
+	g_hash_table_unref (mock.transactions);
+	g_dbus_connection_unregister_object (mock.connection, registration_id);
+	g_dbus_node_info_unref (mock.introspection);
+	g_main_loop_unref (mock.loop);
+	g_object_unref (mock.connection);
+	g_strfreev (mock.command);
+	return mock.exit_status;
+}